@@ -0,0 +1,121 @@
+/*
+ * anim.c
+ *
+ * Author: Sithika Mannakkara
+ */
+
+#include "anim.h"
+#include <stdint.h>
+#include <stddef.h>
+#include "display.h"
+#include "ledmatrix.h"
+#include "pixel_colour.h"
+
+// A running fade. The sprite is free when frames_left is 0.
+typedef struct
+{
+	uint8_t row;
+	uint8_t col;
+	PixelColour from;
+	PixelColour to;
+	uint8_t frames;
+	uint8_t frames_left;
+} Sprite;
+
+static Sprite sprites[ANIM_MAX_SPRITES];
+
+// Interpolates one 4 bit channel. The result moves from "from" to "to" as
+// done goes from 0 to total.
+static uint8_t mix_channel(uint8_t from, uint8_t to, uint8_t done,
+	uint8_t total)
+{
+	if (to >= from)
+	{
+		return from + (uint8_t)((to - from) * done / total);
+	}
+	return from - (uint8_t)((from - to) * done / total);
+}
+
+static PixelColour mix_colour(PixelColour from, PixelColour to,
+	uint8_t done, uint8_t total)
+{
+	uint8_t red = mix_channel(from & 0x0F, to & 0x0F, done, total);
+	uint8_t green = mix_channel(from >> 4, to >> 4, done, total);
+	return (green << 4) | red;
+}
+
+void anim_fade(uint8_t row, uint8_t col, PixelColour colour, uint8_t frames)
+{
+	Sprite *free_sprite = NULL;
+	for (uint8_t i = 0; i < ANIM_MAX_SPRITES; i++)
+	{
+		if (sprites[i].frames_left && sprites[i].row == row &&
+			sprites[i].col == col)
+		{
+			// Replace the fade already on this pixel.
+			free_sprite = &sprites[i];
+			break;
+		}
+		if (!sprites[i].frames_left && free_sprite == NULL)
+		{
+			free_sprite = &sprites[i];
+		}
+	}
+
+	if (free_sprite == NULL || frames <= 1)
+	{
+		if (free_sprite != NULL)
+		{
+			free_sprite->frames_left = 0;
+		}
+		display_set_pixel(row, col, colour);
+		return;
+	}
+
+	// The framebuffer holds the colour the pixel has reached.
+	free_sprite->row = row;
+	free_sprite->col = col;
+	free_sprite->from = display_get_pixel(row, col);
+	free_sprite->to = colour;
+	free_sprite->frames = frames;
+	free_sprite->frames_left = frames;
+}
+
+void anim_stop_all(void)
+{
+	for (uint8_t i = 0; i < ANIM_MAX_SPRITES; i++)
+	{
+		sprites[i].frames_left = 0;
+	}
+}
+
+void anim_shift(int8_t delta_row, int8_t delta_col)
+{
+	for (uint8_t i = 0; i < ANIM_MAX_SPRITES; i++)
+	{
+		Sprite *sprite = &sprites[i];
+		sprite->row += delta_row;
+		sprite->col += delta_col;
+		if (sprite->row >= MATRIX_NUM_ROWS ||
+			sprite->col >= MATRIX_NUM_COLUMNS)
+		{
+			sprite->frames_left = 0;
+		}
+	}
+}
+
+void anim_step(void)
+{
+	for (uint8_t i = 0; i < ANIM_MAX_SPRITES; i++)
+	{
+		Sprite *sprite = &sprites[i];
+		if (!sprite->frames_left)
+		{
+			continue;
+		}
+		sprite->frames_left--;
+		display_set_pixel(sprite->row, sprite->col,
+			mix_colour(sprite->from, sprite->to,
+			sprite->frames - sprite->frames_left, sprite->frames));
+	}
+}
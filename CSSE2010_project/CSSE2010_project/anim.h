@@ -0,0 +1,54 @@
+/*
+ * anim.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Colour fades on the LED matrix. Each fade is a sprite that moves one pixel
+ * of the display framebuffer from one colour to another over a few frames,
+ * interpolating the red and green channels separately. Sprites are stepped
+ * once per display frame (see display.h), and there are never more than
+ * ANIM_MAX_SPRITES of them, so the cost of a frame is bounded.
+ */
+
+#ifndef ANIM_H_
+#define ANIM_H_
+
+#include <stdint.h>
+#include "pixel_colour.h"
+
+// Number of fades that can run at once. If they are all in use, a new fade
+// just sets the pixel to its final colour.
+#define ANIM_MAX_SPRITES	(8)
+
+/// <summary>
+/// Fades a pixel from its current colour to a new one. A fade already running
+/// on the pixel is replaced, continuing from the colour it had reached.
+/// </summary>
+/// <param name="row">The row number of the pixel.</param>
+/// <param name="col">The column number of the pixel.</param>
+/// <param name="colour">The final colour of the pixel.</param>
+/// <param name="frames">The number of frames the fade takes (1 sets the
+/// colour on the next frame).</param>
+void anim_fade(uint8_t row, uint8_t col, PixelColour colour, uint8_t frames);
+
+/// <summary>
+/// Stops all fades, leaving the pixels at the colours they have reached.
+/// Used before redrawing the whole display.
+/// </summary>
+void anim_stop_all(void);
+
+/// <summary>
+/// Moves every fade along with a shift of the display framebuffer. Fades
+/// moved off the matrix are stopped.
+/// </summary>
+/// <param name="delta_row">Rows to move by (-1, 0 or 1).</param>
+/// <param name="delta_col">Columns to move by (-1, 0 or 1).</param>
+void anim_shift(int8_t delta_row, int8_t delta_col);
+
+/// <summary>
+/// Advances every fade by one frame. Called by the display task at the start
+/// of each frame.
+/// </summary>
+void anim_step(void);
+
+#endif /* ANIM_H_ */
@@ -9,44 +9,41 @@
 #include <stdbool.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include "timer0.h"
 
-// Global variable to keep track of the last button state so that we
-// can detect changes when an interrupt fires. The lower 4 bits (0 to 3)
-// will correspond to the last state of port B pins 0 to 3.
+// Global variables to keep track of the button state so that we can detect
+// changes when the buttons are sampled. The lower 4 bits (0 to 3) correspond
+// to port B pins 0 to 3. last_sample is the raw state in the previous
+// sample, last_button_state is the debounced state.
+static volatile uint8_t last_sample;
 static volatile uint8_t last_button_state;
+static SoftTimer sample_timer;
 
 // Our button queue. button_queue[0] is always the head of the queue. If we
 // take something off the queue we just move everything else along. We don't
 // use a circular buffer since it is usually expected that the queue is very
 // short. In most uses it will never have more than 1 element at a time.
-// This button queue can be changed by the interrupt handler below so we
+// This button queue can be changed by the timer callback below so we
 // should turn off interrupts if we're changing the queue outside the handler.
 #define BUTTON_QUEUE_SIZE 4
 static volatile uint8_t button_queue[BUTTON_QUEUE_SIZE];
 static volatile uint8_t queue_length;
 
+// Timer callback that samples the buttons.
+static void sample_buttons(void);
+
 void init_buttons(void)
 {
-	// Setup interrupt if any of pins B0 to B3 change. We do this
-	// using a pin change interrupt. These pins correspond to pin
-	// change interrupts PCINT8 to PCINT11 which are covered by
-	// pin change interrupt 1.
-
 	// Empty the button push queue and reset last state.
 	queue_length = 0;
+	last_sample = 0;
 	last_button_state = 0;
 
-	// Enable the interrupt (see datasheet page 77).
-	PCICR |= (1 << PCIE1);
-	
-	// Make sure the interrupt flag is cleared (by writing a 
-	// 1 to it) (see datasheet page 78).
-	PCIFR |= (1 << PCIF1);
-	
-	// Choose which pins we're interested in by setting
-	// the relevant bits in the mask register (see datasheet page 78).
-	PCMSK1 |= (1 << PCINT8) | (1 << PCINT9) | (1 << PCINT10) |
-		(1 << PCINT11);
+	// Sample pins B0 to B3 regularly. Bouncing contacts settle well
+	// within the sample period, so a button that reads the same twice in
+	// a row has stopped bouncing.
+	soft_timer_start(&sample_timer, BUTTON_SAMPLE_PERIOD,
+		BUTTON_SAMPLE_PERIOD, sample_buttons);
 }
 
 ButtonState button_pushed(void)
@@ -94,12 +91,16 @@ void clear_button_presses(void)
 	}
 }
 
-// Interrupt handler for a change on buttons.
-ISR(PCINT1_vect)
+static void sample_buttons(void)
 {
-	// Get the current state of the buttons. We'll compare this with
-	// the last state to see what has changed.
-	uint8_t button_state = PINB & 0x0F;
+	// Get the current state of the buttons. Only buttons that read the
+	// same as in the last sample are stable, and we'll compare those with
+	// the debounced state to see what has changed.
+	uint8_t sample = PINB & 0x0F;
+	uint8_t stable = ~(sample ^ last_sample);
+	uint8_t button_state = (last_button_state & ~stable) |
+		(sample & stable);
+	last_sample = sample;
 
 	// Iterate over all the buttons and see which ones have changed.
 	// Any button pushes are added to the queue of button pushes (if
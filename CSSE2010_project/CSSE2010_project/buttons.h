@@ -4,7 +4,8 @@
  * Author: Peter Sutton
  *
  * Functions and definitions for interacting with the push buttons. It is
- * assumed that buttons B0 - B3 are connected to pins B0 - B3.
+ * assumed that buttons B0 - B3 are connected to pins B0 - B3. The buttons
+ * are sampled by a timer 0 software timer and debounced in software.
  */ 
 
 #ifndef BUTTONS_H_
@@ -15,6 +16,10 @@
 // Number of buttons.
 #define NUM_BUTTONS 4
 
+// Time between samples of the buttons in milliseconds. A button has to read
+// the same in two samples in a row before a change is accepted.
+#define BUTTON_SAMPLE_PERIOD 5
+
 // Button states.
 typedef enum
 {
@@ -26,10 +31,10 @@ typedef enum
 } ButtonState;
 
 /// <summary>
-/// Sets up pin change interrupts on pins B0 to B3. It is assumed that
-/// global interrupts are off when this function is called and are enabled
-/// sometime after this function is called. This function should only be
-/// called once.
+/// Starts sampling pins B0 to B3. This function must be called after
+/// init_timer0(). It is assumed that global interrupts are off when this
+/// function is called and are enabled sometime after this function is
+/// called. This function should only be called once.
 /// </summary>
 void init_buttons(void);
 
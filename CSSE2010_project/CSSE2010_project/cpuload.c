@@ -0,0 +1,116 @@
+/*
+ * cpuload.c
+ *
+ * Author: Sithika Mannakkara
+ */
+
+#include "cpuload.h"
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "timer0.h"
+
+// Microseconds charged to each activity in the current window, and in the
+// last complete one.
+static uint32_t window_us[CPU_NUM_ACTIVITIES];
+static uint32_t last_window_us[CPU_NUM_ACTIVITIES];
+
+// What the main program is doing, and the timestamp from which its time has
+// not been charged yet. The gap between two charges is always under the
+// 65ms it takes timer 1 to wrap, since the timer 0 interrupt charges it
+// every millisecond.
+static volatile uint8_t activity;
+static volatile uint16_t last_charge;
+
+static SoftTimer window_timer;
+
+// Timer callback that ends the window.
+static void end_window(void)
+{
+	for (uint8_t i = 0; i < CPU_NUM_ACTIVITIES; i++)
+	{
+		last_window_us[i] = window_us[i];
+		window_us[i] = 0;
+	}
+}
+
+void init_cpuload(void)
+{
+	for (uint8_t i = 0; i < CPU_NUM_ACTIVITIES; i++)
+	{
+		window_us[i] = 0;
+		last_window_us[i] = 0;
+	}
+	activity = CPU_IDLE;
+
+	// Run timer 1 freely (normal mode) with the clock divided by 8, so it
+	// counts microseconds.
+	TCCR1A = 0;
+	TCCR1B = (1 << CS11);
+	TCNT1 = 0;
+	last_charge = 0;
+
+	soft_timer_start(&window_timer, CPULOAD_WINDOW, CPULOAD_WINDOW,
+		end_window);
+}
+
+CpuActivity cpuload_enter(CpuActivity new_activity)
+{
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	uint16_t now = TCNT1;
+	CpuActivity previous = activity;
+	window_us[previous] += (uint16_t)(now - last_charge);
+	last_charge = now;
+	activity = new_activity;
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+	return previous;
+}
+
+uint16_t cpuload_isr_enter(void)
+{
+	// Charge the main program for the time up to the interrupt.
+	uint16_t now = TCNT1;
+	window_us[activity] += (uint16_t)(now - last_charge);
+	return now;
+}
+
+void cpuload_isr_exit(uint16_t start)
+{
+	uint16_t now = TCNT1;
+	window_us[CPU_ISR] += (uint16_t)(now - start);
+	last_charge = now;
+}
+
+uint16_t cpuload_timestamp(void)
+{
+	return TCNT1;
+}
+
+void cpuload_get(CpuLoad *load)
+{
+	uint32_t us[CPU_NUM_ACTIVITIES];
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	for (uint8_t i = 0; i < CPU_NUM_ACTIVITIES; i++)
+	{
+		us[i] = last_window_us[i];
+	}
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+
+	uint32_t total = 0;
+	for (uint8_t i = 0; i < CPU_NUM_ACTIVITIES; i++)
+	{
+		total += us[i];
+	}
+	for (uint8_t i = 0; i < CPU_NUM_ACTIVITIES; i++)
+	{
+		load->percent[i] = total ? (us[i] * 100 + total / 2) / total : 0;
+	}
+}
@@ -0,0 +1,84 @@
+/*
+ * cpuload.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * CPU load accounting. Timer 1 runs freely at 1MHz as a timestamp counter.
+ * The main program says what kind of work it is doing with cpuload_enter(),
+ * and each interrupt handler brackets its body with cpuload_isr_enter() and
+ * cpuload_isr_exit(), so every microsecond is charged to exactly one
+ * activity. Interrupt time is taken out of whatever the main program was
+ * doing at the time. The totals are turned into percentages once a second.
+ *
+ * The interrupt entry and exit code generated by the compiler (around 40
+ * cycles per interrupt) falls outside the brackets and is charged to the
+ * interrupted activity, so interrupt time is slightly under-reported.
+ */
+
+#ifndef CPULOAD_H_
+#define CPULOAD_H_
+
+#include <stdint.h>
+
+// Length of an accounting window in milliseconds.
+#define CPULOAD_WINDOW	(1000)
+
+// Kinds of work the CPU time is divided between.
+typedef enum
+{
+	CPU_IDLE,  	// Polling for something to do.
+	CPU_GAME,  	// Handling input and game logic.
+	CPU_RENDER,	// Drawing the LED matrix and the terminal.
+	CPU_ISR,   	// Interrupt handlers.
+	CPU_NUM_ACTIVITIES
+} CpuActivity;
+
+// The share of each activity in a window, in percent (these may not add up
+// to exactly 100 due to rounding).
+typedef struct
+{
+	uint8_t percent[CPU_NUM_ACTIVITIES];
+} CpuLoad;
+
+/// <summary>
+/// Starts timer 1 and the accounting window. The main program starts off
+/// idle. This function must be called after init_timer0(). This function
+/// should only be called once.
+/// </summary>
+void init_cpuload(void);
+
+/// <summary>
+/// Charges the time since the last change to the current activity, and
+/// switches to a new activity. Must not be called from an interrupt handler.
+/// </summary>
+/// <param name="activity">The new activity.</param>
+/// <returns>The previous activity, so that it can be restored.</returns>
+CpuActivity cpuload_enter(CpuActivity activity);
+
+/// <summary>
+/// Marks the start of an interrupt handler.
+/// </summary>
+/// <returns>The time the handler started, to be passed to
+/// cpuload_isr_exit().</returns>
+uint16_t cpuload_isr_enter(void);
+
+/// <summary>
+/// Marks the end of an interrupt handler.
+/// </summary>
+/// <param name="start">The value returned by cpuload_isr_enter().</param>
+void cpuload_isr_exit(uint16_t start);
+
+/// <summary>
+/// Reads the timestamp counter, for timing short pieces of code (shorter
+/// than the 65ms it takes to wrap).
+/// </summary>
+/// <returns>The time in microseconds.</returns>
+uint16_t cpuload_timestamp(void);
+
+/// <summary>
+/// Gets the load measured over the last complete window.
+/// </summary>
+/// <param name="load">Filled in with the load.</param>
+void cpuload_get(CpuLoad *load);
+
+#endif /* CPULOAD_H_ */
@@ -0,0 +1,453 @@
+/*
+ * display.c
+ *
+ * Author: Sithika Mannakkara
+ */
+
+#include "display.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include "ledmatrix.h"
+#include "pixel_colour.h"
+#include "anim.h"
+#include "timer0.h"
+#include "cpuload.h"
+
+// SPI bytes needed to update a single pixel, a whole row and the whole
+// matrix (command and location bytes included).
+#define PIXEL_COST	(3)
+#define ROW_COST	(2 + MATRIX_NUM_COLUMNS)
+#define COLUMN_COST	(2 + MATRIX_NUM_ROWS)
+#define ALL_COST	(1 + MATRIX_NUM_ROWS * MATRIX_NUM_COLUMNS)
+
+// Hardware shifts are worth sending only while they are cheaper than just
+// redrawing the matrix.
+#define MAX_PENDING_SHIFTS	(4)
+
+#define BLINK_FRAMES	(DISPLAY_BLINK_PERIOD / DISPLAY_FRAME_PERIOD)
+
+// What should be on the matrix (without the player icon).
+static MatrixData framebuffer;
+
+// Pixels that differ between the matrix and the framebuffer (with the player
+// icon drawn over it). Bit n of each row is column n.
+static uint16_t dirty_rows[MATRIX_NUM_ROWS];
+
+// Operations on the whole matrix waiting to be sent, the shifts in the order
+// they were made. If a clear is pending, the matrix will be blank before the
+// dirty pixels are sent, so any pending shifts are irrelevant.
+static bool pending_clear;
+static uint8_t pending_shifts[MAX_PENDING_SHIFTS];
+static uint8_t num_pending_shifts;
+
+// The player icon.
+static bool player_shown;
+static bool player_visible;
+static uint8_t player_row;
+static uint8_t player_col;
+static PixelColour player_colour;
+static uint8_t blink_frames;
+
+// Set by the frame timer when the next frame is due.
+static volatile bool frame_due;
+static SoftTimer frame_timer;
+
+static void schedule_frame(void)
+{
+	frame_due = true;
+}
+
+static void mark_all_dirty(void)
+{
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		dirty_rows[row] = 0xFFFF;
+	}
+}
+
+static void mark_dirty(uint8_t row, uint8_t col)
+{
+	dirty_rows[row] |= (uint16_t)1 << col;
+}
+
+// Gets the colour a pixel should be shown as.
+static PixelColour shown_colour(uint8_t row, uint8_t col)
+{
+	if (player_shown && player_visible && row == player_row &&
+		col == player_col)
+	{
+		return player_colour;
+	}
+	return framebuffer[row][col];
+}
+
+static uint8_t count_bits(uint16_t bits)
+{
+	uint8_t count = 0;
+	while (bits)
+	{
+		bits &= bits - 1;
+		count++;
+	}
+	return count;
+}
+
+void init_display(void)
+{
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		set_matrix_row_to_colour(framebuffer[row], COLOUR_BLACK);
+		dirty_rows[row] = 0;
+	}
+	pending_clear = true;
+	num_pending_shifts = 0;
+	player_shown = false;
+	frame_due = true;
+	soft_timer_start(&frame_timer, DISPLAY_FRAME_PERIOD,
+		DISPLAY_FRAME_PERIOD, schedule_frame);
+}
+
+static void send_shift(DisplayShift direction)
+{
+	switch (direction)
+	{
+		case DISPLAY_SHIFT_LEFT:
+			ledmatrix_shift_display_left();
+			break;
+		case DISPLAY_SHIFT_RIGHT:
+			ledmatrix_shift_display_right();
+			break;
+		case DISPLAY_SHIFT_UP:
+			ledmatrix_shift_display_up();
+			break;
+		case DISPLAY_SHIFT_DOWN:
+			ledmatrix_shift_display_down();
+			break;
+	}
+}
+
+// Sends the dirty pixels to the matrix, with whichever of pixel, row, column
+// or whole matrix updates is cheapest.
+static void flush(void)
+{
+	if (pending_clear)
+	{
+		ledmatrix_clear();
+		pending_clear = false;
+		num_pending_shifts = 0;
+	}
+	for (uint8_t i = 0; i < num_pending_shifts; i++)
+	{
+		send_shift(pending_shifts[i]);
+	}
+	num_pending_shifts = 0;
+
+	// Columns which are dirty all the way up (such as one which has just
+	// been scrolled in) are sent whole, the rest row by row.
+	uint16_t full_columns = 0xFFFF;
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		full_columns &= dirty_rows[row];
+	}
+	uint16_t cost = count_bits(full_columns) * COLUMN_COST;
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		uint8_t pixel_cost = count_bits(dirty_rows[row] & ~full_columns) *
+			PIXEL_COST;
+		cost += pixel_cost < ROW_COST ? pixel_cost : ROW_COST;
+	}
+
+	if (cost > ALL_COST)
+	{
+		MatrixData data;
+		for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+		{
+			for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+			{
+				data[row][col] = shown_colour(row, col);
+			}
+			dirty_rows[row] = 0;
+		}
+		ledmatrix_update_all(data);
+		return;
+	}
+
+	for (uint8_t col = 0; full_columns >> col; col++)
+	{
+		if ((full_columns >> col) & 1)
+		{
+			MatrixColumn data;
+			for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+			{
+				data[row] = shown_colour(row, col);
+			}
+			ledmatrix_update_column(col, data);
+		}
+	}
+
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		uint16_t dirty = dirty_rows[row] & ~full_columns;
+		dirty_rows[row] = 0;
+		if (dirty == 0)
+		{
+			continue;
+		}
+
+		if (count_bits(dirty) * PIXEL_COST >= ROW_COST)
+		{
+			MatrixRow data;
+			for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+			{
+				data[col] = shown_colour(row, col);
+			}
+			ledmatrix_update_row(row, data);
+			continue;
+		}
+
+		for (uint8_t col = 0; dirty; col++, dirty >>= 1)
+		{
+			if (dirty & 1)
+			{
+				ledmatrix_update_pixel(row, col,
+					shown_colour(row, col));
+			}
+		}
+	}
+}
+
+void display_update(void)
+{
+	if (!frame_due)
+	{
+		return;
+	}
+	frame_due = false;
+	CpuActivity previous = cpuload_enter(CPU_RENDER);
+
+	anim_step();
+	if (player_shown && ++blink_frames >= BLINK_FRAMES)
+	{
+		blink_frames = 0;
+		player_visible = !player_visible;
+		mark_dirty(player_row, player_col);
+	}
+
+	flush();
+	cpuload_enter(previous);
+}
+
+void display_set_pixel(uint8_t row, uint8_t col, PixelColour colour)
+{
+	if (row >= MATRIX_NUM_ROWS || col >= MATRIX_NUM_COLUMNS)
+	{
+		// Invalid location, ignore the request.
+		return;
+	}
+	if (framebuffer[row][col] != colour)
+	{
+		framebuffer[row][col] = colour;
+		mark_dirty(row, col);
+	}
+}
+
+PixelColour display_get_pixel(uint8_t row, uint8_t col)
+{
+	if (row >= MATRIX_NUM_ROWS || col >= MATRIX_NUM_COLUMNS)
+	{
+		return COLOUR_BLACK;
+	}
+	return framebuffer[row][col];
+}
+
+void display_set_column(uint8_t col, MatrixColumn data)
+{
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		display_set_pixel(row, col, data[row]);
+	}
+}
+
+// Moves the framebuffer contents one column or row along, clearing the
+// column or row shifted in.
+static void shift_framebuffer(DisplayShift direction)
+{
+	switch (direction)
+	{
+		case DISPLAY_SHIFT_LEFT:
+			for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+			{
+				PixelColour *pixels = framebuffer[row];
+				for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS - 1;
+					col++)
+				{
+					pixels[col] = pixels[col + 1];
+				}
+				pixels[MATRIX_NUM_COLUMNS - 1] = COLOUR_BLACK;
+			}
+			break;
+		case DISPLAY_SHIFT_RIGHT:
+			for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+			{
+				PixelColour *pixels = framebuffer[row];
+				for (uint8_t col = MATRIX_NUM_COLUMNS - 1; col > 0;
+					col--)
+				{
+					pixels[col] = pixels[col - 1];
+				}
+				pixels[0] = COLOUR_BLACK;
+			}
+			break;
+		case DISPLAY_SHIFT_UP:
+			for (uint8_t row = MATRIX_NUM_ROWS - 1; row > 0; row--)
+			{
+				copy_matrix_row(framebuffer[row - 1], framebuffer[row]);
+			}
+			set_matrix_row_to_colour(framebuffer[0], COLOUR_BLACK);
+			break;
+		case DISPLAY_SHIFT_DOWN:
+			for (uint8_t row = 0; row < MATRIX_NUM_ROWS - 1; row++)
+			{
+				copy_matrix_row(framebuffer[row + 1], framebuffer[row]);
+			}
+			set_matrix_row_to_colour(framebuffer[MATRIX_NUM_ROWS - 1],
+				COLOUR_BLACK);
+			break;
+	}
+}
+
+// Moves the dirty pixels along with a shift. The column or row shifted in is
+// marked dirty if the matrix doesn't know what it should be.
+static void shift_dirty(DisplayShift direction, bool shifted_in_dirty)
+{
+	uint16_t fill = shifted_in_dirty ? 0xFFFF : 0;
+	switch (direction)
+	{
+		case DISPLAY_SHIFT_LEFT:
+			for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+			{
+				dirty_rows[row] = (dirty_rows[row] >> 1) | (fill &
+					((uint16_t)1 << (MATRIX_NUM_COLUMNS - 1)));
+			}
+			break;
+		case DISPLAY_SHIFT_RIGHT:
+			for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+			{
+				dirty_rows[row] = (dirty_rows[row] << 1) | (fill & 1);
+			}
+			break;
+		case DISPLAY_SHIFT_UP:
+			for (uint8_t row = MATRIX_NUM_ROWS - 1; row > 0; row--)
+			{
+				dirty_rows[row] = dirty_rows[row - 1];
+			}
+			dirty_rows[0] = fill;
+			break;
+		case DISPLAY_SHIFT_DOWN:
+			for (uint8_t row = 0; row < MATRIX_NUM_ROWS - 1; row++)
+			{
+				dirty_rows[row] = dirty_rows[row + 1];
+			}
+			dirty_rows[MATRIX_NUM_ROWS - 1] = fill;
+			break;
+	}
+}
+
+void display_shift(DisplayShift direction)
+{
+	shift_framebuffer(direction);
+	anim_shift(direction == DISPLAY_SHIFT_UP ? 1 :
+		direction == DISPLAY_SHIFT_DOWN ? -1 : 0,
+		direction == DISPLAY_SHIFT_RIGHT ? 1 :
+		direction == DISPLAY_SHIFT_LEFT ? -1 : 0);
+
+	if (pending_clear)
+	{
+		// The matrix will be blank, so only the pixels which aren't
+		// need to be sent. They move along with the framebuffer.
+		shift_dirty(direction, false);
+	}
+	else if (num_pending_shifts < MAX_PENDING_SHIFTS)
+	{
+		// The matrix is shifted too, so the differences between it and
+		// the framebuffer move along with them. What the matrix shifts
+		// in is unknown.
+		pending_shifts[num_pending_shifts++] = direction;
+		shift_dirty(direction, true);
+	}
+	else
+	{
+		mark_all_dirty();
+	}
+
+	if (player_shown)
+	{
+		// The icon stays where it is, so the pixels it was drawn
+		// over before and after the shift need to be redrawn.
+		mark_dirty(player_row, player_col);
+		uint8_t row = player_row;
+		uint8_t col = player_col;
+		switch (direction)
+		{
+			case DISPLAY_SHIFT_LEFT:
+				col--;
+				break;
+			case DISPLAY_SHIFT_RIGHT:
+				col++;
+				break;
+			case DISPLAY_SHIFT_UP:
+				row++;
+				break;
+			case DISPLAY_SHIFT_DOWN:
+				row--;
+				break;
+		}
+		if (row < MATRIX_NUM_ROWS && col < MATRIX_NUM_COLUMNS)
+		{
+			mark_dirty(row, col);
+		}
+	}
+}
+
+void display_clear(void)
+{
+	anim_stop_all();
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		set_matrix_row_to_colour(framebuffer[row], COLOUR_BLACK);
+		dirty_rows[row] = 0;
+	}
+	pending_clear = true;
+	num_pending_shifts = 0;
+	if (player_shown)
+	{
+		mark_dirty(player_row, player_col);
+	}
+}
+
+void display_set_player(uint8_t row, uint8_t col, PixelColour colour)
+{
+	if (player_shown)
+	{
+		mark_dirty(player_row, player_col);
+	}
+	player_shown = row < MATRIX_NUM_ROWS && col < MATRIX_NUM_COLUMNS;
+	player_visible = true;
+	player_row = row;
+	player_col = col;
+	player_colour = colour;
+	blink_frames = 0;
+	if (player_shown)
+	{
+		mark_dirty(row, col);
+	}
+}
+
+void display_hide_player(void)
+{
+	if (player_shown)
+	{
+		mark_dirty(player_row, player_col);
+		player_shown = false;
+	}
+}
@@ -0,0 +1,108 @@
+/*
+ * display.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Framebuffer for the LED matrix. Drawing functions only change the
+ * framebuffer and mark the pixels they change as dirty. The dirty pixels are
+ * sent to the matrix by a display task that runs at a fixed rate (scheduled
+ * by a timer 0 software timer), using whichever LED matrix commands need the
+ * fewest SPI bytes. The cost of a frame is therefore bounded no matter how
+ * much was drawn since the last one.
+ *
+ * The display also owns the blinking player icon, which is drawn over the
+ * framebuffer so that game logic never has to time the blink itself.
+ */
+
+#ifndef DISPLAY_H_
+#define DISPLAY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ledmatrix.h"
+#include "pixel_colour.h"
+
+// Time between frames in milliseconds (i.e., 50 frames per second).
+#define DISPLAY_FRAME_PERIOD	(20)
+
+// Time the player icon spends on (and off) in each blink, in milliseconds.
+// Must be a multiple of the frame period.
+#define DISPLAY_BLINK_PERIOD	(200)
+
+// Directions the framebuffer can be shifted in.
+typedef enum
+{
+	DISPLAY_SHIFT_LEFT,
+	DISPLAY_SHIFT_RIGHT,
+	DISPLAY_SHIFT_UP,
+	DISPLAY_SHIFT_DOWN
+} DisplayShift;
+
+/// <summary>
+/// Initialises the framebuffer and clears the LED matrix. This function must
+/// be called after init_ledmatrix() and init_timer0(), and before any of the
+/// other display functions. This function should only be called once.
+/// </summary>
+void init_display(void);
+
+/// <summary>
+/// Steps any running animations (see anim.h) and sends the changes made since
+/// the last frame to the LED matrix, if a frame is due. Should be called
+/// regularly from every main loop; does nothing between frames.
+/// </summary>
+void display_update(void);
+
+/// <summary>
+/// Sets the colour of a pixel in the framebuffer.
+/// </summary>
+/// <param name="row">The row number of the pixel.</param>
+/// <param name="col">The column number of the pixel.</param>
+/// <param name="colour">New colour of the pixel.</param>
+void display_set_pixel(uint8_t row, uint8_t col, PixelColour colour);
+
+/// <summary>
+/// Gets the colour of a pixel in the framebuffer (i.e., without the player
+/// icon).
+/// </summary>
+/// <param name="row">The row number of the pixel.</param>
+/// <param name="col">The column number of the pixel.</param>
+/// <returns>The colour of the pixel.</returns>
+PixelColour display_get_pixel(uint8_t row, uint8_t col);
+
+/// <summary>
+/// Sets the colours of all pixels in a column of the framebuffer.
+/// </summary>
+/// <param name="col">The column to set.</param>
+/// <param name="data">New colours for the column.</param>
+void display_set_column(uint8_t col, MatrixColumn data);
+
+/// <summary>
+/// Shifts the framebuffer (and any fades) by one column or row. The column
+/// or row shifted in is cleared. The LED matrix is sent the same shift
+/// while that is cheaper than redrawing it, so only what is drawn into the
+/// cleared column or row has to be sent as well.
+/// </summary>
+/// <param name="direction">The direction to shift in.</param>
+void display_shift(DisplayShift direction);
+
+/// <summary>
+/// Clears the framebuffer and stops any animations (the player icon is not
+/// affected).
+/// </summary>
+void display_clear(void);
+
+/// <summary>
+/// Shows the blinking player icon at the given location. The icon is shown
+/// straight away and the blink cycle restarts from there.
+/// </summary>
+/// <param name="row">The row number of the player.</param>
+/// <param name="col">The column number of the player.</param>
+/// <param name="colour">The colour of the icon.</param>
+void display_set_player(uint8_t row, uint8_t col, PixelColour colour);
+
+/// <summary>
+/// Hides the player icon, showing the framebuffer underneath it.
+/// </summary>
+void display_hide_player(void);
+
+#endif /* DISPLAY_H_ */
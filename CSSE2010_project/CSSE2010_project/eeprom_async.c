@@ -0,0 +1,141 @@
+/*
+ * eeprom_async.c
+ *
+ * Author: Sithika Mannakkara
+ */
+
+#include "eeprom_async.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "cpuload.h"
+
+// Queue of jobs waiting to be written. Jobs are linked through their next
+// pointer, the head job is the one currently being written.
+static EepromJob *volatile queue_head;
+static EepromJob *volatile queue_tail;
+
+// Progress through the job at the head of the queue.
+static uint16_t write_address;
+static const uint8_t *write_data;
+static uint8_t bytes_left;
+
+// Loads the progress variables for the given job (which must be at the head
+// of the queue). Only called with interrupts disabled.
+static void start_job(EepromJob *job)
+{
+	write_address = job->address;
+	write_data = job->data;
+	bytes_left = job->length;
+}
+
+void init_eeprom_async(void)
+{
+	queue_head = NULL;
+	queue_tail = NULL;
+	bytes_left = 0;
+
+	// The EEPROM ready interrupt is only enabled while there are jobs to
+	// write, otherwise it would fire continuously.
+	EECR &= ~(1 << EERIE);
+}
+
+bool eeprom_async_submit(EepromJob *job)
+{
+	if (job->pending)
+	{
+		return false;
+	}
+
+	// Save whether interrupts were enabled and turn them off, so the ISR
+	// doesn't see the queue half updated.
+	bool interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+
+	job->pending = true;
+	job->next = NULL;
+	if (queue_tail == NULL)
+	{
+		queue_head = job;
+		start_job(job);
+	}
+	else
+	{
+		queue_tail->next = job;
+	}
+	queue_tail = job;
+
+	// The interrupt fires as soon as the EEPROM is ready (which may be
+	// immediately) and keeps firing until the queue is empty.
+	EECR |= (1 << EERIE);
+
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+	return true;
+}
+
+bool eeprom_async_busy(void)
+{
+	return queue_head != NULL;
+}
+
+// Writes the next byte that needs programming, or disables the interrupt if
+// there is nothing left to write.
+static void write_next_byte(void)
+{
+	while (queue_head != NULL)
+	{
+		while (bytes_left > 0)
+		{
+			uint16_t address = write_address++;
+			uint8_t value = *write_data++;
+			bytes_left--;
+
+			// Read the byte currently stored at the address. If it
+			// already holds the value there is no need to program it.
+			EEAR = address;
+			EECR |= (1 << EERE);
+			if (EEDR != value)
+			{
+				// Start the write. EEPE must be set within four
+				// cycles of setting EEMPE. The interrupt fires
+				// again once the write has completed.
+				EEDR = value;
+				EECR |= (1 << EEMPE);
+				EECR |= (1 << EEPE);
+				return;
+			}
+		}
+
+		// All bytes of the head job have been written, move on to the
+		// next job in the queue (if there is one).
+		EepromJob *job = queue_head;
+		queue_head = job->next;
+		if (queue_head == NULL)
+		{
+			queue_tail = NULL;
+		}
+		else
+		{
+			start_job(queue_head);
+		}
+		job->pending = false;
+	}
+
+	// Nothing left to write. Disable the interrupt, it is reenabled when
+	// the next job is submitted.
+	EECR &= ~(1 << EERIE);
+}
+
+// Interrupt handler for EEPROM ready (i.e., the previous write has finished
+// and another byte may be written).
+ISR(EE_READY_vect)
+{
+	uint16_t start = cpuload_isr_enter();
+	write_next_byte();
+	cpuload_isr_exit(start);
+}
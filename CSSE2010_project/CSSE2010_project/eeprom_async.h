@@ -0,0 +1,59 @@
+/*
+ * eeprom_async.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Interrupt driven EEPROM writer. Blocks of data are queued as jobs and
+ * written one byte at a time from the EEPROM ready interrupt, so the caller
+ * never has to wait the ~3.4ms it takes to program each byte. Bytes which
+ * already hold the requested value are skipped, which both saves time and
+ * avoids wearing out cells that haven't changed.
+ */
+
+#ifndef EEPROM_ASYNC_H_
+#define EEPROM_ASYNC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// EEPROM layout. The ATmega324A has 1KB of EEPROM (addresses 0 - 1023).
+#define EEPROM_HIGHSCORE_BASE	(0x000)
+#define EEPROM_HIGHSCORE_SIZE	(0x240)
+#define EEPROM_SAVESTATE_BASE	(0x240)
+#define EEPROM_SAVESTATE_SIZE	(0x080)
+
+// A queued EEPROM write. The job (and the data it points to) is owned by the
+// caller and must not be modified until the job is no longer pending.
+typedef struct EepromJob
+{
+	uint16_t address;
+	const uint8_t *data;
+	uint8_t length;
+	volatile bool pending;
+	struct EepromJob *volatile next;
+} EepromJob;
+
+/// <summary>
+/// Initialises the EEPROM writer. This function must be called before any
+/// jobs are submitted. This function should only be called once.
+/// </summary>
+void init_eeprom_async(void);
+
+/// <summary>
+/// Queues a job for writing. The job must have its address, data and length
+/// set, and must not already be pending. Jobs are written in the order they
+/// are submitted.
+/// </summary>
+/// <param name="job">The job to queue.</param>
+/// <returns>Whether the job was queued (false if it is already pending).
+/// </returns>
+bool eeprom_async_submit(EepromJob *job);
+
+/// <summary>
+/// Tests if any jobs are still waiting to be written. Blocking EEPROM
+/// accesses (e.g., eeprom_read_block()) must not be made while this is true.
+/// </summary>
+/// <returns>Whether the writer is busy.</returns>
+bool eeprom_async_busy(void);
+
+#endif /* EEPROM_ASYNC_H_ */
@@ -0,0 +1,54 @@
+/*
+ * enginebench.c
+ *
+ * Author: Sithika Mannakkara
+ */
+
+#include "enginebench.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "game.h"
+#include "render.h"
+#include "terminalio.h"
+#include "timer0.h"
+
+// How long the test runs for, in milliseconds.
+#define TEST_TIME	(1000)
+
+void run_engine_benchmark(void)
+{
+	clear_terminal();
+	move_terminal_cursor(1, 1);
+	printf_P(PSTR("Engine benchmark (%d ms, drawing off)\n\n"), TEST_TIME);
+
+	render_suspend(true);
+	initialise_game(0);
+	BoardState start;
+	get_board_state(&start);
+
+	uint16_t sequence = ENGINE_BENCH_SEED;
+	uint32_t moves = 0;
+	uint32_t valid = 0;
+	uint32_t start_time = get_current_time();
+	while (get_current_time() - start_time < TEST_TIME)
+	{
+		// Check the time only every ENGINE_BENCH_RESTART moves, so the
+		// loop is dominated by move_player().
+		for (uint16_t i = 0; i < ENGINE_BENCH_RESTART; i++)
+		{
+			const int8_t *move =
+				engine_bench_moves[engine_bench_next(&sequence)];
+			valid += move_player(move[0], move[1]);
+		}
+		moves += ENGINE_BENCH_RESTART;
+		restore_board_state(&start);
+	}
+	uint32_t elapsed = get_current_time() - start_time;
+	render_suspend(false);
+
+	printf_P(PSTR("%lu moves (%lu valid) in %lu ms\n"), moves, valid,
+		elapsed);
+	printf_P(PSTR("%lu moves/s, %lu us per move\n"), moves * 1000 / elapsed,
+		elapsed * 1000 / moves);
+}
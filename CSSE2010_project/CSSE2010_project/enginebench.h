@@ -0,0 +1,53 @@
+/*
+ * enginebench.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Benchmark for the game engine alone. Drawing is turned off (see
+ * render_suspend() in render.h) and move_player() is called as fast as
+ * possible with a fixed pseudo-random sequence of moves, restoring the level
+ * 1 board every ENGINE_BENCH_RESTART moves so the player doesn't get stuck.
+ * The same sequence is run on the host by tools/enginebench, which builds
+ * game.c without any render backends, so the two rates can be compared
+ * directly.
+ */
+
+#ifndef ENGINEBENCH_H_
+#define ENGINEBENCH_H_
+
+#include <stdint.h>
+
+// How often the board is restored, in moves.
+#define ENGINE_BENCH_RESTART	(256)
+
+// Starting value of the move sequence (any non-zero value).
+#define ENGINE_BENCH_SEED	(0xACE1)
+
+// Row and column deltas of each move the sequence can pick (w, s, a, d).
+static const int8_t engine_bench_moves[4][2] = { { 1, 0 }, { -1, 0 },
+	{ 0, -1 }, { 0, 1 } };
+
+/// <summary>
+/// Steps the move sequence, a 16-bit xorshift generator (cheap on the
+/// ATmega324A, since it only needs 16-bit shifts).
+/// </summary>
+/// <param name="state">The generator state, updated.</param>
+/// <returns>The index of the next move in engine_bench_moves.</returns>
+static inline uint8_t engine_bench_next(uint16_t *state)
+{
+	uint16_t x = *state;
+	x ^= x << 7;
+	x ^= x >> 9;
+	x ^= x << 8;
+	*state = x;
+	return x & 3;
+}
+
+/// <summary>
+/// Runs the engine benchmark and prints the move rate on the terminal. This
+/// function blocks for about a second and leaves the game uninitialised, so
+/// it should only be run from the start screen. Interrupts must be enabled.
+/// </summary>
+void run_engine_benchmark(void);
+
+#endif /* ENGINEBENCH_H_ */
@@ -0,0 +1,126 @@
+/*
+ * fastfmt.c
+ *
+ * Author: Sithika Mannakkara
+ */
+
+#include "fastfmt.h"
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "serialio.h"
+
+// Powers of ten used by fmt_u16(), largest first.
+static const uint16_t powers_of_ten[] PROGMEM = { 10000, 1000, 100, 10 };
+
+uint8_t fmt_u8(char *buffer, uint8_t value)
+{
+	char *p = buffer;
+	if (value >= 100)
+	{
+		char digit = '1';
+		value -= 100;
+		if (value >= 100)
+		{
+			digit++;
+			value -= 100;
+		}
+		*p++ = digit;
+		*p++ = '0';
+	}
+	else if (value >= 10)
+	{
+		*p++ = '0';
+	}
+
+	// The tens digit (if written) was started at '0' above.
+	if (p != buffer)
+	{
+		while (value >= 10)
+		{
+			p[-1]++;
+			value -= 10;
+		}
+	}
+	*p++ = '0' + value;
+	return p - buffer;
+}
+
+uint8_t fmt_u16(char *buffer, uint16_t value)
+{
+	if (value < 256)
+	{
+		return fmt_u8(buffer, value);
+	}
+
+	// Count how many times each power of ten fits, skipping leading
+	// zeros.
+	char *p = buffer;
+	for (uint8_t i = 0; i < sizeof(powers_of_ten) / sizeof(uint16_t); i++)
+	{
+		uint16_t power = pgm_read_word(&powers_of_ten[i]);
+		char digit = '0';
+		while (value >= power)
+		{
+			digit++;
+			value -= power;
+		}
+		if (digit != '0' || p != buffer)
+		{
+			*p++ = digit;
+		}
+	}
+	*p++ = '0' + value;
+	return p - buffer;
+}
+
+uint8_t fmt_cursor(char *buffer, uint8_t row, uint8_t col)
+{
+	char *p = buffer;
+	*p++ = '\x1b';
+	*p++ = '[';
+	p += fmt_u8(p, row + 1);
+	*p++ = ';';
+	p += fmt_u8(p, col + 1);
+	*p++ = 'H';
+	return p - buffer;
+}
+
+uint8_t fmt_attribute(char *buffer, uint8_t parameter)
+{
+	char *p = buffer;
+	*p++ = '\x1b';
+	*p++ = '[';
+	p += fmt_u8(p, parameter);
+	*p++ = 'm';
+	return p - buffer;
+}
+
+void fmt_put_P(const char *text)
+{
+	// Copy the string out of program memory a block at a time.
+	char buffer[16];
+	uint8_t length = 0;
+	char c;
+	while ((c = pgm_read_byte(text++)) != '\0')
+	{
+		buffer[length++] = c;
+		if (length == sizeof(buffer))
+		{
+			serial_write_text(buffer, length);
+			length = 0;
+		}
+	}
+	serial_write_text(buffer, length);
+}
+
+void fmt_put_u16(uint16_t value, uint8_t width)
+{
+	char buffer[FMT_U16_LENGTH];
+	uint8_t length = fmt_u16(buffer, value);
+	while (width > length)
+	{
+		serial_write_text(" ", 1);
+		width--;
+	}
+	serial_write_text(buffer, length);
+}
@@ -0,0 +1,83 @@
+/*
+ * fastfmt.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Small formatting functions for terminal output that is sent often (cursor
+ * moves, display attributes, counters). Numbers are converted to decimal by
+ * repeated subtraction, since the ATmega324A has no divide instruction, and
+ * escape sequences are built directly rather than by interpreting a format
+ * string. The results go straight into the serial output buffer without
+ * passing through standard I/O. All of this takes tens of cycles where
+ * printf_P() takes hundreds to thousands (see fmtbench.h).
+ *
+ * The builder functions write into a caller supplied buffer (which is not
+ * null terminated) and return the number of characters written. The put
+ * functions send their output to the serial port. Nothing here translates
+ * line feeds.
+ */
+
+#ifndef FASTFMT_H_
+#define FASTFMT_H_
+
+#include <stdint.h>
+
+// Longest output of the builder functions, for sizing buffers.
+#define FMT_U8_LENGTH       	(3)
+#define FMT_U16_LENGTH      	(5)
+#define FMT_CURSOR_LENGTH   	(10)
+#define FMT_ATTRIBUTE_LENGTH	(5)
+
+/// <summary>
+/// Writes a number in decimal.
+/// </summary>
+/// <param name="buffer">Where to write (at least FMT_U8_LENGTH
+/// characters).</param>
+/// <param name="value">The number.</param>
+/// <returns>The number of characters written.</returns>
+uint8_t fmt_u8(char *buffer, uint8_t value);
+
+/// <summary>
+/// Writes a number in decimal.
+/// </summary>
+/// <param name="buffer">Where to write (at least FMT_U16_LENGTH
+/// characters).</param>
+/// <param name="value">The number.</param>
+/// <returns>The number of characters written.</returns>
+uint8_t fmt_u16(char *buffer, uint16_t value);
+
+/// <summary>
+/// Writes the escape sequence that moves the cursor.
+/// </summary>
+/// <param name="buffer">Where to write (at least FMT_CURSOR_LENGTH
+/// characters).</param>
+/// <param name="row">The row (0-based, at most 254).</param>
+/// <param name="col">The column (0-based, at most 254).</param>
+/// <returns>The number of characters written.</returns>
+uint8_t fmt_cursor(char *buffer, uint8_t row, uint8_t col);
+
+/// <summary>
+/// Writes the escape sequence that sets a display attribute.
+/// </summary>
+/// <param name="buffer">Where to write (at least FMT_ATTRIBUTE_LENGTH
+/// characters).</param>
+/// <param name="parameter">The attribute (see DisplayParameter in
+/// terminalio.h).</param>
+/// <returns>The number of characters written.</returns>
+uint8_t fmt_attribute(char *buffer, uint8_t parameter);
+
+/// <summary>
+/// Sends a string stored in program memory.
+/// </summary>
+/// <param name="text">The string.</param>
+void fmt_put_P(const char *text);
+
+/// <summary>
+/// Sends a number in decimal, right aligned with spaces to at least the
+/// given width (like printf()'s "%5u").
+/// </summary>
+/// <param name="value">The number.</param>
+/// <param name="width">The minimum width (0 for none).</param>
+void fmt_put_u16(uint16_t value, uint8_t width);
+
+#endif /* FASTFMT_H_ */
@@ -0,0 +1,111 @@
+/*
+ * fmtbench.c
+ *
+ * Author: Sithika Mannakkara
+ */
+
+#include "fmtbench.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include "fastfmt.h"
+#include "cpuload.h"
+#include "terminalio.h"
+
+// Calls timed per test. At a few thousand cycles a call for snprintf_P()
+// this stays well inside the 65ms before the timestamp counter wraps.
+#define ITERATIONS	(100)
+
+// Timestamp counter ticks are microseconds, and the clock runs at 8MHz.
+#define CYCLES_PER_TICK	(8)
+
+#define BUFFER_LENGTH	(16)
+
+typedef enum
+{
+	TEST_CURSOR,
+	TEST_ATTRIBUTE,
+	TEST_NUMBER,
+	NUM_TESTS
+} FormatTest;
+
+static const char test_names[NUM_TESTS][10] PROGMEM =
+{
+	"cursor", "attribute", "u16"
+};
+
+// The buffer is volatile, so the compiler cannot drop the formatting.
+static volatile char sink[BUFFER_LENGTH];
+
+// Formats a test ITERATIONS times with either snprintf_P() or fastfmt.
+// Returns the average cycles per call.
+static uint16_t time_test(FormatTest test, bool use_printf)
+{
+	char buffer[BUFFER_LENGTH];
+	uint8_t length = 0;
+
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	uint16_t start = cpuload_timestamp();
+	for (uint8_t i = 0; i < ITERATIONS; i++)
+	{
+		// Vary the values so both take their longer paths at times.
+		uint8_t row = i & 31;
+		uint8_t col = i;
+		uint16_t number = (uint16_t)i * 617;
+		switch (test)
+		{
+			case TEST_CURSOR:
+				length = use_printf ?
+					snprintf_P(buffer, sizeof(buffer),
+					PSTR("\x1b[%d;%dH"), row + 1, col + 1) :
+					fmt_cursor(buffer, row, col);
+				break;
+			case TEST_ATTRIBUTE:
+				length = use_printf ?
+					snprintf_P(buffer, sizeof(buffer),
+					PSTR("\x1b[%dm"), FG_GREEN) :
+					fmt_attribute(buffer, FG_GREEN);
+				break;
+			default:
+				length = use_printf ?
+					snprintf_P(buffer, sizeof(buffer),
+					PSTR("%u"), number) :
+					fmt_u16(buffer, number);
+				break;
+		}
+		sink[0] = buffer[length - 1];
+	}
+	uint16_t elapsed = cpuload_timestamp() - start;
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+	return (uint32_t)elapsed * CYCLES_PER_TICK / ITERATIONS;
+}
+
+void run_format_benchmark(void)
+{
+	clear_terminal();
+	move_terminal_cursor(1, 1);
+	printf_P(PSTR("Formatting benchmark (%d calls per test)\n\n"),
+		ITERATIONS);
+	printf_P(PSTR("test        printf_P  fastfmt  speedup\n"));
+
+	for (uint8_t test = 0; test < NUM_TESTS; test++)
+	{
+		uint16_t slow = time_test(test, true);
+		uint16_t fast = time_test(test, false);
+		if (fast == 0)
+		{
+			fast = 1;
+		}
+		printf_P(PSTR("%-10S  %8u  %7u  %6u.%ux\n"), test_names[test],
+			slow, fast, slow / fast, (slow % fast) * 10 / fast);
+	}
+	printf_P(PSTR("\nCycles per call. Use tools/mapreport on the map file "
+		"to compare flash.\n"));
+}
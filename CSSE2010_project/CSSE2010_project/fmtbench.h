@@ -0,0 +1,27 @@
+/*
+ * fmtbench.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Benchmark for the fast formatter (fastfmt.h). Each of the terminal
+ * outputs the game sends most often (a cursor move, a display attribute and
+ * a number) is formatted into a buffer many times with snprintf_P() and
+ * then with the fastfmt builder, and the average cycles per call are
+ * printed on the terminal. Only the formatting is timed, not the sending.
+ *
+ * The flash taken by each can be compared from the map file with
+ * tools/mapreport, which lists the code size of fastfmt.o against the
+ * vfprintf_std.o that printf_P() pulls in from avr-libc.
+ */
+
+#ifndef FMTBENCH_H_
+#define FMTBENCH_H_
+
+/// <summary>
+/// Runs the formatting benchmark. This function blocks for well under a
+/// second, with interrupts disabled while each test runs. init_cpuload()
+/// must have been called.
+/// </summary>
+void run_format_benchmark(void);
+
+#endif /* FMTBENCH_H_ */
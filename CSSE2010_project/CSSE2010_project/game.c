@@ -5,6 +5,11 @@
  * Modified by: Sithika Mannakkara
  *
  * Game logic and state handler.
+ *
+ * Nothing is drawn here: each changed square and each message is reported
+ * to the render backends (see render.h), which draw the LED matrix and the
+ * terminal. This also means the game logic builds on the host, see
+ * tools/enginebench.c.
  */ 
 
 #include "game.h"
@@ -13,10 +18,10 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
-#include <avr/interrupt.h>
 #include <avr/pgmspace.h>
 #include "ledmatrix.h"
-#include "terminalio.h"
+#include "render.h"
+#include "level_format.h"
 
 
 // ========================== NOTE ABOUT MODULARITY ==========================
@@ -32,139 +37,441 @@
 
 // ============================ GLOBAL VARIABLES =============================
 
-// The game board, which is dynamically constructed by initialise_game() and
-// updated throughout the game. The 0th element of this array represents the
-// bottom row, and the 7th element of this array represents the top row.
-static uint8_t board[MATRIX_NUM_ROWS][MATRIX_NUM_COLUMNS];
+// The levels, compiled from XSB files by tools/levelc.c (see
+// level_format.h). The board wraps around at the edges, so a gap in the
+// outer wall of a level lets the player walk off one side and onto the
+// other.
+#include "level_pack.h"
+#define NUM_LEVELS	(LEVEL_PACK_SIZE)
+#if NUM_LEVELS > MAX_LEVELS
+#error "Too many levels in level_pack.h"
+#endif
+
+// The level currently being played (0-based) and its map. The walls and
+// targets never move, so they are read from the level in program memory.
+static uint8_t current_level;
+static PackedLevel map;
+
+// The boxes, which are placed by initialise_game() and moved throughout the
+// game. Bit n of boxes[row][col / 8] is column (col / 8) * 8 + n, and row 0
+// is the bottom row.
+static uint8_t boxes[MAP_MAX_ROWS][MAP_MAX_COLUMNS / 8];
+
+// The map as seen by the render backends.
+static RenderMap render_map;
 
 // The location of the player.
 static uint8_t player_row;
 static uint8_t player_col;
 
+static uint8_t num_boxes;
 static uint8_t num_boxes_in_target;
 
-// A flag for keeping track of whether the player is currently visible.
-static bool player_visible;
-
-static const uint8_t TERMINAL_GAME_ROW = 12;
-static const uint8_t TERMINAL_GAME_COL = 15;
-static const uint8_t TERMINAL_E_ROW = 5;
-static const uint8_t TERMINAL_E_COL = 5;
-
-static uint8_t coordinate_history[6][2];
+// Recent player locations (for testing), packed as (row << 8 | col).
+#define HISTORY_LENGTH	(6)
+#define HISTORY_EMPTY	(0xFFFF)
+static uint16_t coordinate_history[HISTORY_LENGTH];
 static uint8_t hist_idx;
 
+// Moves that can be undone, packed two to a byte (see record_move()). The
+// oldest moves are forgotten once UNDO_DEPTH moves have been recorded.
+#define UNDO_DEPTH	(128)
+static uint8_t undo_moves[UNDO_DEPTH / 2];
+static uint8_t undo_next;
+static uint8_t undo_count;
+
+// Undo record fields. The direction is the index of the move's deltas in
+// move_deltas.
+#define UNDO_DIRECTION_MASK	(0x03)
+#define UNDO_PUSHED     	(0x04)
+static const int8_t move_deltas[4][2] = { { 1, 0 }, { -1, 0 }, { 0, -1 },
+	{ 0, 1 } };
+
+// Messages shown in the message area of the terminal.
+typedef enum
+{
+	MSG_NONE,
+	MSG_HIT_WALL,
+	MSG_THROUGH_WALL,
+	MSG_WALL_OBSTRUCTING,
+	MSG_BOX_INTO_WALL,
+	MSG_TWO_BOXES,
+	MSG_BOX_ON_TARGET,
+	MSG_NOTHING_TO_UNDO,
+	NUM_MESSAGES
+} MessageId;
+
+// The message text, all kept in program memory. The three wall messages must
+// stay consecutive, one of them is picked at random.
+static const char msg_hit_wall[] PROGMEM = "The player hit a wall!";
+static const char msg_through_wall[] PROGMEM =
+	"Player can't move through walls.";
+static const char msg_wall_obstructing[] PROGMEM =
+	"The wall is obstructing you.";
+static const char msg_box_into_wall[] PROGMEM =
+	"You can't push a box through a wall!";
+static const char msg_two_boxes[] PROGMEM =
+	"You can't push two boxes at once!";
+static const char msg_box_on_target[] PROGMEM = "Box was moved to target.";
+static const char msg_nothing_to_undo[] PROGMEM = "Nothing to undo.";
+static const char *const messages[NUM_MESSAGES] PROGMEM =
+{
+	[MSG_NONE] = NULL,
+	[MSG_HIT_WALL] = msg_hit_wall,
+	[MSG_THROUGH_WALL] = msg_through_wall,
+	[MSG_WALL_OBSTRUCTING] = msg_wall_obstructing,
+	[MSG_BOX_INTO_WALL] = msg_box_into_wall,
+	[MSG_TWO_BOXES] = msg_two_boxes,
+	[MSG_BOX_ON_TARGET] = msg_box_on_target,
+	[MSG_NOTHING_TO_UNDO] = msg_nothing_to_undo
+};
 
 
 // ========================== GAME LOGIC FUNCTIONS ===========================
 
-// This function paints a square based on the object(s) currently on it.
-static void paint_square(uint8_t row, uint8_t col)
+// This function returns whether a list of squares in a LEVEL_PLANES level
+// holds a square, and moves the list pointer past the end of the list.
+static bool find_square(const uint8_t **list, uint8_t row, uint8_t col)
+{
+	const uint8_t *entry = *list;
+	uint8_t count = pgm_read_byte(entry++);
+	bool found = false;
+	for (; count > 0; count--, entry += 2)
+	{
+		if (pgm_read_byte(&entry[0]) == row && pgm_read_byte(&entry[1]) == col)
+		{
+			found = true;
+		}
+	}
+	*list = entry;
+	return found;
+}
+
+// This function returns the object(s) a square of a level starts with.
+static uint8_t level_square(const PackedLevel *level, uint8_t row, uint8_t col)
 {
-	switch (board[row][col] & OBJECT_MASK)
+	uint16_t square = (uint16_t)row * level->columns + col;
+	const uint8_t *data = level->data;
+	uint8_t byte;
+	switch (level->encoding)
 	{
-		case ROOM:
-			ledmatrix_update_pixel(row, col, COLOUR_BLACK);
-			break;
-		case WALL:
-			ledmatrix_update_pixel(row, col, COLOUR_WALL);
-			break;
-		case BOX:
-			ledmatrix_update_pixel(row, col, COLOUR_BOX);
-			break;
-		case TARGET:
-			ledmatrix_update_pixel(row, col, COLOUR_TARGET);
-			break;
-		case BOX | TARGET:
-			ledmatrix_update_pixel(row, col, COLOUR_DONE);
-			break;
+		case LEVEL_NIBBLES:
+			byte = pgm_read_byte(&data[square >> 1]);
+			return (square & 1 ? byte >> 4 : byte) & 0x0F;
+		case LEVEL_CODES:
+			byte = pgm_read_byte(&data[square >> 2]);
+			switch ((byte >> ((square & 3) << 1)) & 0x03)
+			{
+				case LEVEL_CODE_WALL:
+					return WALL;
+				case LEVEL_CODE_BOX:
+					return BOX;
+				case LEVEL_CODE_TARGET:
+					return TARGET;
+				default:
+					return ROOM;
+			}
+		case LEVEL_RUNS:
+			while (1)
+			{
+				byte = pgm_read_byte(data++);
+				uint8_t length = (byte & 0x1F) + 1;
+				if (square < length)
+				{
+					return byte >> 5;
+				}
+				square -= length;
+			}
 		default:
-			break;
+		{
+			// LEVEL_PLANES. The lists follow the walls.
+			uint8_t object = ROOM;
+			if (pgm_read_byte(&data[square >> 3]) & (1 << (square & 7)))
+			{
+				return WALL;
+			}
+			data += ((uint16_t)level->rows * level->columns + 7) >> 3;
+			if (find_square(&data, row, col))
+			{
+				object |= TARGET;
+			}
+			if (find_square(&data, row, col))
+			{
+				object |= BOX;
+			}
+			return object;
+		}
 	}
 }
 
-// This function initialises the global variables used to store the game
-// state, and renders the initial game display.
-void initialise_game(void)
+// This function copies a level's size, player location and data pointer
+// out of program memory.
+static void read_level(uint8_t level, PackedLevel *info)
 {
-	hist_idx = 1;
-	coordinate_history[0][0] = 5;
-	coordinate_history[0][1] = 2;
-	coordinate_history[1][0] = 0xFF;
-	coordinate_history[1][1] = 0xFF;
-	coordinate_history[2][0] = 0xFF;
-	coordinate_history[2][1] = 0xFF;
-	coordinate_history[3][0] = 0xFF;
-	coordinate_history[3][1] = 0xFF;
-	coordinate_history[4][0] = 0xFF;
-	coordinate_history[4][1] = 0xFF;
-	coordinate_history[5][0] = 0xFF;
-	coordinate_history[5][1] = 0xFF;
+	memcpy_P(info, &levels[level], sizeof(*info));
+}
+
+// This function returns whether there is a box on a square.
+static bool has_box(uint8_t row, uint8_t col)
+{
+	return boxes[row][col >> 3] & (1 << (col & 7));
+}
+
+// This function returns the object(s) on a square.
+static uint8_t get_object(uint8_t row, uint8_t col)
+{
+	uint8_t object = level_square(&map, row, col) & (WALL | TARGET);
+	if (has_box(row, col))
+	{
+		object |= BOX;
+	}
+	return object;
+}
+
+// This function sets the object(s) on a square. Only boxes can be moved,
+// the walls and targets are always those of the level.
+static void set_object(uint8_t row, uint8_t col, uint8_t object)
+{
+	uint8_t bit = 1 << (col & 7);
+	if (object & BOX)
+	{
+		boxes[row][col >> 3] |= bit;
+	}
+	else
+	{
+		boxes[row][col >> 3] &= ~bit;
+	}
+}
+
+// This function starts a level with no boxes on the board. The caller places
+// the boxes and the player.
+static void load_level(uint8_t level)
+{
+	current_level = level < NUM_LEVELS ? level : 0;
+	read_level(current_level, &map);
+	memset(boxes, 0, sizeof(boxes));
+	num_boxes = 0;
 	num_boxes_in_target = 0;
-	// Short definitions of game objects used temporarily for constructing
-	// an easier-to-visualise game layout.
-	#define _	(ROOM)
-	#define W	(WALL)
-	#define T	(TARGET)
-	#define B	(BOX)
-	
+	render_map.rows = map.rows;
+	render_map.columns = map.columns;
+	render_map.get_cell = get_object;
+}
 
-	// The starting layout of level 1. In this array, the top row is the
-	// 0th row, and the bottom row is the 7th row. This makes it visually
-	// identical to how the pixels are oriented on the LED matrix, however
-	// the LED matrix treats row 0 as the bottom row and row 7 as the top
-	// row.
-	static const uint8_t lv1_layout[MATRIX_NUM_ROWS][MATRIX_NUM_COLUMNS] =
+// This function places a box on an empty square, and counts it.
+static void place_box(uint8_t row, uint8_t col)
+{
+	set_object(row, col, BOX);
+	num_boxes++;
+	if (get_object(row, col) & TARGET)
 	{
-		{ _, W, _, W, W, W, _, W, W, W, _, _, W, W, W, W },
-		{ _, W, T, W, _, _, W, T, _, B, _, _, _, _, T, W },
-		{ _, _, _, _, _, _, _, _, _, _, _, _, _, _, _, _ },
-		{ W, _, B, _, _, _, _, W, _, _, B, _, _, B, _, W },
-		{ W, _, _, _, W, _, B, _, _, _, _, _, _, _, _, _ },
-		{ _, _, _, _, _, _, T, _, _, _, _, _, _, _, _, _ },
-		{ _, _, _, W, W, W, W, W, W, T, _, _, _, _, _, W },
-		{ W, W, _, _, _, _, _, _, W, W, _, _, W, W, W, W }
-	};
-
-	// Undefine the short game object names defined above, so that you
-	// cannot use use them in your own code. Use of single-letter names/
-	// constants is never a good idea.
-	#undef _
-	#undef W
-	#undef T
-	#undef B
-
-	// Set the initial player location (for level 1).
-	player_row = 5;
-	player_col = 2;
-
-	// Make the player icon initially invisible.
-	player_visible = false;
-
-	// Copy the starting layout (level 1 map) to the board array, and flip
-	// all the rows.
-	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+		num_boxes_in_target++;
+	}
+}
+
+// This function reports the object(s) currently on a square to the render
+// backends, with any RENDER_* flags.
+static void render_square(uint8_t row, uint8_t col, uint8_t flags)
+{
+	render_cell(row, col, get_object(row, col) | flags);
+}
+
+// This function reports every square of the board and the player to the
+// render backends, which draw them at the next flush.
+static void render_board(void)
+{
+	render_status(RENDER_STATUS_BOARD_RESET, &render_map);
+	for (uint8_t row = 0; row < map.rows; row++)
 	{
-		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		for (uint8_t col = 0; col < map.columns; col++)
 		{
-			board[MATRIX_NUM_ROWS - 1 - row][col] =
-				lv1_layout[row][col];
+			render_square(row, col, 0);
 		}
 	}
+	render_square(player_row, player_col, RENDER_PLAYER);
+	render_status(RENDER_STATUS_MESSAGE, NULL);
+}
+
+// This function resets the history of player locations, starting it at the
+// current player location, and forgets the moves that could be undone.
+static void reset_history(void)
+{
+	coordinate_history[0] = player_row << 8 | player_col;
+	for (uint8_t i = 1; i < HISTORY_LENGTH; i++)
+	{
+		coordinate_history[i] = HISTORY_EMPTY;
+	}
+	hist_idx = 1;
+	undo_next = 0;
+	undo_count = 0;
+}
+
+// These functions unpack an entry of the player location history. Empty
+// entries read as row and column 255.
+static uint8_t history_row(uint8_t index)
+{
+	uint16_t entry = coordinate_history[index];
+	return entry == HISTORY_EMPTY ? 0xFF : entry >> 8;
+}
+
+static uint8_t history_col(uint8_t index)
+{
+	uint16_t entry = coordinate_history[index];
+	return entry == HISTORY_EMPTY ? 0xFF : entry & 0xFF;
+}
+
+// This function records a move so that it can be undone. Each move takes
+// four bits: the direction and whether a box was pushed.
+static void record_move(uint8_t direction, bool pushed)
+{
+	uint8_t record = direction | (pushed ? UNDO_PUSHED : 0);
+	uint8_t *byte = &undo_moves[undo_next / 2];
+	if (undo_next & 1)
+	{
+		*byte = (*byte & 0x0F) | (record << 4);
+	}
+	else
+	{
+		*byte = (*byte & 0xF0) | record;
+	}
+	undo_next = (undo_next + 1) % UNDO_DEPTH;
+	if (undo_count < UNDO_DEPTH)
+	{
+		undo_count++;
+	}
+}
+
+// This function initialises the global variables used to store the game
+// state, and renders the initial game display.
+void initialise_game(uint8_t level)
+{
+	load_level(level);
+
+	// Place the boxes and the player.
+	for (uint8_t row = 0; row < map.rows; row++)
+	{
+		for (uint8_t col = 0; col < map.columns; col++)
+		{
+			if (level_square(&map, row, col) & BOX)
+			{
+				place_box(row, col);
+			}
+		}
+	}
+	player_row = map.player_row;
+	player_col = map.player_col;
+	reset_history();
 
 	// Draw the game board (map).
-	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	render_board();
+	render_flush();
+}
+
+// This function shows a message in the message area of the terminal,
+// replacing the previous message. MSG_NONE just clears the message area.
+static void show_message(MessageId id)
+{
+	render_status(RENDER_STATUS_MESSAGE,
+		(const char *)pgm_read_ptr(&messages[id]));
+}
+
+// This function shows the recent player locations on the terminal (for
+// testing).
+static void show_history(uint8_t previous_row, uint8_t previous_col)
+{
+	RenderHistory history;
+	history.locations = coordinate_history;
+	history.length = HISTORY_LENGTH;
+	history.previous_row = previous_row;
+	history.previous_col = previous_col;
+	history.boxes_in_target = num_boxes_in_target;
+	render_status(RENDER_STATUS_HISTORY, &history);
+}
+
+uint8_t get_current_level(void)
+{
+	return current_level;
+}
+
+uint8_t get_num_levels(void)
+{
+	return NUM_LEVELS;
+}
+
+uint16_t get_level_par(uint8_t level)
+{
+	PackedLevel info;
+	read_level(level < NUM_LEVELS ? level : 0, &info);
+	return info.par;
+}
+
+void get_level_size(uint8_t level, uint8_t *rows, uint8_t *columns)
+{
+	PackedLevel info;
+	read_level(level < NUM_LEVELS ? level : 0, &info);
+	*rows = info.rows;
+	*columns = info.columns;
+}
+
+uint8_t get_level_object(uint8_t level, uint8_t row, uint8_t col)
+{
+	PackedLevel info;
+	read_level(level < NUM_LEVELS ? level : 0, &info);
+	if (row >= info.rows || col >= info.columns)
 	{
-		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		return ROOM;
+	}
+	return level_square(&info, row, col);
+}
+
+// This function lists the boxes, skipping the empty parts of each row a byte
+// at a time.
+void get_board_state(BoardState *state)
+{
+	uint8_t count = 0;
+	for (uint8_t row = 0; row < map.rows; row++)
+	{
+		for (uint8_t byte = 0; byte < MAP_MAX_COLUMNS / 8; byte++)
 		{
-			paint_square(row, col);
+			uint8_t bits = boxes[row][byte];
+			for (uint8_t col = byte * 8; bits; col++, bits >>= 1)
+			{
+				if ((bits & 1) && count < MAP_MAX_BOXES)
+				{
+					state->box_rows[count] = row;
+					state->box_cols[count] = col;
+					count++;
+				}
+			}
 		}
 	}
+	state->num_boxes = count;
+	state->player_row = player_row;
+	state->player_col = player_col;
+	state->level = current_level;
+}
+
+// This function starts the level saved by get_board_state() and moves the
+// boxes and player to where they were. The display task picks the cheapest
+// way to redraw the LED matrix.
+void restore_board_state(const BoardState *state)
+{
+	load_level(state->level);
+	for (uint8_t i = 0; i < state->num_boxes && i < MAP_MAX_BOXES; i++)
+	{
+		place_box(state->box_rows[i], state->box_cols[i]);
+	}
+	player_row = state->player_row;
+	player_col = state->player_col;
+	reset_history();
+
+	// Redraw every square. The player is shown straight away, and the
+	// flash cycle continues from there.
+	render_board();
+	render_flush();
 }
 
 void add_to_history(uint8_t row, uint8_t col) {
-	coordinate_history[hist_idx][0] = row;
-	coordinate_history[hist_idx][1] = col;
+	coordinate_history[hist_idx] = row << 8 | col;
 	if (hist_idx == 5) {
 		hist_idx = 0;
 		} else {
@@ -174,48 +481,126 @@ void add_to_history(uint8_t row, uint8_t col) {
 
 uint8_t get_previous_row() {
 	if (hist_idx == 5) {
-		return coordinate_history[0][0];
+		return history_row(0);
 	} else if (hist_idx == 0) {
-		return coordinate_history[5][0];
+		return history_row(5);
 	} else {
-		return coordinate_history[hist_idx - 1][0];
+		return history_row(hist_idx - 1);
 	}
 }
 
 uint8_t get_previous_col() {
 	if (hist_idx == 5) {
-		return coordinate_history[0][1];
+		return history_col(0);
 		} else if (hist_idx == 0) {
-		return coordinate_history[5][1];
+		return history_col(5);
 		} else {
-		return coordinate_history[hist_idx - 1][1];
+		return history_col(hist_idx - 1);
+	}
+}
+
+// This function returns the index in move_deltas of a move's deltas.
+static uint8_t move_direction(int8_t delta_row, int8_t delta_col)
+{
+	if (delta_row)
+	{
+		return delta_row > 0 ? 0 : 1;
 	}
+	return delta_col < 0 ? 2 : 3;
 }
 
-// This function flashes the player icon. If the icon is currently visible, it
-// is set to not visible and removed from the display. If the player icon is
-// currently not visible, it is set to visible and rendered on the display.
-// The static global variable "player_visible" indicates whether the player
-// icon is currently visible.
-void flash_player(void)
+// This function returns the row or column one step (delta is -1, 0 or 1)
+// from another, wrapping around the edges of the board like player moves do.
+static uint8_t step(uint8_t position, int8_t delta, uint8_t size)
 {
-	player_visible = !player_visible;
-	if (player_visible)
+	position += delta;
+	if (position == 0xFF)
 	{
-		// The player is visible, paint it with COLOUR_PLAYER.
-		ledmatrix_update_pixel(player_row, player_col, COLOUR_PLAYER);
+		return size - 1;
+	}
+	return position == size ? 0 : position;
+}
+
+static uint8_t step_row(uint8_t row, int8_t delta)
+{
+	return step(row, delta, map.rows);
+}
+
+static uint8_t step_col(uint8_t col, int8_t delta)
+{
+	return step(col, delta, map.columns);
+}
+
+
+// Tells the backends the level is complete if the move just made (or undone)
+// filled the last target. was_complete is whether it was complete before.
+static void report_level_complete(bool was_complete)
+{
+	if (!was_complete && is_game_over())
+	{
+		render_status(RENDER_STATUS_LEVEL_COMPLETE, NULL);
+		render_flush();
+	}
+}
+
+bool undo_move(void)
+{
+	if (undo_count == 0)
+	{
+		show_message(MSG_NOTHING_TO_UNDO);
+		render_flush();
+		return false;
+	}
+	bool was_complete = is_game_over();
+	undo_next = (undo_next + UNDO_DEPTH - 1) % UNDO_DEPTH;
+	undo_count--;
+	uint8_t record = undo_moves[undo_next / 2];
+	if (undo_next & 1)
+	{
+		record >>= 4;
+	}
+	const int8_t *delta = move_deltas[record & UNDO_DIRECTION_MASK];
+
+	// Step the player back, and pull the box back with it if the move
+	// pushed one.
+	uint8_t from_row = player_row;
+	uint8_t from_col = player_col;
+	player_row = step_row(player_row, -delta[0]);
+	player_col = step_col(player_col, -delta[1]);
+	if (record & UNDO_PUSHED)
+	{
+		uint8_t box_row = step_row(from_row, delta[0]);
+		uint8_t box_col = step_col(from_col, delta[1]);
+		uint8_t box_object = get_object(box_row, box_col);
+		uint8_t from_object = get_object(from_row, from_col);
+		if (box_object & TARGET)
+		{
+			num_boxes_in_target--;
+		}
+		if (from_object & TARGET)
+		{
+			num_boxes_in_target++;
+		}
+		set_object(box_row, box_col, box_object & ~BOX);
+		set_object(from_row, from_col, from_object | BOX);
+		render_square(box_row, box_col, RENDER_PUSHED);
+		render_square(from_row, from_col, RENDER_PUSHED);
 	}
 	else
 	{
-		// The player is not visible, paint the underlying square.
-		paint_square(player_row, player_col);
+		render_square(from_row, from_col, 0);
 	}
+	render_square(player_row, player_col, RENDER_PLAYER);
+	show_message(MSG_NONE);
+	render_flush();
+	report_level_complete(was_complete);
+	return true;
 }
 
 // This function handles player movements.
 // @requires -1 <= delta_row <= 1
 // @requires -1 <= delta_col <= 1
-bool move_player(int8_t delta_row, int8_t delta_col)
+static bool try_move(int8_t delta_row, int8_t delta_col)
 {
 	//                    Implementation Suggestions
 	//                    ==========================
@@ -272,219 +657,100 @@ bool move_player(int8_t delta_row, int8_t delta_col)
 	uint8_t previous_row = get_previous_row();;
 	uint8_t previous_col = get_previous_col();
  
-	uint8_t infront_next_row = player_row;
-	uint8_t infront_next_col = player_col;
-	
-	uint8_t next_row = player_row;
-	uint8_t next_col = player_col;
 	// if there is a wall on the next positon the player must not move to next position.
 	// if there is a box on the next position then the player and the box must move together.
 	// if there is a wall infront of the box, then the player and the box must not move together.
-	
-	if (delta_row) {
-		next_row += delta_row;
-		if (next_row > 200) { // player reaches row 0 and goes down
-			next_row = 7;
-			infront_next_row = 6;
-		} else if (next_row > 7) { // player reaches row 7 and goes up
-			next_row = 0;
-			infront_next_row = 1; 
-		} else if (next_row == 0) {
-			infront_next_row = 7;	
-		} else if (next_row == 7) {
-			infront_next_row = 0;
-		} else {
-			infront_next_row = next_row + delta_row;
-		}	
-	}
-	
-	if (delta_col) {
-		next_col += delta_col;
-		if (next_col > 200) { // player reaches column 0 and goes left
-			next_col = 15;
-			infront_next_col = 14;
-		} else if (next_col > 15) { // player reaches column 15 and goes right
-			next_col = 0;
-			infront_next_col = 1;
-		} else if (next_col == 0) {
-			infront_next_col = 15;
-		} else if (next_col == 15) {
-			infront_next_col = 0;
-		} else {
-			infront_next_col = next_col + delta_col;	
-		}	
-	}
+	// Both squares wrap around the edges of the map.
+	uint8_t next_row = step_row(player_row, delta_row);
+	uint8_t next_col = step_col(player_col, delta_col);
+	uint8_t infront_next_row = step_row(next_row, delta_row);
+	uint8_t infront_next_col = step_col(next_col, delta_col);
+	uint8_t next_object = get_object(next_row, next_col);
+	uint8_t infront_object = get_object(infront_next_row, infront_next_col);
+	bool pushed = false;
+	MessageId message = MSG_NONE;
+
 	// If the next row or column is a wall the move is invalid
-	if (board[next_row][next_col] == WALL) {
-		move_terminal_cursor(TERMINAL_E_ROW, TERMINAL_E_COL);
-		clear_to_end_of_line();
-		int random_num = rand() % 3;
-		if (random_num == 0) {
-			printf_P(PSTR("The player hit a wall!"));
-		} else if (random_num == 1) {
-			printf_P(PSTR("Player can't move through walls."));
-		} else {
-			printf_P(PSTR("The wall is obstructing you."));
-		}
-		flash_player();
+	if (next_object == WALL) {
+		// Pick one of the three wall messages at random.
+		show_message(MSG_HIT_WALL + rand() % 3);
 		return false; // don't move
 
 	// If the next row/column is a box or box target.
 	// Player cant move box through walls or boxes.
 	// There is a box or a box in a target in front of the player.
 	// Player can move box out of target or move box into target.
-	} else if (board[next_row][next_col] == BOX || board[next_row][next_col] == (BOX | TARGET)) {
-		if (board[infront_next_row][infront_next_col] == WALL) {
-			move_terminal_cursor(TERMINAL_E_ROW, TERMINAL_E_COL);
-			printf_P(PSTR("You can't push a box through a wall!"));
+	} else if (next_object == BOX || next_object == (BOX | TARGET)) {
+		if (infront_object == WALL) {
+			show_message(MSG_BOX_INTO_WALL);
 			return false; // don't move
-		} else if (board[infront_next_row][infront_next_col] == BOX || board[infront_next_row][infront_next_col] == (BOX | TARGET)) {
-			move_terminal_cursor(TERMINAL_E_ROW, TERMINAL_E_COL);
-			printf_P(PSTR("You can't push two boxes at once!"));
+		} else if (infront_object == BOX || infront_object == (BOX | TARGET)) {
+			show_message(MSG_TWO_BOXES);
 			return false; // don't move
 		} else {
 			// player and box move
-			if (board[infront_next_row][infront_next_col] == TARGET) {
-				board[next_row][next_col] = ROOM;
-				board[infront_next_row][infront_next_col] = (BOX | TARGET);
-				set_complete_terminal(infront_next_row, infront_next_col);
-				move_terminal_cursor(TERMINAL_E_ROW, TERMINAL_E_COL);
-				printf_P(PSTR("Box was moved to target."));	
-				num_boxes_in_target++;
-			} else if (board[next_row][next_col] == (BOX | TARGET)) {
-				board[next_row][next_col] = TARGET;
-				board[infront_next_row][infront_next_col] = BOX;	
-				move_box_terminal(infront_next_row, infront_next_col);
+			pushed = true;
+			if (infront_object == TARGET) {
+				// A box pushed from one target straight onto another
+				// leaves a target behind and doesn't change the count.
+				if (next_object == (BOX | TARGET)) {
+					set_object(next_row, next_col, TARGET);
+				} else {
+					set_object(next_row, next_col, ROOM);
+					num_boxes_in_target++;
+				}
+				set_object(infront_next_row, infront_next_col, (BOX | TARGET));
+				message = MSG_BOX_ON_TARGET;
+			} else if (next_object == (BOX | TARGET)) {
+				set_object(next_row, next_col, TARGET);
+				set_object(infront_next_row, infront_next_col, BOX);	
 				num_boxes_in_target--;
 			} else {
-				board[next_row][next_col] = ROOM;
-				board[infront_next_row][infront_next_col] = BOX;
-				move_box_terminal(infront_next_row, infront_next_col);
+				set_object(next_row, next_col, ROOM);
+				set_object(infront_next_row, infront_next_col, BOX);
 			}
-			paint_square(next_row, next_col);
-			paint_square(infront_next_row, infront_next_col);
+			// The box slides across by fading out of its
+			// old square while fading into the new one.
+			render_square(next_row, next_col, RENDER_PUSHED);
+			render_square(infront_next_row, infront_next_col,
+				RENDER_PUSHED);
 		}
 	}
 	
 	// Move the player
-	if (board[infront_next_row][infront_next_col] != (BOX | TARGET)) {
-		move_terminal_cursor(TERMINAL_E_ROW, TERMINAL_E_COL);
-		clear_to_end_of_line();
-	}
-	paint_square(player_row, player_col);
-	delete_old_terminal(player_row, player_col);
-	if (board[player_row][player_col] == TARGET) {
-		set_target_terminal(player_row, player_col);
-	}
+	show_message(message);
+	record_move(move_direction(delta_row, delta_col), pushed);
+	render_square(player_row, player_col, 0);
 	player_row = next_row;
 	player_col = next_col;
-	move_player_terminal(player_row, player_col);
-	flash_player();
+	render_square(player_row, player_col, RENDER_PLAYER);
 	add_to_history(player_row, player_col);
 
 	// testing
-	move_terminal_cursor(0, 60);
-	clear_to_end_of_line();
-	printf_P(PSTR("row %d, col %d"), coordinate_history[0][0], coordinate_history[0][1]);
-	move_terminal_cursor(1, 60);
-	clear_to_end_of_line();
-	printf_P(PSTR("row %d, col %d"), coordinate_history[1][0], coordinate_history[1][1]);
-	move_terminal_cursor(2, 60);
-	clear_to_end_of_line();
-	printf_P(PSTR("row %d, col %d"), coordinate_history[2][0], coordinate_history[2][1]);
-	move_terminal_cursor(3, 60);
-	clear_to_end_of_line();
-	printf_P(PSTR("row %d, col %d"), coordinate_history[3][0], coordinate_history[3][1]);
-	move_terminal_cursor(4, 60);
-	clear_to_end_of_line();
-	printf_P(PSTR("row %d, col %d"), coordinate_history[4][0], coordinate_history[4][1]);
-	move_terminal_cursor(5, 60);
-	clear_to_end_of_line();
-	printf_P(PSTR("row %d, col %d"), coordinate_history[5][0], coordinate_history[5][1]);
-	move_terminal_cursor(6, 60);
-	clear_to_end_of_line();
-	printf_P(PSTR("pre row %d, pre col %d"), previous_row, previous_col);
-	move_terminal_cursor(7, 60);
-	clear_to_end_of_line();
-	printf_P(PSTR("b in t: %d"), num_boxes_in_target);
+	show_history(previous_row, previous_col);
 
 	return true;	
 }
 
-void delete_old_terminal(uint8_t row, uint8_t col) {
-	move_terminal_cursor(TERMINAL_GAME_ROW + (-row) + 7 , TERMINAL_GAME_COL + col);
-	set_display_attribute(BG_BLACK);
-	putchar(' ');
-	set_display_attribute(TERM_RESET);
-}
-
-void move_player_terminal(uint8_t next_row, uint8_t next_col) {
-	move_terminal_cursor(TERMINAL_GAME_ROW + (-next_row) + 7 , TERMINAL_GAME_COL + next_col);
-	set_display_attribute(BG_WHITE);
-	putchar(' ');
-	set_display_attribute(TERM_RESET);
-}
-
-void move_box_terminal(uint8_t next_row, uint8_t next_col) {
-	move_terminal_cursor(TERMINAL_GAME_ROW + (-next_row) + 7 , TERMINAL_GAME_COL + next_col);
-	set_display_attribute(BG_CYAN);
-	putchar(' ');
-	set_display_attribute(TERM_RESET);
-}
-
-void set_target_terminal(uint8_t next_row, uint8_t next_col) {
-	move_terminal_cursor(TERMINAL_GAME_ROW + (-next_row) + 7 , TERMINAL_GAME_COL + next_col);
-	set_display_attribute(BG_RED);
-	putchar(' ');
-	set_display_attribute(TERM_RESET);
-}
-
-void set_complete_terminal(uint8_t next_row, uint8_t next_col) {
-	move_terminal_cursor(TERMINAL_GAME_ROW + (-next_row) + 7 , TERMINAL_GAME_COL + next_col);
-	set_display_attribute(BG_GREEN);
-	putchar(' ');
-	set_display_attribute(TERM_RESET);
+bool move_player(int8_t delta_row, int8_t delta_col)
+{
+	// The backends draw everything the move changed in one go.
+	bool was_complete = is_game_over();
+	bool valid = try_move(delta_row, delta_col);
+	render_flush();
+	report_level_complete(was_complete);
+	return valid;
 }
 
-void display_board_terminal() {
-	normal_display_mode();
-
-	// show player	
-	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
-	{
-		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
-		{
-			move_terminal_cursor(TERMINAL_GAME_ROW + row, TERMINAL_GAME_COL + col);
-			if (board[MATRIX_NUM_ROWS - 1 - row][col] == ROOM) {
-				set_display_attribute(BG_BLACK); // room is black
-
-			} else if (board[MATRIX_NUM_ROWS - 1 - row][col] == WALL) {
-				set_display_attribute(BG_YELLOW); // wall is yellow
-
-			} else if (board[MATRIX_NUM_ROWS - 1 - row][col] == TARGET) {
-				set_display_attribute(BG_RED); // target is red
-
-			} else if (board[MATRIX_NUM_ROWS - 1 - row][col] == BOX) {
-				set_display_attribute(BG_CYAN); // box is cyan
-			}
-			putchar(' ');
-		}
-	}
-	
-	move_terminal_cursor(TERMINAL_GAME_ROW + (-player_row + 7) , TERMINAL_GAME_COL + player_col);
-	set_display_attribute(BG_WHITE);
-	putchar(' ');
-	set_display_attribute(TERM_RESET);
+void redraw_board(void)
+{
+	render_board();
+	render_flush();
 }
 
 // This function checks if the game is over (i.e., the level is solved), and
 // returns true iff (if and only if) the game is over.
 bool is_game_over(void)
 {
-	if (num_boxes_in_target == 5) {
-		paint_square(player_row, player_col);
-		return true;
-	}
-	return false;
-	
+	return num_boxes_in_target == num_boxes;
 }
@@ -14,6 +14,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "ledmatrix.h"
 
 // Object definitions.
 #define ROOM       	(0U << 0)
@@ -29,10 +30,35 @@
 #define COLOUR_TARGET	(COLOUR_RED)
 #define COLOUR_DONE  	(COLOUR_GREEN)
 
+// Most levels there can be, so that each can be picked with a single digit.
+#define MAX_LEVELS	(9)
+
+// Largest map a level can have. The LED matrix shows the part of a larger
+// map around the player, and the terminal shows the whole map.
+#define MAP_MAX_ROWS   	(32)
+#define MAP_MAX_COLUMNS	(32)
+
+// Most boxes a level can have.
+#define MAP_MAX_BOXES	(16)
+
+// Compact copy of the game in progress. The walls and targets never change
+// during a level, so only the boxes and the player location are kept. The
+// boxes are listed in no particular order.
+typedef struct
+{
+	uint8_t box_rows[MAP_MAX_BOXES];
+	uint8_t box_cols[MAP_MAX_BOXES];
+	uint8_t num_boxes;
+	uint8_t player_row;
+	uint8_t player_col;
+	uint8_t level;
+} BoardState;
+
 /// <summary>
-/// Initialises the game.
+/// Initialises the game, starting a level.
 /// </summary>
-void initialise_game(void);
+/// <param name="level">The level to play (0-based).</param>
+void initialise_game(uint8_t level);
 
 /// <summary>
 /// Moves the player based on row and column deltas.
@@ -41,6 +67,13 @@ void initialise_game(void);
 /// <param name="delta_col">The column delta.</param>
 bool move_player(int8_t delta_row, int8_t delta_col);
 
+/// <summary>
+/// Undoes the last move, pulling back the box it pushed (if any). Up to the
+/// last 128 moves can be undone.
+/// </summary>
+/// <returns>Whether there was a move to undo.</returns>
+bool undo_move(void);
+
 /// <summary>
 /// Detects whether the game is over (i.e., current level solved).
 /// </summary>
@@ -48,15 +81,60 @@ bool move_player(int8_t delta_row, int8_t delta_col);
 bool is_game_over(void);
 
 /// <summary>
-/// Flashes the player icon.
+/// Gets the level currently being played.
 /// </summary>
-void flash_player(void);
+/// <returns>The level number (0-based).</returns>
+uint8_t get_current_level(void);
 
-void display_board(void);
+/// <summary>
+/// Gets the number of levels in the level pack (see level_format.h).
+/// </summary>
+/// <returns>The number of levels.</returns>
+uint8_t get_num_levels(void);
+
+/// <summary>
+/// Gets the par of a level, the fewest moves that solve it.
+/// </summary>
+/// <param name="level">The level number (0-based).</param>
+/// <returns>The par, or 0 if it isn't known.</returns>
+uint16_t get_level_par(uint8_t level);
+
+/// <summary>
+/// Gets the size of a level's map.
+/// </summary>
+/// <param name="level">The level number (0-based).</param>
+/// <param name="rows">Set to the number of rows.</param>
+/// <param name="columns">Set to the number of columns.</param>
+void get_level_size(uint8_t level, uint8_t *rows, uint8_t *columns);
+
+/// <summary>
+/// Gets the object(s) on a square of a level at the start of the level.
+/// </summary>
+/// <param name="level">The level number (0-based).</param>
+/// <param name="row">The row of the square (0 is the bottom row).</param>
+/// <param name="col">The column of the square.</param>
+/// <returns>The object(s) on the square.</returns>
+uint8_t get_level_object(uint8_t level, uint8_t row, uint8_t col);
+
+/// <summary>
+/// Copies the boxes and player location into a BoardState.
+/// </summary>
+/// <param name="state">The BoardState to fill in.</param>
+void get_board_state(BoardState *state);
 
-void move_player_terminal(uint8_t delta_row, uint8_t delta_col);
+/// <summary>
+/// Starts the level saved in a BoardState with the boxes and player location
+/// from it, and redraws the board.
+/// </summary>
+/// <param name="state">The BoardState to restore.</param>
+void restore_board_state(const BoardState *state);
 
-void delete_old_terminal(uint8_t row, uint8_t col);
-void move_box_terminal(uint8_t next_row, uint8_t next_col);
+void display_board(void);
+
+/// <summary>
+/// Redraws the whole board and the player, for example after the terminal
+/// has been cleared. Any message is cleared.
+/// </summary>
+void redraw_board(void);
 
 #endif /* GAME_H_ */
@@ -0,0 +1,194 @@
+/*
+ * highscore.c
+ *
+ * Author: Sithika Mannakkara
+ */
+
+#include "highscore.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include "eeprom_async.h"
+
+// A record as stored in EEPROM. The sequence number is incremented on each
+// write, so the most recent record in a level's log is the one with the
+// highest sequence number (allowing for wrap around).
+typedef struct
+{
+	uint8_t sequence;
+	uint16_t best_score;
+	uint16_t best_moves;
+	uint16_t best_time;
+	uint8_t checksum;
+} HighScoreRecord;
+
+// Each level has a log of LOG_SLOTS records. A new record is written to the
+// slot after the most recent one, wrapping around at the end of the log.
+// RECORD_SIZE must match sizeof(HighScoreRecord) (structures are packed).
+#define RECORD_SIZE	(8)
+#define LOG_SLOTS	(8)
+#define LOG_SIZE	(LOG_SLOTS * RECORD_SIZE)
+
+#if HIGHSCORE_NUM_LEVELS * LOG_SIZE > EEPROM_HIGHSCORE_SIZE
+#error "High score logs do not fit in the EEPROM region reserved for them"
+#endif
+#if HIGHSCORE_NUM_LEVELS > 16
+#error "Too many levels for the dirty level mask"
+#endif
+
+// The current records and the slot the next record for each level will be
+// written to.
+static HighScoreRecord records[HIGHSCORE_NUM_LEVELS];
+static uint8_t next_slot[HIGHSCORE_NUM_LEVELS];
+
+// Bit mask of the levels whose records have changed but have not been queued
+// for writing yet.
+static uint16_t dirty_levels;
+
+// The record being written. It is kept separate from the table so that the
+// table can change while the write is in progress.
+static HighScoreRecord write_buffer;
+static EepromJob write_job;
+
+// Calculates the checksum of a record (covering all fields but the checksum).
+static uint8_t record_checksum(const HighScoreRecord *record)
+{
+	const uint8_t *bytes = (const uint8_t *)record;
+	uint8_t crc = 0;
+	for (uint8_t i = 0; i < sizeof(HighScoreRecord) - 1; i++)
+	{
+		crc = _crc8_ccitt_update(crc, bytes[i]);
+	}
+	return crc;
+}
+
+static uint16_t slot_address(uint8_t level, uint8_t slot)
+{
+	return EEPROM_HIGHSCORE_BASE + level * LOG_SIZE +
+		slot * RECORD_SIZE;
+}
+
+void init_highscores(void)
+{
+	dirty_levels = 0;
+	write_job.pending = false;
+
+	for (uint8_t level = 0; level < HIGHSCORE_NUM_LEVELS; level++)
+	{
+		// Default to an empty record, which is replaced by the most
+		// recent valid record in the log (if there are any).
+		records[level].sequence = 0xFF;
+		records[level].best_score = 0;
+		records[level].best_moves = HIGHSCORE_NONE;
+		records[level].best_time = HIGHSCORE_NONE;
+		next_slot[level] = 0;
+
+		bool found = false;
+		for (uint8_t slot = 0; slot < LOG_SLOTS; slot++)
+		{
+			HighScoreRecord record;
+			eeprom_read_block(&record,
+				(const void *)slot_address(level, slot),
+				sizeof(record));
+			if (record.checksum != record_checksum(&record))
+			{
+				// Erased or partially written slot.
+				continue;
+			}
+
+			// Sequence numbers wrap around, but the log is short
+			// enough that the newer of two records is always less
+			// than half the sequence range ahead.
+			if (!found || (uint8_t)(record.sequence -
+				records[level].sequence) < 0x80)
+			{
+				records[level] = record;
+				next_slot[level] = (slot + 1) % LOG_SLOTS;
+				found = true;
+			}
+		}
+	}
+}
+
+bool highscore_submit(uint8_t level, uint16_t score, uint16_t moves,
+	uint16_t time)
+{
+	if (level >= HIGHSCORE_NUM_LEVELS)
+	{
+		return false;
+	}
+
+	HighScoreRecord *record = &records[level];
+	bool new_high_score = false;
+	if (score > record->best_score)
+	{
+		record->best_score = score;
+		new_high_score = true;
+		dirty_levels |= (1U << level);
+	}
+	if (moves < record->best_moves)
+	{
+		record->best_moves = moves;
+		dirty_levels |= (1U << level);
+	}
+	if (time < record->best_time)
+	{
+		record->best_time = time;
+		dirty_levels |= (1U << level);
+	}
+
+	highscore_update();
+	return new_high_score;
+}
+
+uint16_t highscore_get_best_score(uint8_t level)
+{
+	return level < HIGHSCORE_NUM_LEVELS ? records[level].best_score : 0;
+}
+
+uint16_t highscore_get_best_moves(uint8_t level)
+{
+	return level < HIGHSCORE_NUM_LEVELS ? records[level].best_moves :
+		HIGHSCORE_NONE;
+}
+
+uint16_t highscore_get_best_time(uint8_t level)
+{
+	return level < HIGHSCORE_NUM_LEVELS ? records[level].best_time :
+		HIGHSCORE_NONE;
+}
+
+void highscore_update(void)
+{
+	if (dirty_levels == 0 || write_job.pending)
+	{
+		return;
+	}
+
+	// Find the lowest numbered level with a changed record.
+	uint8_t level = 0;
+	while (!(dirty_levels & (1U << level)))
+	{
+		level++;
+	}
+	dirty_levels &= ~(1U << level);
+
+	// Stamp the record with the next sequence number and append it to the
+	// level's log.
+	records[level].sequence++;
+	records[level].checksum = record_checksum(&records[level]);
+	write_buffer = records[level];
+
+	write_job.address = slot_address(level, next_slot[level]);
+	write_job.data = (const uint8_t *)&write_buffer;
+	write_job.length = sizeof(write_buffer);
+	(void)eeprom_async_submit(&write_job);
+
+	next_slot[level] = (next_slot[level] + 1) % LOG_SLOTS;
+}
+
+bool highscore_is_saved(void)
+{
+	return dirty_levels == 0 && !write_job.pending;
+}
@@ -0,0 +1,83 @@
+/*
+ * highscore.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Persistent table of the best score, fewest moves and fastest time for each
+ * level. The table is kept in SRAM and backed by EEPROM. Each level has its
+ * own rotating log of records in EEPROM, so repeatedly beating the record on
+ * one level spreads the writes over several cells instead of wearing out a
+ * single one. Writes are made through the interrupt driven EEPROM writer and
+ * never block.
+ */
+
+#ifndef HIGHSCORE_H_
+#define HIGHSCORE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "game.h"
+
+// Number of levels records are kept for: as many as a level pack can hold.
+#define HIGHSCORE_NUM_LEVELS	(MAX_LEVELS)
+
+// Value returned for the best moves/time of a level that has never been
+// completed.
+#define HIGHSCORE_NONE	(0xFFFF)
+
+/// <summary>
+/// Loads the high score table from EEPROM. This function blocks while the
+/// EEPROM is read, and must be called after init_eeprom_async() and before
+/// any of the other high score functions. This function should only be
+/// called once.
+/// </summary>
+void init_highscores(void);
+
+/// <summary>
+/// Submits the result of a completed level. Any records beaten are updated
+/// immediately in the table, and are written to EEPROM in the background.
+/// </summary>
+/// <param name="level">The level number (0-based).</param>
+/// <param name="score">The score achieved.</param>
+/// <param name="moves">The number of moves taken.</param>
+/// <param name="time">The time taken in seconds.</param>
+/// <returns>Whether the score was a new high score for the level.</returns>
+bool highscore_submit(uint8_t level, uint16_t score, uint16_t moves,
+	uint16_t time);
+
+/// <summary>
+/// Gets the best score for a level.
+/// </summary>
+/// <param name="level">The level number (0-based).</param>
+/// <returns>The best score, or 0 if the level has never been completed.
+/// </returns>
+uint16_t highscore_get_best_score(uint8_t level);
+
+/// <summary>
+/// Gets the fewest moves a level has been completed in.
+/// </summary>
+/// <param name="level">The level number (0-based).</param>
+/// <returns>The fewest moves, or HIGHSCORE_NONE.</returns>
+uint16_t highscore_get_best_moves(uint8_t level);
+
+/// <summary>
+/// Gets the fastest time a level has been completed in.
+/// </summary>
+/// <param name="level">The level number (0-based).</param>
+/// <returns>The fastest time in seconds, or HIGHSCORE_NONE.</returns>
+uint16_t highscore_get_best_time(uint8_t level);
+
+/// <summary>
+/// Queues the next changed record for writing to EEPROM, if the previous
+/// write has finished. Should be called regularly from the main loop until
+/// highscore_is_saved() returns true.
+/// </summary>
+void highscore_update(void);
+
+/// <summary>
+/// Tests whether all changes to the table have been written to EEPROM.
+/// </summary>
+/// <returns>Whether the table has been saved.</returns>
+bool highscore_is_saved(void);
+
+#endif /* HIGHSCORE_H_ */
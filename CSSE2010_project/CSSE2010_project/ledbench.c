@@ -0,0 +1,98 @@
+/*
+ * ledbench.c
+ *
+ * Author: Sithika Mannakkara
+ */
+
+#include "ledbench.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "ledmatrix.h"
+#include "pixel_colour.h"
+#include "terminalio.h"
+#include "timer0.h"
+
+// How long each test runs for, in milliseconds.
+#define TEST_TIME	(250)
+
+// Settings to try. Each divider is tried with each gap (in microseconds),
+// where the gap is used after every byte.
+static const uint8_t dividers[] = { 128, 64, 32, 16, 8, 4, 2 };
+static const uint8_t byte_gaps[] = { 0, 4, 16 };
+
+#define countof(array)	(sizeof(array) / sizeof((array)[0]))
+
+// Colour of a pixel in one of the two checkerboard test patterns.
+static PixelColour pattern_colour(uint8_t row, uint8_t col, uint8_t phase)
+{
+	return ((row + col + phase) & 1) ? COLOUR_RED : COLOUR_GREEN;
+}
+
+// Sends single pixel updates for TEST_TIME ms. Returns the number sent.
+static uint32_t time_pixels(void)
+{
+	uint32_t count = 0;
+	uint32_t start = get_current_time();
+	while (get_current_time() - start < TEST_TIME)
+	{
+		uint8_t row = (count >> 4) & 7;
+		uint8_t col = count & 15;
+		ledmatrix_update_pixel(row, col,
+			pattern_colour(row, col, count >> 7));
+		count++;
+	}
+	return count;
+}
+
+// Sends full frame updates for TEST_TIME ms. Returns the number sent.
+static uint32_t time_frames(void)
+{
+	MatrixData frames[2];
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			frames[0][row][col] = pattern_colour(row, col, 0);
+			frames[1][row][col] = pattern_colour(row, col, 1);
+		}
+	}
+
+	uint32_t count = 0;
+	uint32_t start = get_current_time();
+	while (get_current_time() - start < TEST_TIME)
+	{
+		ledmatrix_update_all(frames[count & 1]);
+		count++;
+	}
+	return count;
+}
+
+void run_ledmatrix_benchmark(void)
+{
+	clear_terminal();
+	move_terminal_cursor(1, 1);
+	printf_P(PSTR("LED matrix benchmark (%d ms per test)\n\n"), TEST_TIME);
+	printf_P(PSTR("divider  gap(us)  pixels/s  frames/s\n"));
+
+	for (uint8_t i = 0; i < countof(dividers); i++)
+	{
+		for (uint8_t j = 0; j < countof(byte_gaps); j++)
+		{
+			ledmatrix_set_speed(dividers[i], byte_gaps[j], 0);
+			ledmatrix_clear();
+			uint32_t pixels = time_pixels();
+			uint32_t frames = time_frames();
+			printf_P(PSTR("%7d  %7d  %8lu  %8lu\n"), dividers[i],
+				byte_gaps[j], pixels * 1000 / TEST_TIME,
+				frames * 1000 / TEST_TIME);
+		}
+	}
+
+	ledmatrix_set_speed(LEDMATRIX_CLOCK_DIVIDER, LEDMATRIX_BYTE_GAP,
+		LEDMATRIX_COMMAND_GAP);
+	ledmatrix_clear();
+	printf_P(PSTR("\nCurrent setting: divider %d, byte gap %d us, "
+		"command gap %d us\n"), LEDMATRIX_CLOCK_DIVIDER,
+		LEDMATRIX_BYTE_GAP, LEDMATRIX_COMMAND_GAP);
+}
@@ -0,0 +1,25 @@
+/*
+ * ledbench.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Benchmark for the LED matrix SPI settings. Every combination of clock
+ * divider and gap is timed sending single pixel updates and full frames, and
+ * the sustained rates are printed on the terminal. The test pattern flips
+ * colour on every frame, so a setting which is too fast for the LED matrix
+ * shows up as a garbled or frozen pattern while it is being timed. The
+ * fastest setting that displays cleanly can then be made the default in
+ * ledmatrix.h.
+ */
+
+#ifndef LEDBENCH_H_
+#define LEDBENCH_H_
+
+/// <summary>
+/// Runs the LED matrix benchmark. This function blocks for about ten
+/// seconds and leaves the LED matrix cleared and using the default SPI
+/// settings. Interrupts must be enabled.
+/// </summary>
+void run_ledmatrix_benchmark(void);
+
+#endif /* LEDBENCH_H_ */
@@ -6,6 +6,7 @@
 
 #include "ledmatrix.h"
 #include <stdint.h>
+#include <util/delay_basic.h>
 #include "spi.h"
 #include "pixel_colour.h"
 
@@ -16,23 +17,65 @@
 #define CMD_SHIFT_DISPLAY	(0x04)
 #define CMD_CLEAR_SCREEN	(0x0F)
 
+// Delays used to pace the LED matrix, as counts for _delay_loop_1() (which
+// takes 3 clock cycles per count). 0 means no delay.
+static uint8_t byte_gap_loops;
+static uint8_t command_gap_loops;
+
+// System clock rate in MHz.
+#define SYSCLK_MHZ	(8)
+
+static uint8_t gap_loops(uint8_t microseconds)
+{
+	return (uint16_t)microseconds * SYSCLK_MHZ / 3;
+}
+
+// Sends a byte of a command, followed by the byte gap.
+static void send_byte(uint8_t byte)
+{
+	(void)spi_send_byte(byte);
+	if (byte_gap_loops)
+	{
+		_delay_loop_1(byte_gap_loops);
+	}
+}
+
+// Ends a command with the command gap.
+static void end_command(void)
+{
+	if (command_gap_loops)
+	{
+		_delay_loop_1(command_gap_loops);
+	}
+}
+
 void init_ledmatrix(void)
 {
-	// Setup SPI, with a clock devider of 128. This speed guarantees the
-	// SPI buffer will never overflow on the LED matrix.
-	spi_setup_master(128);
+	// Setup SPI. The default clock divider of 128 guarantees the SPI buffer
+	// will never overflow on the LED matrix.
+	ledmatrix_set_speed(LEDMATRIX_CLOCK_DIVIDER, LEDMATRIX_BYTE_GAP,
+		LEDMATRIX_COMMAND_GAP);
+}
+
+void ledmatrix_set_speed(uint8_t clockdivider, uint8_t byte_gap,
+	uint8_t command_gap)
+{
+	spi_setup_master(clockdivider);
+	byte_gap_loops = gap_loops(byte_gap);
+	command_gap_loops = gap_loops(command_gap);
 }
 
 void ledmatrix_update_all(MatrixData data)
 {
-	(void)spi_send_byte(CMD_UPDATE_ALL);
+	send_byte(CMD_UPDATE_ALL);
 	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
 	{
 		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
 		{
-			(void)spi_send_byte(data[row][col]);
+			send_byte(data[row][col]);
 		}
 	}
+	end_command();
 }
 
 void ledmatrix_update_pixel(uint8_t row, uint8_t col, PixelColour pixel)
@@ -42,9 +85,10 @@ void ledmatrix_update_pixel(uint8_t row, uint8_t col, PixelColour pixel)
 		// Invalid location, ignore the request.
 		return;
 	}
-	(void)spi_send_byte(CMD_UPDATE_PIXEL);
-	(void)spi_send_byte(((row & 0x07) << 4) | (col & 0x0F));
-	(void)spi_send_byte(pixel);
+	send_byte(CMD_UPDATE_PIXEL);
+	send_byte(((row & 0x07) << 4) | (col & 0x0F));
+	send_byte(pixel);
+	end_command();
 }
 
 void ledmatrix_update_row(uint8_t row, MatrixRow data)
@@ -54,12 +98,13 @@ void ledmatrix_update_row(uint8_t row, MatrixRow data)
 		// Invalid row number, ignore the request.
 		return;
 	}
-	(void)spi_send_byte(CMD_UPDATE_ROW);
-	(void)spi_send_byte(row & 0x07);
+	send_byte(CMD_UPDATE_ROW);
+	send_byte(row & 0x07);
 	for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
 	{
-		(void)spi_send_byte(data[col]);
+		send_byte(data[col]);
 	}
+	end_command();
 }
 
 void ledmatrix_update_column(uint8_t col, MatrixColumn data)
@@ -69,41 +114,47 @@ void ledmatrix_update_column(uint8_t col, MatrixColumn data)
 		// Invalid column number, ignore the request.
 		return;
 	}
-	(void)spi_send_byte(CMD_UPDATE_COL);
-	(void)spi_send_byte(col & 0x0F);
+	send_byte(CMD_UPDATE_COL);
+	send_byte(col & 0x0F);
 	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
 	{
-		(void)spi_send_byte(data[row]);
+		send_byte(data[row]);
 	}
+	end_command();
 }
 
 void ledmatrix_shift_display_left(void)
 {
-	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x02);
+	send_byte(CMD_SHIFT_DISPLAY);
+	send_byte(0x02);
+	end_command();
 }
 
 void ledmatrix_shift_display_right(void)
 {
-	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x01);
+	send_byte(CMD_SHIFT_DISPLAY);
+	send_byte(0x01);
+	end_command();
 }
 
 void ledmatrix_shift_display_up(void)
 {
-	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x08);
+	send_byte(CMD_SHIFT_DISPLAY);
+	send_byte(0x08);
+	end_command();
 }
 
 void ledmatrix_shift_display_down(void)
 {
-	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x04);
+	send_byte(CMD_SHIFT_DISPLAY);
+	send_byte(0x04);
+	end_command();
 }
 
 void ledmatrix_clear(void)
 {
-	(void)spi_send_byte(CMD_CLEAR_SCREEN);
+	send_byte(CMD_CLEAR_SCREEN);
+	end_command();
 }
 
 void copy_matrix_column(MatrixColumn from, MatrixColumn to)
@@ -18,6 +18,16 @@
 #define MATRIX_NUM_ROWS   	(8)
 #define MATRIX_NUM_COLUMNS	(16)
 
+// SPI settings used by init_ledmatrix(). A clock divider of 128 with no gaps
+// guarantees the SPI buffer will never overflow on the LED matrix. Faster
+// settings may be used if the LED matrix keeps up with them, which can be
+// checked with the LED matrix benchmark (see ledbench.h). The byte gap is an
+// extra delay after every byte, the command gap an extra delay after every
+// command (both in microseconds).
+#define LEDMATRIX_CLOCK_DIVIDER	(128)
+#define LEDMATRIX_BYTE_GAP   	(0)
+#define LEDMATRIX_COMMAND_GAP	(0)
+
 // Data types which can be used to store display information.
 typedef PixelColour MatrixData[MATRIX_NUM_ROWS][MATRIX_NUM_COLUMNS];
 typedef PixelColour MatrixRow[MATRIX_NUM_COLUMNS];
@@ -30,6 +40,19 @@ typedef PixelColour MatrixColumn[MATRIX_NUM_ROWS];
 /// </summary>
 void init_ledmatrix(void);
 
+/// <summary>
+/// Changes the SPI clock divider and the delays used to pace updates to the
+/// LED matrix. Must not be called in the middle of sending a command.
+/// </summary>
+/// <param name="clockdivider">The SPI clock divider, should be one of 2, 4,
+/// 8, 16, 32, 64, 128.</param>
+/// <param name="byte_gap">Delay after each byte in microseconds (up to 95).
+/// </param>
+/// <param name="command_gap">Delay after each command in microseconds (up to
+/// 95).</param>
+void ledmatrix_set_speed(uint8_t clockdivider, uint8_t byte_gap,
+	uint8_t command_gap);
+
 
 //
 // Functions to update the display.
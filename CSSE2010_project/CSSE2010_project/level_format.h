@@ -0,0 +1,62 @@
+/*
+ * level_format.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Format of the levels in level_pack.h, which is generated by the host level
+ * pack compiler (tools/levelc.c) or level generator (tools/levelgen.c).
+ *
+ * A level's starting squares are kept in program memory in one of several
+ * encodings, whichever is smallest for that level while still being quick
+ * enough to look a square up in (the game reads the walls and targets from
+ * the level on every move). Squares are numbered row by row from the bottom
+ * left, i.e. square (row * columns + col), and each holds the WALL, BOX and
+ * TARGET bits of game.h. The player's starting square is kept separately.
+ */
+
+#ifndef LEVEL_FORMAT_H_
+#define LEVEL_FORMAT_H_
+
+#include <stdint.h>
+
+// Level encodings.
+//  - LEVEL_NIBBLES: a square per 4 bits, holding its object bits, with the
+//    even squares in the low bits of each byte.
+//  - LEVEL_CODES: a square per 2 bits, with the lowest square in the low
+//    bits of each byte, holding a LEVEL_CODE_* value. Levels with a box
+//    starting on a target can't use it.
+//  - LEVEL_RUNS: runs of squares with the same objects, a byte per run
+//    holding (objects << 5 | (length - 1)).
+//  - LEVEL_PLANES: the walls as a bit per square (square n in bit (n % 8)
+//    of byte n / 8), then the number of targets and their squares, then
+//    the number of boxes and their squares. Each square in the lists is
+//    two bytes: its row and column.
+#define LEVEL_NIBBLES	(0)
+#define LEVEL_CODES  	(1)
+#define LEVEL_RUNS   	(2)
+#define LEVEL_PLANES 	(3)
+#define LEVEL_NUM_ENCODINGS	(4)
+
+// Squares of the LEVEL_CODES encoding.
+#define LEVEL_CODE_ROOM  	(0)
+#define LEVEL_CODE_WALL  	(1)
+#define LEVEL_CODE_BOX   	(2)
+#define LEVEL_CODE_TARGET	(3)
+
+// Longest run of the LEVEL_RUNS encoding.
+#define LEVEL_MAX_RUN	(32)
+
+// A level. The par is the fewest moves that solve it, or 0 if it isn't
+// known.
+typedef struct
+{
+	uint8_t rows;
+	uint8_t columns;
+	uint8_t encoding;
+	uint8_t player_row;
+	uint8_t player_col;
+	uint16_t par;
+	const uint8_t *data;
+} PackedLevel;
+
+#endif /* LEVEL_FORMAT_H_ */
@@ -0,0 +1,121 @@
+/*
+ * level_pack.h
+ *
+ * Generated by tools/levelc from levels/written.xsb and levels/generated.xsb.
+ * Do not edit.
+ */
+
+#ifndef LEVEL_PACK_H_
+#define LEVEL_PACK_H_
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "level_format.h"
+
+#define LEVEL_PACK_SIZE	(8)
+
+// Level 1: The original level
+// LEVEL_CODES, 32 bytes, about 56 cycles to look up a square.
+static const uint8_t level1_data[] PROGMEM =
+{
+	0x05, 0x00, 0x05, 0x55, 0x40, 0x55, 0x0D, 0x40, 0x00, 0x30, 0x00, 0x00,
+	0x01, 0x21, 0x00, 0x00, 0x21, 0x40, 0x20, 0x48, 0x00, 0x00, 0x00, 0x00,
+	0x74, 0xD0, 0x08, 0x70, 0x44, 0x45, 0x05, 0x55
+};
+
+// Level 2: A 32x32 map, too large for the host solver
+// LEVEL_CODES, 256 bytes, about 56 cycles to look up a square.
+static const uint8_t level2_data[] PROGMEM =
+{
+	0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x01, 0x00, 0x40, 0x00,
+	0x00, 0x00, 0x00, 0x40, 0x81, 0x0C, 0x40, 0x00, 0x00, 0x00, 0x00, 0x40,
+	0x01, 0x00, 0x40, 0x00, 0x00, 0x00, 0x10, 0x40, 0x01, 0x00, 0x40, 0x20,
+	0x03, 0x00, 0x00, 0x40, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40,
+	0x01, 0x00, 0x40, 0x00, 0x00, 0x01, 0x00, 0x40, 0x01, 0x01, 0x40, 0x00,
+	0x00, 0x00, 0x00, 0x40, 0x01, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x40,
+	0x01, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x40, 0x55, 0x54, 0x55, 0x45,
+	0x55, 0x55, 0x51, 0x55, 0x01, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x40,
+	0x01, 0x00, 0x00, 0x00, 0x00, 0x10, 0x20, 0x43, 0x01, 0x00, 0x00, 0x00,
+	0x04, 0x00, 0x00, 0x40, 0x01, 0x00, 0x32, 0x00, 0x00, 0x10, 0x00, 0x40,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+	0x00, 0x10, 0x00, 0x40, 0x01, 0x04, 0x00, 0x01, 0x00, 0x10, 0x00, 0x40,
+	0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x32, 0x40, 0x01, 0x00, 0x00, 0x00,
+	0x00, 0x10, 0x00, 0x40, 0x01, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x40,
+	0x55, 0x45, 0x55, 0x55, 0x55, 0x54, 0x15, 0x55, 0x01, 0x00, 0x00, 0x40,
+	0x00, 0x00, 0x00, 0x40, 0x01, 0x32, 0x00, 0x40, 0x00, 0x00, 0x00, 0x40,
+	0x01, 0x00, 0x04, 0x40, 0x00, 0x00, 0x00, 0x40, 0x01, 0x00, 0x00, 0x40,
+	0x80, 0x0C, 0x00, 0x40, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40,
+	0x01, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00, 0x40, 0x01, 0x01, 0x00, 0x40,
+	0x00, 0x00, 0x04, 0x40, 0x01, 0x20, 0x03, 0x40, 0x00, 0x00, 0x00, 0x40,
+	0x01, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00, 0x40, 0x55, 0x55, 0x55, 0x55,
+	0x55, 0x55, 0x55, 0x55
+};
+
+// Level 3: Seed 1, candidate 7
+// LEVEL_CODES, 32 bytes, about 56 cycles to look up a square.
+static const uint8_t level3_data[] PROGMEM =
+{
+	0x51, 0x10, 0x44, 0x45, 0x31, 0x00, 0x00, 0x30, 0x81, 0x00, 0x00, 0x54,
+	0x01, 0x14, 0x15, 0x40, 0x03, 0x50, 0x01, 0x40, 0x08, 0x0C, 0x05, 0x81,
+	0x01, 0x00, 0x00, 0x49, 0x55, 0x50, 0x45, 0x51
+};
+
+// Level 4: Seed 1, candidate 89
+// LEVEL_PLANES, 34 bytes, about 141 cycles to look up a square.
+static const uint8_t level4_data[] PROGMEM =
+{
+	0xAF, 0xED, 0x01, 0x86, 0xC1, 0x83, 0x03, 0x8E, 0x81, 0x90, 0x01, 0x90,
+	0x03, 0x80, 0xFF, 0x85, 0x04, 0x02, 0x02, 0x02, 0x0B, 0x04, 0x05, 0x05,
+	0x0D, 0x04, 0x01, 0x04, 0x04, 0x02, 0x04, 0x05, 0x06, 0x0D
+};
+
+// Level 5: Seed 1, candidate 138
+// LEVEL_CODES, 32 bytes, about 56 cycles to look up a square.
+static const uint8_t level5_data[] PROGMEM =
+{
+	0x51, 0x55, 0x15, 0x54, 0x01, 0x00, 0x00, 0x40, 0x08, 0x07, 0x00, 0x48,
+	0xC1, 0x43, 0x00, 0x54, 0x25, 0x48, 0x00, 0x00, 0x00, 0x0C, 0x00, 0x40,
+	0x00, 0x00, 0x00, 0x40, 0x41, 0x05, 0x15, 0x45
+};
+
+// Level 6: Seed 1, candidate 252
+// LEVEL_CODES, 32 bytes, about 56 cycles to look up a square.
+static const uint8_t level6_data[] PROGMEM =
+{
+	0x55, 0x14, 0x15, 0x45, 0x05, 0x02, 0x00, 0x00, 0x20, 0x00, 0x00, 0x54,
+	0xCC, 0x50, 0x20, 0x50, 0x00, 0x00, 0x30, 0x50, 0x01, 0x20, 0x00, 0x40,
+	0x01, 0x00, 0x00, 0x0C, 0x05, 0x55, 0x05, 0x55
+};
+
+// Level 7: Seed 1, candidate 305
+// LEVEL_CODES, 32 bytes, about 56 cycles to look up a square.
+static const uint8_t level7_data[] PROGMEM =
+{
+	0x55, 0x55, 0x55, 0x55, 0x01, 0x01, 0x00, 0x00, 0x01, 0x10, 0x00, 0x48,
+	0x1D, 0x00, 0x0C, 0x40, 0x10, 0x20, 0x21, 0x49, 0x1D, 0x0C, 0x00, 0x41,
+	0x00, 0x00, 0x54, 0x40, 0x05, 0x55, 0x55, 0x45
+};
+
+// Level 8: Seed 1, candidate 332
+// LEVEL_CODES, 32 bytes, about 56 cycles to look up a square.
+static const uint8_t level8_data[] PROGMEM =
+{
+	0x15, 0x50, 0x54, 0x59, 0x55, 0x01, 0x00, 0x40, 0x15, 0x00, 0x03, 0x00,
+	0x01, 0x00, 0x30, 0x40, 0x81, 0x03, 0x0C, 0x40, 0x01, 0x00, 0x80, 0x40,
+	0x15, 0x00, 0x00, 0x48, 0x55, 0x55, 0x44, 0x51
+};
+
+// Rows, columns, encoding, player row and column, par and data.
+static const PackedLevel levels[LEVEL_PACK_SIZE] PROGMEM =
+{
+	{ 8, 16, LEVEL_CODES, 5, 2, 36, level1_data },
+	{ 32, 32, LEVEL_CODES, 16, 2, 0, level2_data },
+	{ 8, 16, LEVEL_CODES, 7, 13, 56, level3_data },
+	{ 8, 16, LEVEL_PLANES, 0, 4, 41, level4_data },
+	{ 8, 16, LEVEL_CODES, 2, 0, 47, level5_data },
+	{ 8, 16, LEVEL_CODES, 0, 4, 35, level6_data },
+	{ 8, 16, LEVEL_CODES, 4, 14, 73, level7_data },
+	{ 8, 16, LEVEL_CODES, 7, 13, 39, level8_data }
+};
+
+#endif /* LEVEL_PACK_H_ */
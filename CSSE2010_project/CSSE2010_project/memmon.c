@@ -0,0 +1,68 @@
+/*
+ * memmon.c
+ *
+ * Author: Sithika Mannakkara
+ */
+
+#include "memmon.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <avr/io.h>
+
+// Value painted over free SRAM. The stack peak is under-reported if a byte
+// the stack used happens to hold this value, but it is rarely written by
+// real code.
+#define STACK_PAINT	(0xC5)
+
+// Symbols defined by the linker (and by malloc(), if it is linked in).
+extern uint8_t __data_start;
+extern uint8_t __heap_start;
+extern uint8_t __stack;
+extern uint8_t *__brkval __attribute__((weak));
+
+// Paints SRAM from the end of the static variables to the top of the stack.
+// Runs in .init1, before the stack pointer and zero register are set up, so
+// it is written in assembly and must not use the stack.
+void paint_sram(void) __attribute__((naked, used, section(".init1")));
+void paint_sram(void)
+{
+	__asm__ volatile (
+		"	ldi r30, lo8(__heap_start)\n"
+		"	ldi r31, hi8(__heap_start)\n"
+		"	ldi r24, %0\n"
+		"	ldi r25, hi8(__stack)\n"
+		"	rjmp 2f\n"
+		"1:	st Z+, r24\n"
+		"2:	cpi r30, lo8(__stack)\n"
+		"	cpc r31, r25\n"
+		"	brlo 1b\n"
+		"	breq 1b\n"
+		:: "M" (STACK_PAINT));
+}
+
+void memmon_get(MemoryUsage *usage)
+{
+	uint8_t *heap_end = &__heap_start;
+	if (&__brkval != NULL && __brkval != NULL)
+	{
+		heap_end = __brkval;
+	}
+	uint8_t *stack_top = &__stack;
+	uint8_t *stack_pointer = (uint8_t *)SP;
+
+	// Find the lowest byte the stack has written to. Anything allocated
+	// from the heap has overwritten the paint, so start above it.
+	uint8_t *lowest = heap_end;
+	while (lowest <= stack_top && *lowest == STACK_PAINT)
+	{
+		lowest++;
+	}
+
+	usage->total = stack_top - &__data_start + 1;
+	usage->static_size = &__heap_start - &__data_start;
+	usage->heap = heap_end - &__heap_start;
+	usage->stack_now = stack_top - stack_pointer;
+	usage->stack_peak = stack_top + 1 - lowest;
+	usage->free_now = stack_pointer + 1 - heap_end;
+	usage->free_min = lowest - heap_end;
+}
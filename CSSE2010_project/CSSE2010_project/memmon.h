@@ -0,0 +1,41 @@
+/*
+ * memmon.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * SRAM usage monitoring. Before the C runtime starts, all SRAM between the
+ * end of the static variables and the top of the stack is painted with a
+ * known byte. The deepest the stack has ever reached is then found by
+ * looking for the lowest address that no longer holds that byte. Together
+ * with the current stack pointer and the end of the heap, this gives how
+ * much SRAM is really free, so new features can be budgeted against it.
+ *
+ * The firmware doesn't use malloc(), so normally the heap is empty and the
+ * free gap is everything between the static variables and the stack.
+ */
+
+#ifndef MEMMON_H_
+#define MEMMON_H_
+
+#include <stdint.h>
+
+// SRAM usage in bytes.
+typedef struct
+{
+	uint16_t total;     	// SRAM size.
+	uint16_t static_size;	// Initialised and zeroed variables.
+	uint16_t heap;      	// Allocated by malloc().
+	uint16_t stack_now; 	// Stack in use by the caller.
+	uint16_t stack_peak;	// Deepest the stack has been since reset.
+	uint16_t free_now;  	// Gap between the heap and the stack pointer.
+	uint16_t free_min;  	// Smallest the gap has been since reset.
+} MemoryUsage;
+
+/// <summary>
+/// Measures the SRAM usage. Scans the painted area, so it takes up to a few
+/// thousand cycles.
+/// </summary>
+/// <param name="usage">Filled in with the usage.</param>
+void memmon_get(MemoryUsage *usage);
+
+#endif /* MEMMON_H_ */
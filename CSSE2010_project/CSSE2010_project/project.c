@@ -23,31 +23,78 @@
 #include "game.h"
 #include "startscrn.h"
 #include "ledmatrix.h"
+#include "display.h"
+#include "ledbench.h"
+#include "fmtbench.h"
+#include "enginebench.h"
 #include "buttons.h"
 #include "serialio.h"
 #include "terminalio.h"
 #include "timer0.h"
-#include "timer1.h"
-#include "timer2.h"
+#include "cpuload.h"
+#include "memmon.h"
+#include "render.h"
+#include "fastfmt.h"
+#include "ssd.h"
+#include "eeprom_async.h"
+#include "highscore.h"
+#include "savestate.h"
+#include "remote.h"
+
+// Baud rate of the serial terminal. 250000 divides the 8MHz clock exactly, so
+// there is no rate error, and a full screen redraw takes a tenth of the time
+// it did at 19200. The terminal program must be set to the same rate.
+#define SERIAL_BAUD_RATE 250000L
 
 
 // Function prototypes - these are defined below (after main()) in the order
 // given here.
 void initialise_hardware(void);
 void start_screen(void);
+static void draw_start_screen(void);
 void new_game(void);
+bool resume_game(void);
 void play_game(void);
 void handle_game_over(void);
+static bool make_move(char direction);
+static void begin_remote(void);
+static bool handle_remote_frame(const RemoteFrame *frame);
+static void send_remote_state(void);
+static void count_second(void);
+static uint16_t get_seconds(void);
+static void draw_cpu_load(void);
+static void draw_elapsed_time(void);
+static void show_ssd_refresh_cost(void);
 
-bool valid_move;
 uint16_t start_time;
 uint16_t num_valid_moves;
+
+// Seconds counted by second_timer since play_game() started it.
+static volatile uint16_t seconds_elapsed;
+static SoftTimer second_timer;
+
+// Whether the CPU load status line is shown during the game (toggled with
+// 'c').
+static bool show_cpu_load;
+
+// The level new_game() starts (0-based). Chosen on the start screen, and
+// moved on with 'n' once a level is complete.
+static uint8_t selected_level;
 /////////////////////////////// main //////////////////////////////////
 int main(void)
 {
 	// Setup hardware and callbacks. This will turn on interrupts.
 	initialise_hardware();
 
+	// If a game was interrupted by a reset or power loss, carry on with it
+	// straight away.
+	if (resume_game())
+	{
+		selected_level = get_current_level();
+		play_game();
+		handle_game_over();
+	}
+
 	// Show the start screen. Returns when the player starts the game.
 	start_screen();
 
@@ -62,24 +109,41 @@ int main(void)
 
 void initialise_hardware(void)
 {
+	// Timer 0 goes first, since the display, buttons and seven segment
+	// display all register software timers with it.
+	init_timer0();
+	init_cpuload();
 	init_ledmatrix();
+	init_display();
+
+	// The game is drawn on both the LED matrix and the terminal.
+	render_register(&render_led);
+	render_register(&render_terminal);
 	init_buttons();
-	init_serial_stdio(19200, false);
-	init_timer0();
-	init_timer1();
-	init_timer2();
+	init_serial_stdio(SERIAL_BAUD_RATE, false);
+	init_ssd(SSD_REFRESH_RATE);
+	init_eeprom_async();
+
+	// Load the high score table and saved game. Nothing can be writing to
+	// the EEPROM yet (main() is only run again once every write has
+	// finished, see handle_game_over()), so it is safe to read it directly.
+	init_highscores();
+	init_savestate();
 
 	// Turn on global interrupts.
 	sei();
 }
 
-void start_screen(void)
+// Draws the start screen, apart from the rest of the title which
+// start_screen() draws while it waits.
+static void draw_start_screen(void)
 {
 	// Hide terminal cursor and set display mode to default.
 	hide_cursor();
 	normal_display_mode();
 
-	// Clear terminal screen and output the title ASCII art.
+	// Clear terminal screen and start drawing the title ASCII art (the
+	// rest is drawn by the loop below).
 	clear_terminal();
 	display_terminal_title(3, 5);
 	move_terminal_cursor(11, 5);
@@ -87,6 +151,17 @@ void start_screen(void)
 	// chevrons - "<" and ">"!
 	printf_P(PSTR("CSSE2010/7201 Project by Sithika Mannakkara - 48016722"));
 
+	// Report the serial settings, so that a baud rate the clock can't
+	// generate accurately is easy to spot.
+	int16_t baud_error = serial_baud_error();
+	move_terminal_cursor(13, 5);
+	printf_P(PSTR("Serial: %ld baud (error %c%d.%d%%)"), SERIAL_BAUD_RATE,
+		baud_error < 0 ? '-' : '+', abs(baud_error) / 10,
+		abs(baud_error) % 10);
+	move_terminal_cursor(15, 5);
+	printf_P(PSTR("Press 's' or a button to start level %d, or 1-%d for "
+		"another level"), selected_level + 1, get_num_levels());
+
 	// Setup the start screen on the LED matrix.
 	setup_start_screen();
 
@@ -95,6 +170,11 @@ void start_screen(void)
 	// hardware, and is only done here to ensure that the start screen is
 	// not skipped when you power cycle the I/O board.
 	clear_button_presses();
+}
+
+void start_screen(void)
+{
+	draw_start_screen();
 
 	// Wait until a button is pushed, or 's'/'S' is entered.
 	while (1)
@@ -120,12 +200,74 @@ void start_screen(void)
 				srand(get_current_time());
 				break;
 			}
+
+			// A level number starts that level.
+			if (serial_input >= '1' &&
+				serial_input < '1' + get_num_levels())
+			{
+				selected_level = serial_input - '1';
+				srand(get_current_time());
+				break;
+			}
+
+			// 'b'/'B' runs the LED matrix benchmark, 'f'/'F' the
+			// formatting benchmark, 'g'/'G' the game engine
+			// benchmark and 'd'/'D' times the seven segment display
+			// refresh, then the start screen is shown again.
+			bool benchmark = true;
+			switch (serial_input)
+			{
+				case 'b':
+				case 'B':
+					run_ledmatrix_benchmark();
+					break;
+				case 'f':
+				case 'F':
+					run_format_benchmark();
+					break;
+				case 'g':
+				case 'G':
+					run_engine_benchmark();
+					break;
+				case 'd':
+				case 'D':
+					show_ssd_refresh_cost();
+					break;
+				default:
+					benchmark = false;
+					break;
+			}
+			if (benchmark)
+			{
+				printf_P(PSTR("\nPress any key to return"));
+				while (!serial_input_available())
+				{
+					; // Wait.
+				}
+				clear_serial_input_buffer();
+				draw_start_screen();
+				continue;
+			}
+
+			// A remote host can also start the game by sending its
+			// first frame.
+			if (serial_input == REMOTE_SYNC)
+			{
+				begin_remote();
+				srand(get_current_time());
+				break;
+			}
 		}
 
 		// No button presses and no 's'/'S' typed into the terminal,
 		// we will loop back and do the checks again. We also update
 		// the start screen animation on the LED matrix here.
 		update_start_screen();
+		display_update();
+
+		// Carry on drawing the title, a few spans at a time so that
+		// the buttons are still polled while it is sent.
+		(void)update_terminal_title();
 	}
 }
 
@@ -136,31 +278,70 @@ void new_game(void)
 	clear_terminal();
 
 	// Initialise the game and display.
-	initialise_game();
-	valid_move = false;
+	initialise_game(selected_level);
 	start_time = 0;
 	num_valid_moves = 0;
+	ssd_show_number(0);
+	savestate_request();
 	// Clear all button presses and serial inputs, so that potentially
-	// buffered inputs aren't going to make it to the new game.
+	// buffered inputs aren't going to make it to the new game. A remote
+	// host waits for each reply, so anything it has sent is kept.
+	clear_button_presses();
+	if (!remote_active())
+	{
+		clear_serial_input_buffer();
+	}
+}
+
+bool resume_game(void)
+{
+	if (!savestate_available())
+	{
+		return false;
+	}
+
+	hide_cursor();
+	clear_terminal();
+
+	// Restore the board (this redraws the LED matrix) and the counters.
+	if (!savestate_restore(&start_time, &num_valid_moves))
+	{
+		return false;
+	}
+	ssd_show_number(num_valid_moves);
+	draw_elapsed_time();
+
 	clear_button_presses();
 	clear_serial_input_buffer();
+	return true;
 }
 
 void play_game(void)
 {
-	display_board_terminal();
-	reset_timer1();
-	uint32_t last_flash_time = get_current_time();
+	// The board has already been drawn by new_game() or resume_game().
+	draw_cpu_load();
+	seconds_elapsed = 0;
+	soft_timer_start(&second_timer, 1000, 1000, count_second);
 	
+	// start_time counts the seconds elapsed in the game. It doesn't start
+	// at zero if the game was resumed, so we count seconds separately.
+	uint16_t last_second = 0;
 	uint16_t current_time;
 	// We play the game until it's over.
 	while (!is_game_over())
 	{
-		current_time = get_current_time_sec();
-		if (current_time - start_time >= 1) {
-			start_time++;
-			move_terminal_cursor(4, 5);
-			printf_P(PSTR("Time elapsed : %d"), start_time);
+		// Time spent polling for something to do counts as idle.
+		cpuload_enter(CPU_IDLE);
+
+		current_time = get_seconds();
+		if (current_time != last_second) {
+			cpuload_enter(CPU_RENDER);
+			start_time += current_time - last_second;
+			last_second = current_time;
+			draw_elapsed_time();
+			draw_cpu_load();
+			savestate_time_changed(start_time);
+			cpuload_enter(CPU_IDLE);
 		}
 		
 		// We need to check if any buttons have been pushed, this will
@@ -168,50 +349,252 @@ void play_game(void)
 		// 0 has been pushed, we get BUTTON0_PUSHED, and likewise, if
 		// button 1 has been pushed, we get BUTTON1_PUSHED, and so on.
 		ButtonState btn = button_pushed();
+		if (btn != NO_BUTTON_PUSHED || serial_input_available()) {
+			cpuload_enter(CPU_GAME);
+		}
 		
-		// Move the player, see move_player(...) in game.c.
-		// Also remember to reset the flash cycle here.
+		// Move the player, see make_move(...) below. The display
+		// restarts the flash cycle when the player moves.
 		if (btn == BUTTON0_PUSHED) {
-			valid_move = move_player(0, 1);
+			make_move('d');
 
 		} else if (btn == BUTTON1_PUSHED) {
-			valid_move = move_player(-1, 0);
+			make_move('s');
 
 		} else if (btn == BUTTON2_PUSHED) {
-			valid_move = move_player(1, 0);
+			make_move('w');
 
 		} else if (btn == BUTTON3_PUSHED) {
-		valid_move = move_player(0, -1);
+			make_move('a');
+
+		} else if (remote_active()) {
+			// The game is being driven by a remote host.
+			const RemoteFrame *frame = remote_receive();
+			if (frame != NULL && handle_remote_frame(frame)) {
+				new_game();
+				send_remote_state();
+			}
+			if (!remote_active()) {
+				// The host has left binary mode, redraw the
+				// terminal which hasn't been updated since.
+				clear_terminal();
+				redraw_board();
+				draw_elapsed_time();
+				draw_cpu_load();
+			}
 
 		} else if (serial_input_available()) {
 			int serial_input = fgetc(stdin);
-			if (serial_input == 'd' || serial_input == 'D') valid_move = move_player(0, 1);
-			else if (serial_input == 's' || serial_input == 'S') valid_move = move_player(-1, 0);
-			else if (serial_input == 'w' || serial_input == 'W') valid_move = move_player(1, 0);
-			else if (serial_input == 'a' || serial_input == 'A') valid_move = move_player(0, -1);
-		}
-		
-		// for counting valid moves.
-		if (valid_move) {
-			increment_digit_SSD();
-			num_valid_moves++;
-			valid_move = false;
+			if (serial_input == REMOTE_SYNC) {
+				begin_remote();
+			} else if (toupper(serial_input) == 'C') {
+				show_cpu_load = !show_cpu_load;
+				draw_cpu_load();
+			} else if (toupper(serial_input) == 'U') {
+				if (undo_move()) {
+					num_valid_moves--;
+					ssd_show_number(num_valid_moves);
+					savestate_request();
+				}
+			} else {
+				make_move(serial_input);
+			}
 		}
+
+		// Write a new snapshot of the game if anything has changed.
+		savestate_update(start_time, num_valid_moves);
 		
-		// Move box if player is on box
+		// Send any changes to the LED matrix (and flash the player
+		// icon) if a frame is due.
+		display_update();
+	}
+	// We get here if the game is over.
+	soft_timer_stop(&second_timer);
+	cpuload_enter(CPU_IDLE);
+}
 
-		uint32_t current_time = get_current_time();
-		if (current_time >= last_flash_time + 200)
-		{
-			// 200ms (0.2 seconds) has passed since the last time
-			// we flashed the player icon, flash it now.
-			flash_player();
+// Timer callback that counts the seconds of the game being played.
+static void count_second(void)
+{
+	seconds_elapsed++;
+}
+
+// Gets the seconds counted since play_game() started.
+static uint16_t get_seconds(void)
+{
+	// Disable interrupts so we can be sure that the timer doesn't update
+	// the count when we've copied just one byte of it.
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	uint16_t result = seconds_elapsed;
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+	return result;
+}
 
-			// Update the most recent icon flash time.
-			last_flash_time = current_time;
+// Draws the time elapsed in the game. Called every second, so it uses the
+// fast formatter rather than printf_P().
+static void draw_elapsed_time(void)
+{
+	move_terminal_cursor(4, 5);
+	fmt_put_P(PSTR("Time elapsed : "));
+	fmt_put_u16(start_time, 0);
+}
+
+// Draws the CPU load status line if it is enabled, or clears it otherwise.
+// The figures are for the last complete second.
+static void draw_cpu_load(void)
+{
+	move_terminal_cursor(2, 5);
+	if (show_cpu_load) {
+		CpuLoad load;
+		cpuload_get(&load);
+		fmt_put_P(PSTR("CPU: game "));
+		fmt_put_u16(load.percent[CPU_GAME], 3);
+		fmt_put_P(PSTR("%  render "));
+		fmt_put_u16(load.percent[CPU_RENDER], 3);
+		fmt_put_P(PSTR("%  isr "));
+		fmt_put_u16(load.percent[CPU_ISR], 3);
+		fmt_put_P(PSTR("%  idle "));
+		fmt_put_u16(load.percent[CPU_IDLE], 3);
+		fmt_put_P(PSTR("%"));
+	}
+	clear_to_end_of_line();
+}
+
+// Times the seven segment display's refresh callback, and shows its share of
+// the CPU at the default refresh rate (not counting the timer wheel).
+static void show_ssd_refresh_cost(void)
+{
+	uint16_t cycles = ssd_refresh_cycles();
+	uint32_t per_second = (uint32_t)cycles * SSD_REFRESH_RATE *
+		SSD_NUM_DIGITS * SSD_BRIGHTNESS_LEVELS;
+	uint16_t hundredths = per_second / (F_CPU / 10000);
+	clear_terminal();
+	move_terminal_cursor(1, 1);
+	printf_P(PSTR("Seven segment display refresh: %u cycles per tick, "
+		"%lu cycles/s at %d Hz\n(%u.%02u%% of the CPU)\n"), cycles,
+		per_second, SSD_REFRESH_RATE, hundredths / 100, hundredths % 100);
+}
+
+// Moves the player in the direction of a WASD key, and counts the move if it
+// was valid. Returns whether the move was valid.
+static bool make_move(char direction)
+{
+	bool valid_move;
+	switch (toupper(direction))
+	{
+		case 'W':
+			valid_move = move_player(1, 0);
+			break;
+		case 'A':
+			valid_move = move_player(0, -1);
+			break;
+		case 'S':
+			valid_move = move_player(-1, 0);
+			break;
+		case 'D':
+			valid_move = move_player(0, 1);
+			break;
+		default:
+			return false;
+	}
+
+	// for counting valid moves.
+	if (valid_move) {
+		num_valid_moves++;
+		ssd_show_number(num_valid_moves);
+		savestate_request();
+	}
+	return valid_move;
+}
+
+// Switches to the binary remote protocol. The terminal is not drawn while
+// it is active.
+static void begin_remote(void)
+{
+	remote_begin();
+	render_set_enabled(&render_terminal, false);
+}
+
+static void send_remote_state(void)
+{
+	RemoteState state;
+	get_board_state(&state.board);
+	state.moves = num_valid_moves;
+	state.elapsed_time = start_time;
+	state.game_over = is_game_over();
+	remote_send(REMOTE_EVT_STATE, &state, sizeof(state));
+}
+
+// Handles a frame received from the remote host. Returns true if the host
+// asked for a new game (which the caller must start).
+static bool handle_remote_frame(const RemoteFrame *frame)
+{
+	switch (frame->type)
+	{
+		case REMOTE_CMD_PING:
+		{
+			uint8_t version = REMOTE_VERSION;
+			remote_send(REMOTE_EVT_PONG, &version, sizeof(version));
+			break;
+		}
+		case REMOTE_CMD_MOVE:
+		case REMOTE_CMD_MOVES:
+		{
+			// Make each move in turn, stopping early if the level is
+			// completed.
+			RemoteMoveResult result;
+			result.applied = 0;
+			result.valid = 0;
+			for (uint8_t i = 0; i < frame->length && !is_game_over();
+				i++)
+			{
+				result.applied++;
+				if (make_move(frame->payload[i]))
+				{
+					result.valid++;
+				}
+			}
+			result.moves = num_valid_moves;
+			result.elapsed_time = start_time;
+			result.game_over = is_game_over();
+			remote_send(REMOTE_EVT_MOVED, &result, sizeof(result));
+			break;
+		}
+		case REMOTE_CMD_QUERY:
+			send_remote_state();
+			break;
+		case REMOTE_CMD_RESTART:
+			return true;
+		case REMOTE_CMD_LOAD:
+		{
+			CpuLoad load;
+			cpuload_get(&load);
+			remote_send(REMOTE_EVT_LOAD, &load, sizeof(load));
+			break;
+		}
+		case REMOTE_CMD_MEMORY:
+		{
+			MemoryUsage memory;
+			memmon_get(&memory);
+			remote_send(REMOTE_EVT_MEMORY, &memory, sizeof(memory));
+			break;
+		}
+		case REMOTE_CMD_EXIT:
+			remote_end();
+			render_set_enabled(&render_terminal, true);
+			break;
+		default:
+		{
+			uint8_t error = REMOTE_ERR_COMMAND;
+			remote_send(REMOTE_EVT_ERROR, &error, sizeof(error));
+			break;
 		}
 	}
-	// We get here if the game is over.
+	return false;
 }
 // Score = max(200  S, 0)  20 + max(1200  T, 0)
 uint16_t get_score(void) {
@@ -228,6 +611,9 @@ uint16_t get_score(void) {
 
 void handle_game_over(void)
 {
+	// The level is complete, there is nothing to resume.
+	savestate_clear();
+
 	clear_terminal();
 	move_terminal_cursor(14, 10);
 	printf_P(PSTR("GAME OVER"));
@@ -236,26 +622,98 @@ void handle_game_over(void)
 	printf_P(PSTR("Your score: %d"), score);
 	move_terminal_cursor(16, 10);
 	printf_P(PSTR("Steps taken: %d\tTime: %d"), num_valid_moves, start_time);
+	uint16_t par = get_level_par(get_current_level());
+	if (par)
+	{
+		printf_P(PSTR("\tPar: %u"), par);
+	}
+
+	// Record the result. The new records are written to EEPROM in the
+	// background while we wait for input below.
+	uint8_t level = get_current_level();
+	if (highscore_submit(level, score, num_valid_moves, start_time))
+	{
+		move_terminal_cursor(18, 10);
+		printf_P(PSTR("New high score!"));
+	}
+	move_terminal_cursor(19, 10);
+	printf_P(PSTR("Best score: %u\tFewest steps: %u\tFastest time: %u"),
+		highscore_get_best_score(level), highscore_get_best_moves(level),
+		highscore_get_best_time(level));
 	move_terminal_cursor(17, 10);
-	printf_P(PSTR("Press 'r'/'R' to restart, or 'e'/'E' to exit"));
+	printf_P(PSTR("Press 'r'/'R' to restart, 'n'/'N' for the next level, "
+		"or 'e'/'E' to exit"));
+
+#ifdef DEBUG
+	// Show how much SRAM is in use, for budgeting new features.
+	MemoryUsage memory;
+	memmon_get(&memory);
+	move_terminal_cursor(21, 10);
+	printf_P(PSTR("SRAM: %u static, stack %u (peak %u), free %u (min %u)"),
+		memory.static_size, memory.stack_now, memory.stack_peak,
+		memory.free_now, memory.free_min);
+#endif
+
+	if (remote_active())
+	{
+		RemoteGameOver game_over;
+		game_over.level = level;
+		game_over.score = score;
+		game_over.moves = num_valid_moves;
+		game_over.elapsed_time = start_time;
+		remote_send(REMOTE_EVT_GAME_OVER, &game_over, sizeof(game_over));
+	}
 
 	// Do nothing until a valid input is made.
 	while (1)
 	{
+		// Queue any high score records still waiting to be written.
+		highscore_update();
+		display_update();
+
 		// Get serial input. If no serial input is ready, serial_input
 		// would be -1 (not a valid character).
 		int serial_input = -1;
-		if (serial_input_available())
+		if (remote_active())
+		{
+			// A remote host restarts with a command rather than 'r'.
+			const RemoteFrame *frame = remote_receive();
+			if (frame != NULL && handle_remote_frame(frame))
+			{
+				serial_input = 'R';
+			}
+		}
+		else if (serial_input_available())
 		{
 			serial_input = fgetc(stdin);
+			if (serial_input == REMOTE_SYNC)
+			{
+				// A host can take over from the game over screen too.
+				begin_remote();
+				serial_input = -1;
+			}
 		}
 
-		// Check serial input.
+		// Check serial input. 'n' moves on to the next level and then
+		// starts it like a restart.
+		if (toupper(serial_input) == 'N') {
+			selected_level = (level + 1) % get_num_levels();
+			serial_input = 'R';
+		}
 		if (toupper(serial_input) == 'R') {	
 			new_game();
+			if (remote_active()) {
+				send_remote_state();
+			}
 			play_game();
 			handle_game_over();
 		} else if (toupper(serial_input) == 'E') {
+			// Starting again re-initialises the EEPROM writer and reads
+			// the EEPROM directly, so first let the high scores and
+			// the cleared saved game finish being written.
+			while (!highscore_is_saved() || eeprom_async_busy()) {
+				highscore_update();
+			}
 			main();
 		}
 		// Now check for other possible inputs.
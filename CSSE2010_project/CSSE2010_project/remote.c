@@ -0,0 +1,133 @@
+/*
+ * remote.c
+ *
+ * Author: Sithika Mannakkara
+ */
+
+#include "remote.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <util/crc16.h>
+#include "serialio.h"
+
+// Receive states. The state is the part of the frame expected next.
+typedef enum
+{
+	RX_SYNC,
+	RX_LENGTH,
+	RX_TYPE,
+	RX_PAYLOAD,
+	RX_CRC_HI,
+	RX_CRC_LO
+} RxState;
+
+static bool active;
+static RxState rx_state;
+static RemoteFrame rx_frame;
+static uint8_t rx_count;
+static uint16_t rx_crc;
+static uint16_t rx_received_crc;
+
+static void send_error(uint8_t code)
+{
+	remote_send(REMOTE_EVT_ERROR, &code, sizeof(code));
+}
+
+void remote_begin(void)
+{
+	serial_set_binary_mode(true);
+	active = true;
+
+	// The sync byte of the first frame has already been read.
+	rx_state = RX_LENGTH;
+	rx_crc = 0;
+}
+
+void remote_end(void)
+{
+	serial_set_binary_mode(false);
+	active = false;
+}
+
+bool remote_active(void)
+{
+	return active;
+}
+
+const RemoteFrame *remote_receive(void)
+{
+	int input;
+	while ((input = serial_read_raw()) >= 0)
+	{
+		uint8_t byte = (uint8_t)input;
+		switch (rx_state)
+		{
+			case RX_SYNC:
+				// Anything between frames is ignored.
+				if (byte == REMOTE_SYNC)
+				{
+					rx_state = RX_LENGTH;
+					rx_crc = 0;
+				}
+				break;
+			case RX_LENGTH:
+				if (byte > REMOTE_MAX_PAYLOAD)
+				{
+					send_error(REMOTE_ERR_LENGTH);
+					rx_state = RX_SYNC;
+					break;
+				}
+				rx_frame.length = byte;
+				rx_crc = _crc_xmodem_update(rx_crc, byte);
+				rx_state = RX_TYPE;
+				break;
+			case RX_TYPE:
+				rx_frame.type = byte;
+				rx_crc = _crc_xmodem_update(rx_crc, byte);
+				rx_count = 0;
+				rx_state = rx_frame.length > 0 ? RX_PAYLOAD :
+					RX_CRC_HI;
+				break;
+			case RX_PAYLOAD:
+				rx_frame.payload[rx_count++] = byte;
+				rx_crc = _crc_xmodem_update(rx_crc, byte);
+				if (rx_count == rx_frame.length)
+				{
+					rx_state = RX_CRC_HI;
+				}
+				break;
+			case RX_CRC_HI:
+				rx_received_crc = (uint16_t)byte << 8;
+				rx_state = RX_CRC_LO;
+				break;
+			case RX_CRC_LO:
+				rx_received_crc |= byte;
+				rx_state = RX_SYNC;
+				if (rx_received_crc == rx_crc)
+				{
+					return &rx_frame;
+				}
+				send_error(REMOTE_ERR_CRC);
+				break;
+		}
+	}
+	return NULL;
+}
+
+void remote_send(uint8_t type, const void *payload, uint8_t length)
+{
+	const uint8_t *bytes = (const uint8_t *)payload;
+	uint8_t header[3] = { REMOTE_SYNC, length, type };
+	uint16_t crc = _crc_xmodem_update(0, length);
+	crc = _crc_xmodem_update(crc, type);
+	for (uint8_t i = 0; i < length; i++)
+	{
+		crc = _crc_xmodem_update(crc, bytes[i]);
+	}
+	uint8_t trailer[2] = { crc >> 8, crc & 0xFF };
+
+	serial_write_raw(header, sizeof(header));
+	serial_write_raw(bytes, length);
+	serial_write_raw(trailer, sizeof(trailer));
+}
@@ -0,0 +1,135 @@
+/*
+ * remote.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Binary remote control and telemetry protocol. A host program can drive the
+ * game over the serial port with framed binary commands instead of
+ * keystrokes, and receive the game state and events in binary rather than as
+ * rendered terminal output. Sending the sync byte while in text mode
+ * switches the serial port into binary mode, in which terminal output is
+ * suppressed.
+ *
+ * Every frame (in both directions) has the format
+ *
+ *     SYNC  LENGTH  TYPE  PAYLOAD[LENGTH]  CRC_HI  CRC_LO
+ *
+ * where CRC is the CRC-16/XMODEM (polynomial 0x1021, initial value 0) of the
+ * LENGTH, TYPE and PAYLOAD bytes. Multi-byte payload values are little
+ * endian. Frames with a bad CRC are answered with an error event and
+ * otherwise ignored.
+ */
+
+#ifndef REMOTE_H_
+#define REMOTE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "game.h"
+
+// Start of frame marker. Never produced by a keyboard, so it is also used to
+// switch into binary mode.
+#define REMOTE_SYNC 	(0xA5)
+
+// Protocol version, returned in the pong event.
+#define REMOTE_VERSION	(4)
+
+// The largest payload the board will accept. Larger frames are rejected.
+#define REMOTE_MAX_PAYLOAD	(32)
+
+// Commands (host to board).
+#define REMOTE_CMD_PING   	(0x01) // No payload.
+#define REMOTE_CMD_MOVE   	(0x02) // One direction ('w', 'a', 's' or 'd').
+#define REMOTE_CMD_MOVES  	(0x03) // Up to REMOTE_MAX_PAYLOAD directions.
+#define REMOTE_CMD_QUERY  	(0x04) // No payload.
+#define REMOTE_CMD_RESTART	(0x05) // No payload.
+#define REMOTE_CMD_EXIT   	(0x06) // No payload.
+#define REMOTE_CMD_LOAD   	(0x07) // No payload.
+#define REMOTE_CMD_MEMORY 	(0x08) // No payload.
+
+// Events (board to host).
+#define REMOTE_EVT_PONG     	(0x81) // Protocol version.
+#define REMOTE_EVT_MOVED    	(0x82) // RemoteMoveResult.
+#define REMOTE_EVT_STATE    	(0x83) // RemoteState.
+#define REMOTE_EVT_GAME_OVER	(0x84) // RemoteGameOver.
+#define REMOTE_EVT_LOAD     	(0x85) // CpuLoad (see cpuload.h).
+#define REMOTE_EVT_MEMORY   	(0x86) // MemoryUsage (see memmon.h).
+#define REMOTE_EVT_ERROR    	(0x8F) // Error code.
+
+// Error codes.
+#define REMOTE_ERR_CRC      	(0x01)
+#define REMOTE_ERR_LENGTH   	(0x02)
+#define REMOTE_ERR_COMMAND  	(0x03)
+
+// Payload of REMOTE_EVT_MOVED. Sent in reply to a move command, once all of
+// its moves have been made (or the level has been completed).
+typedef struct
+{
+	uint8_t applied;	// Number of moves attempted.
+	uint8_t valid;  	// Number of those moves which were valid.
+	uint16_t moves; 	// Total valid moves made in the game.
+	uint16_t elapsed_time;	// Seconds elapsed in the game.
+	uint8_t game_over;	// Whether the level is complete.
+} RemoteMoveResult;
+
+// Payload of REMOTE_EVT_STATE. Sent in reply to a query command.
+typedef struct
+{
+	BoardState board;
+	uint16_t moves;
+	uint16_t elapsed_time;
+	uint8_t game_over;
+} RemoteState;
+
+// Payload of REMOTE_EVT_GAME_OVER. Sent when a level is completed.
+typedef struct
+{
+	uint8_t level;
+	uint16_t score;
+	uint16_t moves;
+	uint16_t elapsed_time;
+} RemoteGameOver;
+
+// A received frame.
+typedef struct
+{
+	uint8_t type;
+	uint8_t length;
+	uint8_t payload[REMOTE_MAX_PAYLOAD];
+} RemoteFrame;
+
+/// <summary>
+/// Switches the serial port into binary mode and starts receiving frames.
+/// Should be called when REMOTE_SYNC is read in text mode; that byte is
+/// taken to be the start of the first frame.
+/// </summary>
+void remote_begin(void);
+
+/// <summary>
+/// Switches the serial port back into text mode.
+/// </summary>
+void remote_end(void);
+
+/// <summary>
+/// Tests whether the serial port is in binary mode.
+/// </summary>
+/// <returns>Whether the remote protocol is active.</returns>
+bool remote_active(void);
+
+/// <summary>
+/// Processes received bytes until a complete frame is found or there are no
+/// more bytes available. Does not block.
+/// </summary>
+/// <returns>The frame received, or NULL if no complete frame is available.
+/// The frame is only valid until the next call.</returns>
+const RemoteFrame *remote_receive(void);
+
+/// <summary>
+/// Sends a frame.
+/// </summary>
+/// <param name="type">The frame type.</param>
+/// <param name="payload">The payload.</param>
+/// <param name="length">The length of the payload.</param>
+void remote_send(uint8_t type, const void *payload, uint8_t length);
+
+#endif /* REMOTE_H_ */
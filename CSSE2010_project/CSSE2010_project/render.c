@@ -0,0 +1,144 @@
+/*
+ * render.c
+ *
+ * Author: Sithika Mannakkara
+ */
+
+#include "render.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "cpuload.h"
+
+static const RenderBackend *backends[RENDER_MAX_BACKENDS];
+static uint8_t num_backends;
+
+// Bit n is set if backends[n] is turned on.
+static uint8_t enabled_backends;
+
+static bool suspended;
+
+static void null_cell_changed(uint8_t row, uint8_t col, uint8_t cell)
+{
+	(void)row;
+	(void)col;
+	(void)cell;
+}
+
+static void null_status_changed(RenderStatus status, const void *data)
+{
+	(void)status;
+	(void)data;
+}
+
+static void null_flush(void)
+{
+}
+
+const RenderBackend render_null =
+{
+	.cell_changed = null_cell_changed,
+	.status_changed = null_status_changed,
+	.flush = null_flush
+};
+
+// Finds a backend's index, or returns num_backends if it isn't registered.
+static uint8_t find_backend(const RenderBackend *backend)
+{
+	uint8_t i = 0;
+	while (i < num_backends && backends[i] != backend)
+	{
+		i++;
+	}
+	return i;
+}
+
+void render_register(const RenderBackend *backend)
+{
+	// The game re-runs its initialisation on a restart, so a backend may
+	// already be registered.
+	if (find_backend(backend) == num_backends &&
+		num_backends < RENDER_MAX_BACKENDS)
+	{
+		enabled_backends |= 1 << num_backends;
+		backends[num_backends++] = backend;
+	}
+}
+
+void render_set_enabled(const RenderBackend *backend, bool enabled)
+{
+	uint8_t i = find_backend(backend);
+	if (i == num_backends)
+	{
+		return;
+	}
+	if (enabled)
+	{
+		enabled_backends |= 1 << i;
+	}
+	else
+	{
+		enabled_backends &= ~(1 << i);
+	}
+}
+
+bool render_is_enabled(const RenderBackend *backend)
+{
+	uint8_t i = find_backend(backend);
+	return !suspended && i < num_backends && (enabled_backends & (1 << i));
+}
+
+void render_suspend(bool suspend)
+{
+	suspended = suspend;
+}
+
+void render_cell(uint8_t row, uint8_t col, uint8_t cell)
+{
+	if (suspended)
+	{
+		return;
+	}
+	for (uint8_t i = 0; i < num_backends; i++)
+	{
+		if ((enabled_backends & (1 << i)) && backends[i]->cell_changed)
+		{
+			backends[i]->cell_changed(row, col, cell);
+		}
+	}
+}
+
+void render_status(RenderStatus status, const void *data)
+{
+	if (suspended)
+	{
+		return;
+	}
+	for (uint8_t i = 0; i < num_backends; i++)
+	{
+		if ((enabled_backends & (1 << i)) && backends[i]->status_changed)
+		{
+			backends[i]->status_changed(status, data);
+		}
+	}
+}
+
+void render_flush(void)
+{
+	if (suspended)
+	{
+		return;
+	}
+
+	// Drawing is charged to rendering, not to the game operation that
+	// called for it.
+	CpuActivity activity = cpuload_enter(CPU_RENDER);
+	for (uint8_t i = 0; i < num_backends; i++)
+	{
+		if ((enabled_backends & (1 << i)) && backends[i]->flush)
+		{
+			backends[i]->flush();
+		}
+	}
+	cpuload_enter(activity);
+}
@@ -0,0 +1,138 @@
+/*
+ * render.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Render backends. The game logic doesn't draw anything itself, it reports
+ * each square whose contents changed and each change of status (messages,
+ * level complete and so on) through the functions here, which pass them on
+ * to every registered backend. Both views of the game are drawn from the
+ * same events, so they can't drift apart. A backend may draw each event
+ * straight away, or collect them and draw the result when render_flush() is
+ * called at the end of each game operation.
+ *
+ * The backends are
+ *  - render_led, which draws on the LED matrix through the display task,
+ *  - render_terminal, which draws on the serial terminal, and
+ *  - render_null, which ignores everything,
+ * and on the host, the event recorder in tools/recorder.h.
+ */
+
+#ifndef RENDER_H_
+#define RENDER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Most backends that can be registered at once.
+#define RENDER_MAX_BACKENDS	(4)
+
+// Flags which are added to the objects on a square (see game.h) in a cell
+// event.
+#define RENDER_PLAYER	(1U << 3)	// The player has moved onto the square.
+#define RENDER_PUSHED	(1U << 4)	// A box was pushed onto or off the square.
+#define RENDER_OBJECT_MASK	(0x07)
+
+// Status events, and the data that comes with each.
+typedef enum
+{
+	RENDER_STATUS_BOARD_RESET,	// RenderMap. Every square follows, and
+	                          	// what was drawn before may have been
+	                          	// lost.
+	RENDER_STATUS_MESSAGE,    	// The message text in program memory, or
+	                          	// NULL to clear the message.
+	RENDER_STATUS_HISTORY,    	// RenderHistory (for testing).
+	RENDER_STATUS_LEVEL_COMPLETE	// NULL.
+} RenderStatus;
+
+// Data of RENDER_STATUS_BOARD_RESET: the size of the map, and a function
+// which gets the objects on any square of it. A backend which only shows
+// part of the map reads the rest with get_cell() when it needs it.
+typedef struct
+{
+	uint8_t rows;
+	uint8_t columns;
+	uint8_t (*get_cell)(uint8_t row, uint8_t col);
+} RenderMap;
+
+// Data of RENDER_STATUS_HISTORY: the recent player locations, packed as
+// (row << 8 | col), or 0xFFFF if empty.
+typedef struct
+{
+	const uint16_t *locations;
+	uint8_t length;
+	uint8_t previous_row;
+	uint8_t previous_col;
+	uint8_t boxes_in_target;
+} RenderHistory;
+
+// A render backend. Any of the functions may be NULL.
+typedef struct
+{
+	// Called when a square changes. cell is the objects on the square
+	// and any RENDER_* flags.
+	void (*cell_changed)(uint8_t row, uint8_t col, uint8_t cell);
+	// Called when the status changes.
+	void (*status_changed)(RenderStatus status, const void *data);
+	// Called at the end of each game operation, to draw anything that has
+	// been held back.
+	void (*flush)(void);
+} RenderBackend;
+
+extern const RenderBackend render_led;
+extern const RenderBackend render_terminal;
+extern const RenderBackend render_null;
+
+/// <summary>
+/// Adds a backend. Backends are enabled when they are added, and are called
+/// in the order they were added. Adding a backend that is already
+/// registered (which leaves it enabled or disabled as it was), or one past
+/// RENDER_MAX_BACKENDS, is ignored.
+/// </summary>
+/// <param name="backend">The backend.</param>
+void render_register(const RenderBackend *backend);
+
+/// <summary>
+/// Turns a backend on or off. A backend which is turned off misses events,
+/// so whatever it draws needs redrawing when it is turned back on.
+/// </summary>
+/// <param name="backend">The backend.</param>
+/// <param name="enabled">Whether it should get events.</param>
+void render_set_enabled(const RenderBackend *backend, bool enabled);
+
+/// <summary>
+/// Tests whether a backend is registered, turned on and not suspended.
+/// </summary>
+/// <param name="backend">The backend.</param>
+/// <returns>Whether the backend gets events.</returns>
+bool render_is_enabled(const RenderBackend *backend);
+
+/// <summary>
+/// Stops or restarts passing events to all backends, so that only the game
+/// engine runs (for benchmarking).
+/// </summary>
+/// <param name="suspended">Whether to stop passing events.</param>
+void render_suspend(bool suspended);
+
+/// <summary>
+/// Reports a changed square to the backends.
+/// </summary>
+/// <param name="row">The row of the square (0 is the bottom row).</param>
+/// <param name="col">The column of the square.</param>
+/// <param name="cell">The objects on the square and RENDER_* flags.</param>
+void render_cell(uint8_t row, uint8_t col, uint8_t cell);
+
+/// <summary>
+/// Reports a change of status to the backends.
+/// </summary>
+/// <param name="status">The kind of change.</param>
+/// <param name="data">The data for that kind of change (see
+/// RenderStatus).</param>
+void render_status(RenderStatus status, const void *data);
+
+/// <summary>
+/// Tells the backends to draw anything they have held back.
+/// </summary>
+void render_flush(void);
+
+#endif /* RENDER_H_ */
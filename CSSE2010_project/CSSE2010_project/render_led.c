@@ -0,0 +1,259 @@
+/*
+ * render_led.c
+ *
+ * Author: Sithika Mannakkara
+ *
+ * LED matrix render backend. The matrix is a window onto the map which
+ * follows the player, keeping it VIEW_MARGIN squares from the edges while
+ * the map goes on past them. Squares in the window are drawn into the
+ * display framebuffer straight away, and the display task sends only the
+ * pixels that changed once per frame (see display.h). Scrolling the window
+ * waits until render_flush(), when the framebuffer is shifted by one column
+ * or row and only the column or row shifted in is drawn, so a step across a
+ * large map costs one shift command and one column or row update. Jumps
+ * further than that (wrapping around the edge of the map) redraw the window.
+ */
+
+#include "render.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "game.h"
+#include "ledmatrix.h"
+#include "display.h"
+#include "anim.h"
+
+// Number of display frames a pushed box takes to fade out of its old square
+// and into its new one.
+#define PUSH_FADE_FRAMES	(4)
+
+// Number of squares kept between the player and the edges of the matrix.
+#define VIEW_MARGIN	(2)
+
+// The map being shown, and the part of it on the matrix: the map row on the
+// bottom row of the matrix and the map column on its left column.
+static const RenderMap *map;
+static uint8_t view_row;
+static uint8_t view_col;
+
+// Where the player is on the map, and whether it has moved (or the whole
+// window needs drawing) since the last flush.
+static uint8_t player_row;
+static uint8_t player_col;
+static bool player_moved;
+static bool redraw;
+
+// Colour of a square with the given object(s) on it.
+static PixelColour object_colour(uint8_t cell)
+{
+	switch (cell & RENDER_OBJECT_MASK)
+	{
+		case WALL:
+			return COLOUR_WALL;
+		case BOX:
+			return COLOUR_BOX;
+		case TARGET:
+			return COLOUR_TARGET;
+		case BOX | TARGET:
+			return COLOUR_DONE;
+		default:
+			return COLOUR_BLACK;
+	}
+}
+
+// Draws a pixel of the matrix from the map. Pixels past the edge of a small
+// map are black.
+static void draw_pixel(uint8_t row, uint8_t col)
+{
+	uint8_t map_row = view_row + row;
+	uint8_t map_col = view_col + col;
+	PixelColour colour = COLOUR_BLACK;
+	if (map_row < map->rows && map_col < map->columns)
+	{
+		colour = object_colour(map->get_cell(map_row, map_col));
+	}
+	display_set_pixel(row, col, colour);
+}
+
+static void draw_window(void)
+{
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			draw_pixel(row, col);
+		}
+	}
+}
+
+// Works out the first map row or column to show along one axis, moving the
+// current one as little as possible to keep the player VIEW_MARGIN squares
+// from the edges of the matrix.
+static uint8_t follow(uint8_t view, uint8_t player, uint8_t size,
+	uint8_t map_size)
+{
+	if (map_size <= size)
+	{
+		return 0;
+	}
+	if (player < view + VIEW_MARGIN)
+	{
+		view = player < VIEW_MARGIN ? 0 : player - VIEW_MARGIN;
+	}
+	else if (player > view + size - 1 - VIEW_MARGIN)
+	{
+		view = player - (size - 1 - VIEW_MARGIN);
+	}
+	return view < map_size - size ? view : map_size - size;
+}
+
+// Works out the first map row or column to show along one axis with the
+// player in the middle of the matrix.
+static uint8_t centre(uint8_t player, uint8_t size, uint8_t map_size)
+{
+	if (map_size <= size)
+	{
+		return 0;
+	}
+	uint8_t view = player > size / 2 ? player - size / 2 : 0;
+	return view < map_size - size ? view : map_size - size;
+}
+
+// Moves the window to keep up with the player, scrolling by a column and/or
+// a row if that is all it takes.
+static void move_window(void)
+{
+	uint8_t new_row = follow(view_row, player_row, MATRIX_NUM_ROWS,
+		map->rows);
+	uint8_t new_col = follow(view_col, player_col, MATRIX_NUM_COLUMNS,
+		map->columns);
+	if ((uint8_t)(new_row - view_row + 1) > 2 ||
+		(uint8_t)(new_col - view_col + 1) > 2)
+	{
+		// Fades would carry on at their old places on the matrix, over
+		// the new window.
+		anim_stop_all();
+		view_row = new_row;
+		view_col = new_col;
+		draw_window();
+		return;
+	}
+
+	// The squares already on the matrix move across it, and the ones
+	// shifted in are drawn.
+	if (new_col > view_col)
+	{
+		display_shift(DISPLAY_SHIFT_LEFT);
+		view_col = new_col;
+		for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+		{
+			draw_pixel(row, MATRIX_NUM_COLUMNS - 1);
+		}
+	}
+	else if (new_col < view_col)
+	{
+		display_shift(DISPLAY_SHIFT_RIGHT);
+		view_col = new_col;
+		for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+		{
+			draw_pixel(row, 0);
+		}
+	}
+	if (new_row > view_row)
+	{
+		display_shift(DISPLAY_SHIFT_DOWN);
+		view_row = new_row;
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			draw_pixel(MATRIX_NUM_ROWS - 1, col);
+		}
+	}
+	else if (new_row < view_row)
+	{
+		display_shift(DISPLAY_SHIFT_UP);
+		view_row = new_row;
+		for (uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++)
+		{
+			draw_pixel(0, col);
+		}
+	}
+}
+
+// The player is an icon blinking over the framebuffer, so the square under
+// it is left alone (a pushed box may still be fading out of it).
+static void led_cell_changed(uint8_t row, uint8_t col, uint8_t cell)
+{
+	if (cell & RENDER_PLAYER)
+	{
+		player_row = row;
+		player_col = col;
+		player_moved = true;
+		return;
+	}
+
+	// Squares off the matrix aren't drawn, and neither is anything
+	// before a redraw.
+	uint8_t matrix_row = row - view_row;
+	uint8_t matrix_col = col - view_col;
+	if (redraw || matrix_row >= MATRIX_NUM_ROWS ||
+		matrix_col >= MATRIX_NUM_COLUMNS)
+	{
+		return;
+	}
+	if (cell & RENDER_PUSHED)
+	{
+		anim_fade(matrix_row, matrix_col, object_colour(cell),
+			PUSH_FADE_FRAMES);
+	}
+	else
+	{
+		display_set_pixel(matrix_row, matrix_col, object_colour(cell));
+	}
+}
+
+static void led_status_changed(RenderStatus status, const void *data)
+{
+	switch (status)
+	{
+		case RENDER_STATUS_BOARD_RESET:
+			// Fades would overwrite the new board. The window is
+			// drawn from the map once the player is known.
+			anim_stop_all();
+			map = data;
+			redraw = true;
+			break;
+		case RENDER_STATUS_LEVEL_COMPLETE:
+			display_hide_player();
+			break;
+		default:
+			break;
+	}
+}
+
+static void led_flush(void)
+{
+	if (redraw)
+	{
+		view_row = centre(player_row, MATRIX_NUM_ROWS, map->rows);
+		view_col = centre(player_col, MATRIX_NUM_COLUMNS, map->columns);
+		draw_window();
+		redraw = false;
+	}
+	else if (player_moved)
+	{
+		move_window();
+	}
+	if (player_moved)
+	{
+		display_set_player(player_row - view_row, player_col - view_col,
+			COLOUR_PLAYER);
+		player_moved = false;
+	}
+}
+
+const RenderBackend render_led =
+{
+	.cell_changed = led_cell_changed,
+	.status_changed = led_status_changed,
+	.flush = led_flush
+};
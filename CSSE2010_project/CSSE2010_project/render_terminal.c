@@ -0,0 +1,250 @@
+/*
+ * render_terminal.c
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Serial terminal render backend, which shows the whole map. Changed squares
+ * are collected in a short list sorted by location, and are drawn when the
+ * game operation ends (render_flush()), so a square that changes more than
+ * once in a move is sent once. Each run of neighbouring squares in the list
+ * is sent as one cursor move, an attribute wherever the colour changes and a
+ * space per square. A redraw of the board sends more squares than the list
+ * holds, but they arrive in order, so each time the list fills up it is one
+ * or two runs that get sent. Messages are held back in the same way, and are
+ * only sent if they differ from the one on screen.
+ */
+
+#include "render.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <avr/pgmspace.h>
+#include <string.h>
+#include "game.h"
+#include "terminalio.h"
+#include "fastfmt.h"
+#include "serialio.h"
+
+// Terminal position of the top left square of the board (0-based). These
+// are macros because the cursor tables below are built from them.
+#define TERMINAL_GAME_ROW	(12)
+#define TERMINAL_GAME_COL	(15)
+
+// Terminal position of the message area.
+#define TERMINAL_MESSAGE_ROW	(5)
+#define TERMINAL_MESSAGE_COL	(5)
+
+// The escape sequence that moves the cursor to a square, in two halves: the
+// start of the sequence up to the terminal row ("ESC [ row ;"), for each
+// line of the map area from the top, and the rest ("col H") for each column.
+// Every square is at a two digit terminal row and column, so each half is
+// the same length and the tables are filled in by the compiler.
+#if TERMINAL_GAME_ROW + 1 < 10 || TERMINAL_GAME_ROW + MAP_MAX_ROWS > 99 || \
+	TERMINAL_GAME_COL + 1 < 10 || TERMINAL_GAME_COL + MAP_MAX_COLUMNS > 99
+#error "The cursor tables need two digit terminal rows and columns"
+#endif
+#define CURSOR_LINE_LENGTH	(5)
+#define CURSOR_COLUMN_LENGTH	(3)
+#define CURSOR_LENGTH	(CURSOR_LINE_LENGTH + CURSOR_COLUMN_LENGTH)
+#define CURSOR_DIGITS(n)	'0' + (n) / 10, '0' + (n) % 10
+#define CURSOR_LINE(line)	\
+	{ '\x1b', '[', CURSOR_DIGITS(TERMINAL_GAME_ROW + 1 + (line)), ';' }
+#define CURSOR_COLUMN(col)	\
+	{ CURSOR_DIGITS(TERMINAL_GAME_COL + 1 + (col)), 'H' }
+#define CURSOR_8(macro, n)	macro(n), macro(n + 1), macro(n + 2), \
+	macro(n + 3), macro(n + 4), macro(n + 5), macro(n + 6), macro(n + 7)
+#if MAP_MAX_ROWS != 32 || MAP_MAX_COLUMNS != 32
+#error "The cursor tables need updating for the new map size"
+#endif
+static const char line_cursor[MAP_MAX_ROWS][CURSOR_LINE_LENGTH] PROGMEM =
+{
+	CURSOR_8(CURSOR_LINE, 0), CURSOR_8(CURSOR_LINE, 8),
+	CURSOR_8(CURSOR_LINE, 16), CURSOR_8(CURSOR_LINE, 24)
+};
+static const char column_cursor[MAP_MAX_COLUMNS][CURSOR_COLUMN_LENGTH]
+	PROGMEM =
+{
+	CURSOR_8(CURSOR_COLUMN, 0), CURSOR_8(CURSOR_COLUMN, 8),
+	CURSOR_8(CURSOR_COLUMN, 16), CURSOR_8(CURSOR_COLUMN, 24)
+};
+
+// Squares waiting to be drawn, sorted by row and then column. Each holds
+// what the square should show (the objects and RENDER_PLAYER).
+#define MAX_PENDING	(16)
+typedef struct
+{
+	uint8_t row;
+	uint8_t col;
+	uint8_t cell;
+} PendingSquare;
+static PendingSquare pending[MAX_PENDING];
+static uint8_t num_pending;
+
+// Number of rows of the map, which places row 0 at the bottom of the area.
+static uint8_t map_rows;
+
+// The message on screen (if known), and the one to show at the next flush.
+static const char *shown_message;
+static bool shown_message_known;
+static const char *next_message;
+
+// Colour of a square on the terminal.
+static DisplayParameter cell_colour(uint8_t cell)
+{
+	if (cell & RENDER_PLAYER)
+	{
+		return BG_WHITE;
+	}
+	switch (cell & RENDER_OBJECT_MASK)
+	{
+		case WALL:
+			return BG_YELLOW;
+		case TARGET:
+			return BG_RED;
+		case BOX:
+			return BG_CYAN;
+		case BOX | TARGET:
+			return BG_GREEN;
+		default:
+			return BG_BLACK;
+	}
+}
+
+// Sends the pending squares, a run at a time.
+static void draw_pending(void)
+{
+	uint8_t i = 0;
+	while (i < num_pending)
+	{
+		const PendingSquare *square = &pending[i];
+		char buffer[CURSOR_LENGTH + MAX_PENDING * (FMT_ATTRIBUTE_LENGTH + 1)];
+		memcpy_P(buffer, line_cursor[map_rows - 1 - square->row],
+			CURSOR_LINE_LENGTH);
+		memcpy_P(buffer + CURSOR_LINE_LENGTH, column_cursor[square->col],
+			CURSOR_COLUMN_LENGTH);
+		uint8_t length = CURSOR_LENGTH;
+		DisplayParameter current = TERM_RESET;
+		uint8_t row = square->row;
+		uint8_t col = square->col;
+		while (i < num_pending && pending[i].row == row &&
+			pending[i].col == col)
+		{
+			DisplayParameter colour = cell_colour(pending[i].cell);
+			if (colour != current)
+			{
+				length += fmt_attribute(buffer + length, colour);
+				current = colour;
+			}
+			buffer[length++] = ' ';
+			i++;
+			col++;
+		}
+		serial_write_text(buffer, length);
+	}
+	if (num_pending)
+	{
+		set_display_attribute(TERM_RESET);
+	}
+	num_pending = 0;
+}
+
+static void terminal_cell_changed(uint8_t row, uint8_t col, uint8_t cell)
+{
+	// Find where the square goes in the list. Redraws add the squares in
+	// order, so start from the end.
+	uint16_t location = row << 8 | col;
+	uint8_t i = num_pending;
+	while (i > 0 && (pending[i - 1].row << 8 | pending[i - 1].col) > location)
+	{
+		i--;
+	}
+	cell &= RENDER_OBJECT_MASK | RENDER_PLAYER;
+	if (i > 0 && pending[i - 1].row == row && pending[i - 1].col == col)
+	{
+		pending[i - 1].cell = cell;
+		return;
+	}
+
+	if (num_pending == MAX_PENDING)
+	{
+		draw_pending();
+		i = 0;
+	}
+	memmove(&pending[i + 1], &pending[i],
+		(num_pending - i) * sizeof(PendingSquare));
+	pending[i].row = row;
+	pending[i].col = col;
+	pending[i].cell = cell;
+	num_pending++;
+}
+
+// Shows the recent player locations (for testing). These change with
+// every move, so they are sent straight away.
+static void draw_history(const RenderHistory *history)
+{
+	for (uint8_t i = 0; i < history->length; i++)
+	{
+		uint16_t location = history->locations[i];
+		move_terminal_cursor(i, 60);
+		clear_to_end_of_line();
+		fmt_put_P(PSTR("row "));
+		fmt_put_u16(location == 0xFFFF ? 0xFF : location >> 8, 0);
+		fmt_put_P(PSTR(", col "));
+		fmt_put_u16(location == 0xFFFF ? 0xFF : location & 0xFF, 0);
+	}
+	move_terminal_cursor(6, 60);
+	clear_to_end_of_line();
+	fmt_put_P(PSTR("pre row "));
+	fmt_put_u16(history->previous_row, 0);
+	fmt_put_P(PSTR(", pre col "));
+	fmt_put_u16(history->previous_col, 0);
+	move_terminal_cursor(7, 60);
+	clear_to_end_of_line();
+	fmt_put_P(PSTR("b in t: "));
+	fmt_put_u16(history->boxes_in_target, 0);
+}
+
+static void terminal_status_changed(RenderStatus status, const void *data)
+{
+	switch (status)
+	{
+		case RENDER_STATUS_BOARD_RESET:
+			// The terminal may have been cleared. Every square
+			// follows, so anything pending is replaced.
+			map_rows = ((const RenderMap *)data)->rows;
+			num_pending = 0;
+			shown_message_known = false;
+			break;
+		case RENDER_STATUS_MESSAGE:
+			next_message = data;
+			break;
+		case RENDER_STATUS_HISTORY:
+			draw_history(data);
+			break;
+		default:
+			break;
+	}
+}
+
+static void terminal_flush(void)
+{
+	draw_pending();
+	if (!shown_message_known || next_message != shown_message)
+	{
+		move_terminal_cursor(TERMINAL_MESSAGE_ROW, TERMINAL_MESSAGE_COL);
+		clear_to_end_of_line();
+		if (next_message)
+		{
+			fmt_put_P(next_message);
+		}
+		shown_message = next_message;
+		shown_message_known = true;
+	}
+}
+
+const RenderBackend render_terminal =
+{
+	.cell_changed = terminal_cell_changed,
+	.status_changed = terminal_status_changed,
+	.flush = terminal_flush
+};
@@ -0,0 +1,196 @@
+/*
+ * savestate.c
+ *
+ * Author: Sithika Mannakkara
+ */
+
+#include "savestate.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include "eeprom_async.h"
+#include "game.h"
+
+// Snapshot format version. This must be changed whenever the layout of
+// SaveState (or BoardState) changes, so that old snapshots are ignored.
+#define SAVESTATE_VERSION	(2)
+
+// A snapshot as stored in EEPROM. The checksum must be the last field, so
+// that it is the last byte written.
+typedef struct
+{
+	uint8_t version;
+	uint8_t sequence;
+	BoardState board;
+	uint16_t elapsed_time;
+	uint16_t moves;
+	uint16_t checksum;
+} SaveState;
+
+// Snapshots alternate between two slots.
+#define NUM_SLOTS	(2)
+#define SLOT_SIZE	(EEPROM_SAVESTATE_SIZE / NUM_SLOTS)
+#define NO_SLOT 	(0xFF)
+
+_Static_assert(sizeof(SaveState) <= SLOT_SIZE,
+	"a snapshot doesn't fit in its slot");
+
+// The slot holding the most recent valid snapshot (or NO_SLOT), the slot the
+// next snapshot will be written to and the sequence number of the most
+// recent snapshot.
+static uint8_t valid_slot;
+static uint8_t next_slot;
+static uint8_t sequence;
+
+// Whether a new snapshot has been requested, and the elapsed time in the
+// most recent snapshot.
+static bool requested;
+static uint16_t saved_time;
+
+// The snapshot being written, and the jobs used to write and clear it.
+static SaveState snapshot;
+static EepromJob snapshot_job;
+static EepromJob clear_jobs[NUM_SLOTS];
+static const uint8_t invalid_version = 0;
+
+static uint16_t slot_address(uint8_t slot)
+{
+	return EEPROM_SAVESTATE_BASE + slot * SLOT_SIZE;
+}
+
+// Calculates the checksum of a snapshot (covering all fields but the
+// checksum).
+static uint16_t snapshot_checksum(const SaveState *state)
+{
+	const uint8_t *bytes = (const uint8_t *)state;
+	uint16_t crc = 0;
+	for (uint8_t i = 0; i < sizeof(SaveState) - sizeof(state->checksum);
+		i++)
+	{
+		crc = _crc_xmodem_update(crc, bytes[i]);
+	}
+	return crc;
+}
+
+// Reads a snapshot from EEPROM and checks whether it is valid.
+static bool read_slot(uint8_t slot, SaveState *state)
+{
+	eeprom_read_block(state, (const void *)slot_address(slot),
+		sizeof(SaveState));
+	return state->version == SAVESTATE_VERSION &&
+		state->checksum == snapshot_checksum(state);
+}
+
+void init_savestate(void)
+{
+	valid_slot = NO_SLOT;
+	next_slot = 0;
+	sequence = 0;
+	requested = false;
+	saved_time = 0;
+	snapshot_job.pending = false;
+	for (uint8_t slot = 0; slot < NUM_SLOTS; slot++)
+	{
+		clear_jobs[slot].pending = false;
+	}
+
+	for (uint8_t slot = 0; slot < NUM_SLOTS; slot++)
+	{
+		if (!read_slot(slot, &snapshot))
+		{
+			continue;
+		}
+
+		// The newer of the two snapshots is the one whose sequence
+		// number is one ahead of the other (allowing for wrap around).
+		if (valid_slot == NO_SLOT ||
+			(uint8_t)(snapshot.sequence - sequence) < 0x80)
+		{
+			valid_slot = slot;
+			sequence = snapshot.sequence;
+		}
+	}
+	if (valid_slot != NO_SLOT)
+	{
+		// Write the next snapshot over the older one.
+		next_slot = valid_slot ^ 1;
+	}
+}
+
+bool savestate_available(void)
+{
+	return valid_slot != NO_SLOT;
+}
+
+bool savestate_restore(uint16_t *elapsed_time, uint16_t *moves)
+{
+	// The slot is read again rather than kept in SRAM since it is only
+	// needed once. Nothing is being written at this point.
+	if (valid_slot == NO_SLOT || !read_slot(valid_slot, &snapshot))
+	{
+		return false;
+	}
+	restore_board_state(&snapshot.board);
+	saved_time = snapshot.elapsed_time;
+	*elapsed_time = snapshot.elapsed_time;
+	*moves = snapshot.moves;
+	return true;
+}
+
+void savestate_request(void)
+{
+	requested = true;
+}
+
+void savestate_time_changed(uint16_t elapsed_time)
+{
+	// The time may also have gone back, if a new game has started.
+	if ((uint16_t)(elapsed_time - saved_time) >= SAVESTATE_TIME_INTERVAL)
+	{
+		requested = true;
+	}
+}
+
+void savestate_update(uint16_t elapsed_time, uint16_t moves)
+{
+	if (!requested || snapshot_job.pending)
+	{
+		return;
+	}
+	requested = false;
+
+	snapshot.version = SAVESTATE_VERSION;
+	snapshot.sequence = ++sequence;
+	get_board_state(&snapshot.board);
+	snapshot.elapsed_time = elapsed_time;
+	saved_time = elapsed_time;
+	snapshot.moves = moves;
+	snapshot.checksum = snapshot_checksum(&snapshot);
+
+	snapshot_job.address = slot_address(next_slot);
+	snapshot_job.data = (const uint8_t *)&snapshot;
+	snapshot_job.length = sizeof(snapshot);
+	(void)eeprom_async_submit(&snapshot_job);
+
+	valid_slot = next_slot;
+	next_slot ^= 1;
+}
+
+void savestate_clear(void)
+{
+	requested = false;
+	valid_slot = NO_SLOT;
+
+	// Overwrite the version of both slots so neither is valid. These are
+	// queued after any snapshot still being written.
+	for (uint8_t slot = 0; slot < NUM_SLOTS; slot++)
+	{
+		clear_jobs[slot].address = slot_address(slot) +
+			offsetof(SaveState, version);
+		clear_jobs[slot].data = &invalid_version;
+		clear_jobs[slot].length = sizeof(invalid_version);
+		(void)eeprom_async_submit(&clear_jobs[slot]);
+	}
+}
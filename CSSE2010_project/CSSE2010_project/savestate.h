@@ -0,0 +1,80 @@
+/*
+ * savestate.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Suspend/resume of the game in progress. A snapshot of the board, player
+ * location, elapsed time and move count is kept in EEPROM so that a game
+ * interrupted by a reset or power loss can be resumed. Snapshots alternate
+ * between two slots, each protected by a checksum, so a snapshot torn by a
+ * reset part way through writing never replaces the previous good one.
+ * Since the EEPROM writer skips bytes that haven't changed, only the few
+ * bytes that differ from the snapshot two moves ago are actually programmed.
+ *
+ * Every snapshot reprograms its sequence number, time and checksum, so
+ * snapshots are only taken when the game changes (a move, an undo or a
+ * restart), and when only the time has changed, at most once every
+ * SAVESTATE_TIME_INTERVAL seconds. A game left running therefore costs each
+ * of those bytes a write every two minutes rather than every two seconds.
+ */
+
+#ifndef SAVESTATE_H_
+#define SAVESTATE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Fewest seconds between snapshots taken only because the time has changed.
+#define SAVESTATE_TIME_INTERVAL	(60)
+
+/// <summary>
+/// Loads the most recent snapshot from EEPROM (if there is one). This
+/// function blocks while the EEPROM is read, and must be called after
+/// init_eeprom_async() and before any of the other savestate functions.
+/// This function should only be called once.
+/// </summary>
+void init_savestate(void);
+
+/// <summary>
+/// Tests if there is a game that can be resumed.
+/// </summary>
+/// <returns>Whether a saved game is available.</returns>
+bool savestate_available(void);
+
+/// <summary>
+/// Restores the saved game. The board and player location are restored
+/// (see restore_board_state()) and the counters are returned.
+/// </summary>
+/// <param name="elapsed_time">Set to the elapsed time in seconds.</param>
+/// <param name="moves">Set to the number of valid moves made.</param>
+/// <returns>Whether a saved game was restored.</returns>
+bool savestate_restore(uint16_t *elapsed_time, uint16_t *moves);
+
+/// <summary>
+/// Marks the game state as changed, so that a new snapshot is written the
+/// next time savestate_update() is called with the writer idle.
+/// </summary>
+void savestate_request(void);
+
+/// <summary>
+/// Requests a new snapshot if the elapsed time is at least
+/// SAVESTATE_TIME_INTERVAL seconds on from the last one. Should be called
+/// when the elapsed time changes.
+/// </summary>
+/// <param name="elapsed_time">The elapsed time in seconds.</param>
+void savestate_time_changed(uint16_t elapsed_time);
+
+/// <summary>
+/// Writes a new snapshot if one has been requested and the previous one has
+/// finished being written. Should be called regularly from the main loop.
+/// </summary>
+/// <param name="elapsed_time">The elapsed time in seconds.</param>
+/// <param name="moves">The number of valid moves made.</param>
+void savestate_update(uint16_t elapsed_time, uint16_t moves);
+
+/// <summary>
+/// Discards the saved game (e.g., once the level has been completed).
+/// </summary>
+void savestate_clear(void);
+
+#endif /* SAVESTATE_H_ */
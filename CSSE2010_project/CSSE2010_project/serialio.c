@@ -15,13 +15,18 @@
 // character is available. If interrupts are disabled when input is sought,
 // then this will block forever. The function input_available() can be used to
 // test whether there is input available to read from stdin.
+// In binary mode, stdio output is discarded and serial_read_raw() and
+// serial_write_raw() are used to exchange bytes without any translation
+// (no CR/LF conversion or arrow key mapping).
 
 #include "serialio.h"
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include "cpuload.h"
 
 // System clock rate in Hz. L at the end indicates this is a long constant.
 #define SYSCLK 8000000L
@@ -42,8 +47,8 @@ volatile uint8_t out_insert_pos;
 volatile uint8_t bytes_in_out_buffer;
 
 // Circular buffer to hold incoming characters. Works on same principle
-// as output buffer.
-#define INPUT_BUFFER_SIZE 16
+// as output buffer. Big enough for three maximum size remote frames.
+#define INPUT_BUFFER_SIZE 128
 volatile char input_buffer[INPUT_BUFFER_SIZE];
 volatile uint8_t input_insert_pos;
 volatile uint8_t bytes_in_input_buffer;
@@ -53,17 +58,18 @@ volatile uint8_t input_overrun;
 // back or not.
 static bool do_echo;
 
-static int uart_put_char(char c, FILE *stream)
+// Whether the serial port is in binary mode.
+static volatile bool binary_mode;
+
+// Error between the configured and requested baud rates, in tenths of a
+// percent.
+static int16_t baud_error;
+
+static int uart_put_byte(uint8_t c)
 {
 	// Add the character to the buffer for transmission (if there is space
 	// to do so). If not we wait until the buffer has space.
 
-	// If the character is linefeed, we output carriage return.
-	if (c == '\n')
-	{
-		uart_put_char('\r', stream);
-	}
-
 	// If the buffer is full and interrupts are disabled then we abort -
 	// we don't output the character since the buffer will never be
 	// emptied if interrupts are disabled. If the buffer is full and
@@ -106,14 +112,26 @@ static int uart_put_char(char c, FILE *stream)
 	return 0;
 }
 
-static int uart_get_char(FILE *stream)
+static int uart_put_char(char c, FILE *stream)
 {
-	// Wait until we've received a character.
-	while (bytes_in_input_buffer == 0)
+	// Text output is discarded in binary mode.
+	if (binary_mode)
 	{
-		// Do nothing.
+		return 0;
+	}
+
+	// If the character is linefeed, we output carriage return.
+	if (c == '\n')
+	{
+		uart_put_byte('\r');
 	}
+	return uart_put_byte(c);
+}
 
+// Removes the next character from the input buffer. Must only be called if
+// there is a character available.
+static char uart_remove_char(void)
+{
 	// Turn interrupts off and remove a character from the input buffer.
 	// We reenable interrupts if they were on. The pending character is
 	// the one which is byte_in_input_buffer characters before the insert
@@ -138,6 +156,24 @@ static int uart_get_char(FILE *stream)
 	{
 		sei();
 	}
+	return c;
+}
+
+static int uart_get_char(FILE *stream)
+{
+	// Wait until we've received a character.
+	while (bytes_in_input_buffer == 0)
+	{
+		// Do nothing.
+	}
+
+	char c = uart_remove_char();
+
+	// If the character is carriage return, turn it into linefeed.
+	if (c == '\r')
+	{
+		c = '\n';
+	}
 
 	// Secretly map the arrows keys to WASD. We essentially replace the
 	// last char of the arrow key escape sequences with WASD. This will
@@ -182,6 +218,8 @@ static FILE serialio = FDEV_SETUP_STREAM(uart_put_char, uart_get_char,
 // can be taken from our buffer and written out).
 ISR(USART0_UDRE_vect)
 {
+	uint16_t start = cpuload_isr_enter();
+
 	// Check if we have data in our buffer.
 	if (bytes_in_out_buffer > 0)
 	{
@@ -216,16 +254,20 @@ ISR(USART0_UDRE_vect)
 		// when a character is placed in the buffer.
 		UCSR0B &= ~(1 << UDRIE0);
 	}
+
+	cpuload_isr_exit(start);
 }
 
 // Interrupt handler for UART Receive Complete (i.e., can read a character).
 // The character is read and placed in the input buffer.
 ISR(USART0_RX_vect)
 {
+	uint16_t start = cpuload_isr_enter();
+
 	// Read the character - we ignore the possibility of overrun.
 	char c = UDR0;
 
-	if (do_echo && bytes_in_out_buffer < OUTPUT_BUFFER_SIZE)
+	if (do_echo && !binary_mode && bytes_in_out_buffer < OUTPUT_BUFFER_SIZE)
 	{
 		// If echoing is enabled and there is output buffer space,
 		// echo the received character back to the UART. If there
@@ -242,13 +284,9 @@ ISR(USART0_RX_vect)
 	}
 	else
 	{
-		// If the character is carriage return, turn it into linefeed.
-		if (c == '\r')
-		{
-			c = '\n';
-		}
-
-		// There is room in the input buffer.
+		// There is room in the input buffer. Characters are stored
+		// as received (carriage returns are converted when read
+		// through stdio), so the buffer can also hold binary data.
 		input_buffer[input_insert_pos++] = c;
 		bytes_in_input_buffer++;
 		if (input_insert_pos == INPUT_BUFFER_SIZE)
@@ -257,6 +295,31 @@ ISR(USART0_RX_vect)
 			input_insert_pos = 0;
 		}
 	}
+
+	cpuload_isr_exit(start);
+}
+
+// Calculates the UBRR value closest to the given baud rate for a UART clock
+// divider of 16 (normal mode) or 8 (double speed mode), and returns the error
+// of the resulting rate in tenths of a percent. This differs from the
+// datasheet formula so that we get rounding to the nearest integer while
+// using integer division (which truncates).
+static int16_t baud_rate_error(long baudrate, uint8_t divider, uint16_t *ubrr)
+{
+	long value = (((SYSCLK / (divider / 2 * baudrate)) + 1) / 2) - 1;
+	if (value < 0)
+	{
+		value = 0;
+	}
+	else if (value > 4095)
+	{
+		// UBRR0 is a 12 bit register.
+		value = 4095;
+	}
+	*ubrr = (uint16_t)value;
+
+	long actual = SYSCLK / (divider * (value + 1));
+	return (int16_t)((actual - baudrate) * 1000 / baudrate);
 }
 
 void init_serial_stdio(long baudrate, bool echo)
@@ -270,11 +333,25 @@ void init_serial_stdio(long baudrate, bool echo)
 
 	// Record whether we're going to echo characters or not.
 	do_echo = echo;
-
-	// Configure the baud rate. This differs from the datasheet formula so
-	// that we get rounding to the nearest integer while using integer
-	// division (which truncates).
-	UBRR0 = (uint16_t)((((SYSCLK / (8 * baudrate)) + 1) / 2) - 1);
+	binary_mode = false;
+
+	// Configure the baud rate. The UART divides the clock by 16 in normal
+	// mode and by 8 in double speed (U2X) mode. We use whichever gives the
+	// closer rate, preferring normal mode on a tie as the receiver takes
+	// more samples per bit.
+	uint16_t ubrr;
+	bool double_speed = false;
+	baud_error = baud_rate_error(baudrate, 16, &ubrr);
+	uint16_t ubrr_u2x;
+	int16_t error_u2x = baud_rate_error(baudrate, 8, &ubrr_u2x);
+	if (abs(error_u2x) < abs(baud_error))
+	{
+		ubrr = ubrr_u2x;
+		baud_error = error_u2x;
+		double_speed = true;
+	}
+	UBRR0 = ubrr;
+	UCSR0A = double_speed ? (1 << U2X0) : 0;
 
 	// Enable transmission and receiving via UART. We don't enable the UDR
 	// empty interrupt here (we wait until we've got a character to
@@ -292,6 +369,16 @@ void init_serial_stdio(long baudrate, bool echo)
 	stdin = &serialio;
 }
 
+int16_t serial_baud_error(void)
+{
+	return baud_error;
+}
+
+uint8_t serial_output_space(void)
+{
+	return OUTPUT_BUFFER_SIZE - bytes_in_out_buffer;
+}
+
 bool serial_input_available(void)
 {
 	return bytes_in_input_buffer != 0;
@@ -303,3 +390,65 @@ void clear_serial_input_buffer(void)
 	input_insert_pos = 0;
 	bytes_in_input_buffer = 0;
 }
+
+void serial_set_binary_mode(bool binary)
+{
+	binary_mode = binary;
+}
+
+int serial_read_raw(void)
+{
+	if (bytes_in_input_buffer == 0)
+	{
+		return -1;
+	}
+	return (uint8_t)uart_remove_char();
+}
+
+// Adds a block of bytes to the output buffer. Works like uart_put_byte(),
+// but waits for space for the whole block and copies it with interrupts off
+// only once, so it costs a few cycles per byte rather than a function call
+// and an interrupt enable per byte.
+static void uart_put_block(const uint8_t *data, uint8_t length)
+{
+	bool interrupts_enabled = bit_is_set(SREG, SREG_I);
+	while (OUTPUT_BUFFER_SIZE - bytes_in_out_buffer < length)
+	{
+		if (!interrupts_enabled)
+		{
+			return;
+		}
+	}
+
+	cli();
+	uint8_t insert_pos = out_insert_pos;
+	for (uint8_t i = 0; i < length; i++)
+	{
+		out_buffer[insert_pos++] = data[i];
+		if (insert_pos == OUTPUT_BUFFER_SIZE)
+		{
+			insert_pos = 0;
+		}
+	}
+	out_insert_pos = insert_pos;
+	bytes_in_out_buffer += length;
+	UCSR0B |= (1 << UDRIE0);
+	if (interrupts_enabled)
+	{
+		sei();
+	}
+}
+
+void serial_write_raw(const uint8_t *data, uint8_t length)
+{
+	uart_put_block(data, length);
+}
+
+void serial_write_text(const char *text, uint8_t length)
+{
+	// Text output is discarded in binary mode.
+	if (!binary_mode)
+	{
+		uart_put_block((const uint8_t *)text, length);
+	}
+}
@@ -18,10 +18,28 @@
 /// before any of the standard I/O functions. This function should only
 /// be called once.
 /// </summary>
-/// <param name="baudrate">The baud rate (e.g., 19200).</param>
+/// <param name="baudrate">The baud rate (e.g., 19200). Rates up to 1000000
+/// are possible, but only those dividing the clock evenly (e.g., 250000) are
+/// exact.</param>
 /// <param name="echo">Whether inputs are echoed back.</param>
 void init_serial_stdio(long baudrate, bool echo);
 
+/// <summary>
+/// Gets the difference between the baud rate the UART was configured with
+/// and the one requested. Errors beyond about 2% are likely to cause
+/// garbled characters.
+/// </summary>
+/// <returns>The error in tenths of a percent (positive if the UART is
+/// fast).</returns>
+int16_t serial_baud_error(void);
+
+/// <summary>
+/// Gets the number of bytes that can be written to the serial port without
+/// blocking (i.e., the free space in the output buffer).
+/// </summary>
+/// <returns>The number of bytes free.</returns>
+uint8_t serial_output_space(void);
+
 /// <summary>
 /// Tests if input is available from the serial port. If there is
 /// input available, then it can be read with a suitable standard I/O
@@ -36,4 +54,36 @@ bool serial_input_available(void);
 /// </summary>
 void clear_serial_input_buffer(void);
 
+/// <summary>
+/// Switches binary mode on or off. In binary mode, anything written through
+/// the standard I/O functions is discarded and inputs are not echoed.
+/// </summary>
+/// <param name="binary">Whether to use binary mode.</param>
+void serial_set_binary_mode(bool binary);
+
+/// <summary>
+/// Reads a byte from the serial port without any translation. Does not
+/// block.
+/// </summary>
+/// <returns>The byte read, or -1 if no input is available.</returns>
+int serial_read_raw(void);
+
+/// <summary>
+/// Writes bytes to the serial port without any translation. Blocks while
+/// the output buffer is full (if interrupts are enabled).
+/// </summary>
+/// <param name="data">The bytes to write.</param>
+/// <param name="length">The number of bytes to write.</param>
+void serial_write_raw(const uint8_t *data, uint8_t length);
+
+/// <summary>
+/// Writes text to the serial port, bypassing standard I/O. Unlike the
+/// standard I/O functions, line feeds are not translated. The text is
+/// discarded in binary mode. Blocks while the output buffer doesn't have
+/// room for all of the text (if interrupts are enabled).
+/// </summary>
+/// <param name="text">The text to write.</param>
+/// <param name="length">The number of characters to write.</param>
+void serial_write_text(const char *text, uint8_t length);
+
 #endif /* SERIALIO_H_ */
@@ -0,0 +1,159 @@
+/*
+ * ssd.c
+ *
+ * Author: Sithika Mannakkara
+ */
+
+#include "ssd.h"
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "timer0.h"
+#include "cpuload.h"
+
+#define NUM_SLOTS	(SSD_NUM_DIGITS * SSD_BRIGHTNESS_LEVELS)
+
+// Calls timed by ssd_refresh_cycles(), a whole number of turns through the
+// slots, and CPU cycles per timestamp counter tick.
+#define TIMED_CALLS    	(NUM_SLOTS * 32)
+#define CYCLES_PER_TICK	(8)
+
+// Segment patterns for 0 to 9.
+static const uint8_t seven_seg_data[10] = { 63, 6, 91, 79, 102, 109, 125, 7,
+	127, 111 };
+
+// Port C value that selects each digit.
+static const uint8_t digit_select[SSD_NUM_DIGITS] = { 0, (1 << 7) };
+
+// What is being shown, and how brightly.
+static uint8_t segments[SSD_NUM_DIGITS];
+static uint8_t brightness;
+
+// The port values written by the refresh timer, and the next one to write.
+// Only the refresh timer uses next_slot.
+static uint8_t slots[NUM_SLOTS];
+static uint8_t next_slot;
+static SoftTimer refresh_timer;
+
+// Works out the port values for the current segments and brightness.
+static void fill_slots(void)
+{
+	uint8_t new_slots[NUM_SLOTS];
+	uint8_t slot = 0;
+	for (uint8_t digit = 0; digit < SSD_NUM_DIGITS; digit++)
+	{
+		for (uint8_t level = 0; level < SSD_BRIGHTNESS_LEVELS; level++)
+		{
+			// The digit stays selected while it is dark, so that the
+			// other digit doesn't get any extra time.
+			new_slots[slot++] = digit_select[digit] |
+				(level < brightness ? segments[digit] : 0);
+		}
+	}
+
+	// Copy with interrupts off so a refresh never mixes the old and new
+	// values.
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	for (uint8_t i = 0; i < NUM_SLOTS; i++)
+	{
+		slots[i] = new_slots[i];
+	}
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+}
+
+// Refresh timer callback. Shows the next slot.
+static void refresh(void)
+{
+	uint8_t slot = next_slot;
+	PORTC = slots[slot];
+	if (++slot == NUM_SLOTS)
+	{
+		slot = 0;
+	}
+	next_slot = slot;
+}
+
+void init_ssd(uint16_t refresh_rate)
+{
+	for (uint8_t digit = 0; digit < SSD_NUM_DIGITS; digit++)
+	{
+		segments[digit] = 0;
+	}
+	brightness = SSD_BRIGHTNESS_LEVELS;
+	next_slot = 0;
+	fill_slots();
+	DDRC = 0xFF;
+
+	// Show one slot per timer run.
+	uint32_t slot_rate = (uint32_t)refresh_rate * NUM_SLOTS;
+	uint32_t period = slot_rate ? (1000 + slot_rate / 2) / slot_rate : 0;
+	if (period == 0)
+	{
+		period = 1;
+	}
+	else if (period > UINT16_MAX)
+	{
+		period = UINT16_MAX;
+	}
+	soft_timer_start(&refresh_timer, period, period, refresh);
+}
+
+void ssd_set_brightness(uint8_t level)
+{
+	brightness = level < SSD_BRIGHTNESS_LEVELS ? level :
+		SSD_BRIGHTNESS_LEVELS;
+	fill_slots();
+}
+
+void ssd_show_number(uint16_t value)
+{
+	for (uint8_t digit = 0; digit < SSD_NUM_DIGITS; digit++)
+	{
+		segments[digit] = seven_seg_data[value % 10];
+		value /= 10;
+	}
+	fill_slots();
+}
+
+void ssd_show_segments(const uint8_t new_segments[SSD_NUM_DIGITS])
+{
+	for (uint8_t digit = 0; digit < SSD_NUM_DIGITS; digit++)
+	{
+		segments[digit] = new_segments[digit] & 0x7F;
+	}
+	fill_slots();
+}
+
+void ssd_clear(void)
+{
+	for (uint8_t digit = 0; digit < SSD_NUM_DIGITS; digit++)
+	{
+		segments[digit] = 0;
+	}
+	fill_slots();
+}
+
+uint16_t ssd_refresh_cycles(void)
+{
+	// Called through a pointer, as the timer wheel does, so that the
+	// call isn't inlined.
+	void (*volatile callback)(void) = refresh;
+
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	uint16_t start = cpuload_timestamp();
+	for (uint16_t i = 0; i < TIMED_CALLS; i++)
+	{
+		callback();
+	}
+	uint16_t elapsed = cpuload_timestamp() - start;
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+	return (uint32_t)elapsed * CYCLES_PER_TICK / TIMED_CALLS;
+}
@@ -0,0 +1,83 @@
+/*
+ * ssd.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Driver for the multiplexed seven segment display on port C (segments on
+ * pins 0 - 6, digit select on pin 7), refreshed by a timer 0 software timer.
+ *
+ * Everything the display shows is worked out in advance into a buffer of
+ * port values, one per timer tick. Each digit gets SSD_BRIGHTNESS_LEVELS
+ * consecutive slots in the buffer, and the brightness sets how many of them
+ * light the digit (software PWM). The timer callback only writes the next
+ * slot to the port. Since the timer ticks at most once a millisecond, the
+ * fastest refresh is 1000 / (SSD_NUM_DIGITS * SSD_BRIGHTNESS_LEVELS) Hz.
+ *
+ * The callback takes about 22 cycles per tick, including its call, and the
+ * timer wheel takes about 60 more to find and re-arm the timer (counted
+ * from the instructions; ssd_refresh_cycles() times the callback on the
+ * device). At SSD_REFRESH_RATE it runs every millisecond, so about 82,000
+ * cycles a second: 1.0% of the CPU at 8MHz, 0.3% of it the callback.
+ */
+
+#ifndef SSD_H_
+#define SSD_H_
+
+#include <stdint.h>
+
+// Number of digits on the display.
+#define SSD_NUM_DIGITS	(2)
+
+// Number of brightness levels above off. The timer runs this many times per
+// digit per refresh.
+#define SSD_BRIGHTNESS_LEVELS	(4)
+
+// Default refresh rate of the whole display in Hz (the fastest possible).
+#define SSD_REFRESH_RATE	(125)
+
+/// <summary>
+/// Initialises the seven segment display and starts refreshing it. The
+/// display is blank and at full brightness. This function must be called
+/// after init_timer0() and before any of the other seven segment display
+/// functions. This function should only be called once.
+/// </summary>
+/// <param name="refresh_rate">Refresh rate of the whole display in Hz (at
+/// most SSD_REFRESH_RATE). The rate is rounded to a whole number of
+/// milliseconds per slot.</param>
+void init_ssd(uint16_t refresh_rate);
+
+/// <summary>
+/// Sets the brightness of the display.
+/// </summary>
+/// <param name="level">The brightness, from 0 (off) to
+/// SSD_BRIGHTNESS_LEVELS (full).</param>
+void ssd_set_brightness(uint8_t level);
+
+/// <summary>
+/// Shows a number on the display. Only the lowest SSD_NUM_DIGITS digits are
+/// shown, with leading zeros.
+/// </summary>
+/// <param name="value">The number to show.</param>
+void ssd_show_number(uint16_t value);
+
+/// <summary>
+/// Shows arbitrary segment patterns on the display.
+/// </summary>
+/// <param name="segments">The segments to light for each digit, starting
+/// with the right-most digit. Bit 0 is segment a, bit 6 is segment g.
+/// </param>
+void ssd_show_segments(const uint8_t segments[SSD_NUM_DIGITS]);
+
+/// <summary>
+/// Turns off all segments.
+/// </summary>
+void ssd_clear(void);
+
+/// <summary>
+/// Times the refresh callback with the timestamp counter (see cpuload.h),
+/// with interrupts off. The display is left showing the same slot.
+/// </summary>
+/// <returns>Average cycles per call, including the call itself.</returns>
+uint16_t ssd_refresh_cycles(void);
+
+#endif /* SSD_H_ */
@@ -8,11 +8,12 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
-#include <string.h>
 #include <avr/pgmspace.h>
 #include "pixel_colour.h"
 #include "ledmatrix.h"
+#include "display.h"
 #include "terminalio.h"
+#include "serialio.h"
 #include "timer0.h"
 
 // Speed definitions.
@@ -21,94 +22,11 @@
 #define STATIC_TIME 	(1000)
 #define SCROLL_SPEED	(200)
 
-// Short colour definitions.
-#define G	(COLOUR_GREEN)
-#define O	(COLOUR_ORANGE)
-#define D	(COLOUR_DARK_GREEN)
-#define _	(COLOUR_BLACK)
-
-// The animation data for the start screen. It is an array of MatrixColumns,
-// with the 0th element being the left-most column of the start screen and the
-// last element being the right-most column of the start screen. It must have
-// at least MATRIX_NUM_COLUMN elements.
-const MatrixColumn anim_data[] PROGMEM =
-{
-	{ G, G, _, G, G, G, G, _ },
-	{ G, _, _, G, _, _, G, _ },
-	{ G, _, _, G, _, _, G, _ },
-	{ G, G, G, G, _, G, G, _ },
-	{ _, _, _, _, _, _, _, _ },
-	{ G, G, G, G, G, _, _, _ },
-	{ G, _, _, _, G, _, _, _ },
-	{ G, _, _, _, G, _, _, _ },
-	{ G, G, G, G, G, _, _, _ },
-	{ _, _, _, _, _, _, _, _ },
-	{ G, G, G, G, G, G, G, _ },
-	{ _, _, _, G, _, _, _, _ },
-	{ _, _, G, _, G, _, _, _ },
-	{ G, G, _, _, _, G, _, _ },
-	{ _, _, _, _, _, _, _, _ },
-	{ G, G, G, G, G, _, _, _ },
-	{ G, _, _, _, G, _, _, _ },
-	{ G, _, _, _, G, _, _, _ },
-	{ G, G, G, G, G, _, _, _ },
-	{ _, _, _, _, _, _, _, _ },
-	{ G, G, G, G, G, G, G, _ },
-	{ G, _, _, G, _, _, _, _ },
-	{ G, _, _, G, _, _, _, _ },
-	{ G, G, G, G, _, _, _, _ },
-	{ _, _, _, _, _, _, _, _ },
-	{ G, G, G, _, G, _, _, _ },
-	{ G, _, G, _, G, _, _, _ },
-	{ G, _, G, _, G, _, _, _ },
-	{ G, G, G, G, G, _, _, _ },
-	{ _, _, _, _, _, _, _, _ },
-	{ G, G, G, G, G, _, _, _ },
-	{ _, _, _, _, G, _, _, _ },
-	{ _, _, _, _, G, _, _, _ },
-	{ G, G, G, G, G, _, _, _ },
-	{ _, _, _, _, _, _, _, _ },
-	{ _, _, _, _, _, _, _, _ },
-	{ O, O, O, O, O, O, _, _ },
-	{ O, O, _, _, O, O, _, _ },
-	{ O, _, O, O, _, O, _, _ },
-	{ O, _, O, O, _, O, _, _ },
-	{ O, O, _, _, O, O, _, _ },
-	{ O, O, O, O, O, O, _, _ },
-	{ _, _, _, D, _, D, _, _ },
-	{ D, _, _, D, _, D, _, _ },
-	{ _, D, _, _, D, _, D, D },
-	{ _, _, D, D, _, D, D, D },
-	{ _, D, _, _, _, _, D, D },
-	{ D, _, _, _, _, _, _, _ },
-	{ _, _, _, _, _, _, _, _ },
-	{ _, _, _, _, _, _, _, _ }
-};
-
-// Undefine the short colour definitions.
-#undef G
-#undef O
-#undef D
-#undef _
-
-// Terminal ASCII art data bits. Each element in this array represents a line
-// of the ASCII art. The ASCII art has a width of 64 characters, and each bit
-// in the unsigned 64-bit integer represents a column/pixel.
-static const uint64_t title_data[] PROGMEM =
-{
-	0b1111111001111110011000110011111100111111000111110011100001100000,
-	0b1100000011000011011001100110000110110001101100011011110001100000,
-	0b1111111011000011011111000110000110111111001111111011011001100000,
-	0b0000011011000011011001100110000110110001101100011011001101100000,
-	0b1111111001111110011000110011111100111111001100011011000111100000
-};
-
-// The colour definitions for the ASCII terminal title art. The positions
-// represent the columns which colour changes occur (highest to lowest), and
-// each position has a corresponding terminal attribute.
-const uint8_t title_pos[] = { 58, 48, 40, 32, 23, 15, 6 };
-const DisplayParameter title_attr[] = { BG_CYAN, BG_WHITE, BG_RED,
-	BG_YELLOW, BG_BLUE, BG_GREEN, BG_MAGENTA };
+// The title art and animation data are generated from
+// tools/assets/startscrn.txt by the asset compiler (run "make assets" in
+// tools/). The title is a list of spans of coloured cells with their terminal
+// attributes, and the animation is packed 2 bits per pixel against a palette.
+#include "startscrn_assets.h"
 
 // For course staff: Code and defintions blow this point should not be
 // modified unless the operation of the start screen is to be changed.
@@ -135,32 +53,40 @@ static uint8_t next_column;
 #define min(a, b) (((a) < (b)) ? (a) : (b))
 #endif
 
-// Macro for returning the number of elements in an array.
-#define countof(x) (sizeof(x) / sizeof((x)[0]))
-
 // Macro for getting next column number.
-#define GET_NEXT_COLUMN(x, d) (((x) + 1) % countof((d)))
+#define GET_NEXT_COLUMN(x) (((x) + 1) % ANIM_NUM_COLUMNS)
+
+// Unpacks a column of the animation.
+static void load_anim_column(uint8_t col, MatrixColumn column_data)
+{
+	uint16_t packed = pgm_read_word(&anim_columns[col]);
+	for (uint8_t row = 0; row < MATRIX_NUM_ROWS; row++)
+	{
+		column_data[row] = pgm_read_byte(&anim_palette[packed & 3]);
+		packed >>= 2;
+	}
+}
 
 // Displays the initial image of the start screen.
 static void display_initial_image(void)
 {
 	for (uint8_t col = 0; col < min(MATRIX_NUM_COLUMNS,
-		countof(anim_data)); col++)
+		ANIM_NUM_COLUMNS); col++)
 	{
 		MatrixColumn column_data;
-		memcpy_P(column_data, &anim_data[col], sizeof(column_data));
-		ledmatrix_update_column(col, column_data);
+		load_anim_column(col, column_data);
+		display_set_column(col, column_data);
 	}
 }
 
 // Displays the next column of the start screen.
 static void display_next_column(void)
 {
-	ledmatrix_shift_display_left();
+	display_shift(DISPLAY_SHIFT_LEFT);
 	MatrixColumn column_data;
-	memcpy_P(column_data, &anim_data[next_column], sizeof(column_data));
-	ledmatrix_update_column(MATRIX_NUM_COLUMNS - 1, column_data);
-	next_column = GET_NEXT_COLUMN(next_column, anim_data);
+	load_anim_column(next_column, column_data);
+	display_set_column(MATRIX_NUM_COLUMNS - 1, column_data);
+	next_column = GET_NEXT_COLUMN(next_column);
 	if (next_column == MATRIX_NUM_COLUMNS)
 	{
 		flags |= FLG_IS_NEW_CYCLE;
@@ -169,7 +95,8 @@ static void display_next_column(void)
 
 void setup_start_screen(void)
 {
-	ledmatrix_clear();
+	display_hide_player();
+	display_clear();
 	display_initial_image();
 	flags |= FLG_IS_NEW_CYCLE;
 }
@@ -212,7 +139,7 @@ void update_start_screen(void)
 			// matrix.
 			if ((flags ^= FLG_TOGGLE_ON) & FLG_TOGGLE_ON)
 			{
-				ledmatrix_clear();
+				display_clear();
 			}
 			else
 			{
@@ -231,46 +158,50 @@ void update_start_screen(void)
 	}
 }
 
-static bool display_title_pixel(uint8_t line, uint8_t col, bool coloured)
+// Progress through drawing the title, as the index of the next span.
+static uint8_t title_row;
+static uint8_t title_col;
+static uint8_t title_span;
+
+// Most bytes a span can take: 8 for the cursor movement, 5 for the colour
+// and 4 to reset it, plus one per cell.
+#define TITLE_SPAN_BYTES	(17 + TITLE_SPAN_CELLS)
+
+// Most spans drawn by each call to update_terminal_title().
+#define TITLE_SPANS_PER_UPDATE	(4)
+
+void display_terminal_title(uint8_t row, uint8_t col)
+{
+	title_row = row;
+	title_col = col;
+	title_span = 0;
+}
+
+bool update_terminal_title(void)
 {
-	uint64_t data;
-	memcpy_P(&data, &title_data[line], sizeof(data));
-	if (data & ((uint64_t)1U << (63 - col)))
-	{
-		if (!coloured)
-		{
-			for (uint8_t j = 0; j < countof(title_pos); j++)
-			{
-				if (col <= title_pos[j])
-				{
-					set_display_attribute(title_attr[j]);
-				}
-			}
-			coloured = true;
-		}
-	}
-	else
+	for (uint8_t spans = 0; spans < TITLE_SPANS_PER_UPDATE &&
+		title_span < TITLE_NUM_SPANS; spans++)
 	{
-		if (coloured)
+		// Wait rather than block if the span doesn't fit in the
+		// output buffer.
+		if (serial_output_space() < TITLE_SPAN_BYTES)
 		{
-			normal_display_mode();
-			coloured = false;
+			return false;
 		}
-		
-	}
-	putchar(' ');
-	return coloured;
-}
 
-void display_terminal_title(uint8_t row, uint8_t col)
-{
-	bool coloured = false;
-	for (uint8_t line = 0; line < countof(title_data); line++)
-	{
-		move_terminal_cursor(line + row, col);
-		for (uint8_t i = 0; i < 64; i++)
+		uint8_t line_length = pgm_read_byte(&title_spans[title_span][0]);
+		uint8_t col = pgm_read_byte(&title_spans[title_span][1]);
+		uint8_t attribute = pgm_read_byte(&title_spans[title_span][2]);
+		title_span++;
+
+		move_terminal_cursor(title_row + (line_length >> 4),
+			title_col + col);
+		set_display_attribute(attribute);
+		for (uint8_t i = (line_length & 0x0F) + 1; i > 0; i--)
 		{
-			coloured = display_title_pixel(line, i, coloured);
+			putchar(' ');
 		}
+		normal_display_mode();
 	}
+	return title_span >= TITLE_NUM_SPANS;
 }
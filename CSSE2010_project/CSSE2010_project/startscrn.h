@@ -13,6 +13,7 @@
 #define STARTSCRN_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 
 /// <summary>
 /// Sets up the start screen on the LED matrix. This function must be called
@@ -26,10 +27,20 @@ void setup_start_screen(void);
 void update_start_screen(void);
 
 /// <summary>
-/// Draws the terminal title ASCII art.
+/// Starts drawing the terminal title ASCII art. The art is drawn a few spans
+/// at a time by update_terminal_title(), so this function returns straight
+/// away. Only the coloured cells are drawn, so the area should be clear.
 /// </summary>
 /// <param name="row">The start row of the ASCII art.</param>
 /// <param name="col">The start column of the ASCII art.</param>
 void display_terminal_title(uint8_t row, uint8_t col);
 
+/// <summary>
+/// Draws the next few spans of the terminal title ASCII art, as long as they
+/// fit in the serial output buffer. Never blocks. Should be called regularly
+/// until it returns true.
+/// </summary>
+/// <returns>Whether the title has been drawn completely.</returns>
+bool update_terminal_title(void);
+
 #endif /* STARTSCRN_H_ */
@@ -0,0 +1,145 @@
+/*
+ * startscrn_assets.h
+ *
+ * Generated by tools/assetc from tools/assets/startscrn.txt. Do not edit.
+ */
+
+#ifndef STARTSCRN_ASSETS_H_
+#define STARTSCRN_ASSETS_H_
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "pixel_colour.h"
+#include "terminalio.h"
+
+// Spans of coloured title cells: (line << 4 | (length - 1)), column,
+// attribute.
+static const uint8_t title_spans[][3] PROGMEM =
+{
+	{ 0x06,  0, BG_MAGENTA },
+	{ 0x05,  9, BG_GREEN },
+	{ 0x01, 17, BG_BLUE },
+	{ 0x01, 22, BG_BLUE },
+	{ 0x05, 26, BG_YELLOW },
+	{ 0x05, 34, BG_RED },
+	{ 0x04, 43, BG_WHITE },
+	{ 0x02, 50, BG_CYAN },
+	{ 0x01, 57, BG_CYAN },
+	{ 0x11,  0, BG_MAGENTA },
+	{ 0x11,  8, BG_GREEN },
+	{ 0x11, 14, BG_GREEN },
+	{ 0x11, 17, BG_BLUE },
+	{ 0x11, 21, BG_BLUE },
+	{ 0x11, 25, BG_YELLOW },
+	{ 0x11, 31, BG_YELLOW },
+	{ 0x11, 34, BG_RED },
+	{ 0x11, 39, BG_RED },
+	{ 0x11, 42, BG_WHITE },
+	{ 0x11, 47, BG_WHITE },
+	{ 0x13, 50, BG_CYAN },
+	{ 0x11, 57, BG_CYAN },
+	{ 0x26,  0, BG_MAGENTA },
+	{ 0x21,  8, BG_GREEN },
+	{ 0x21, 14, BG_GREEN },
+	{ 0x24, 17, BG_BLUE },
+	{ 0x21, 25, BG_YELLOW },
+	{ 0x21, 31, BG_YELLOW },
+	{ 0x25, 34, BG_RED },
+	{ 0x26, 42, BG_WHITE },
+	{ 0x21, 50, BG_CYAN },
+	{ 0x21, 53, BG_CYAN },
+	{ 0x21, 57, BG_CYAN },
+	{ 0x31,  5, BG_MAGENTA },
+	{ 0x31,  8, BG_GREEN },
+	{ 0x31, 14, BG_GREEN },
+	{ 0x31, 17, BG_BLUE },
+	{ 0x31, 21, BG_BLUE },
+	{ 0x31, 25, BG_YELLOW },
+	{ 0x31, 31, BG_YELLOW },
+	{ 0x31, 34, BG_RED },
+	{ 0x31, 39, BG_RED },
+	{ 0x31, 42, BG_WHITE },
+	{ 0x31, 47, BG_WHITE },
+	{ 0x31, 50, BG_CYAN },
+	{ 0x31, 54, BG_CYAN },
+	{ 0x31, 57, BG_CYAN },
+	{ 0x46,  0, BG_MAGENTA },
+	{ 0x45,  9, BG_GREEN },
+	{ 0x41, 17, BG_BLUE },
+	{ 0x41, 22, BG_BLUE },
+	{ 0x45, 26, BG_YELLOW },
+	{ 0x45, 34, BG_RED },
+	{ 0x41, 42, BG_WHITE },
+	{ 0x41, 47, BG_WHITE },
+	{ 0x41, 50, BG_CYAN },
+	{ 0x43, 55, BG_CYAN },
+};
+
+#define TITLE_NUM_SPANS	(57)
+#define TITLE_SPAN_CELLS	(16)
+
+// Colours used by the start screen animation.
+static const PixelColour anim_palette[4] PROGMEM =
+{
+	COLOUR_BLACK, COLOUR_GREEN, COLOUR_ORANGE, COLOUR_DARK_GREEN
+};
+
+// Start screen animation columns (left to right), as 2 bit palette indices
+// with row 0 in the low bits of the first byte.
+static const uint8_t anim_columns[][2] PROGMEM =
+{
+	{ 0x45, 0x15 },
+	{ 0x41, 0x10 },
+	{ 0x41, 0x10 },
+	{ 0x55, 0x14 },
+	{ 0x00, 0x00 },
+	{ 0x55, 0x01 },
+	{ 0x01, 0x01 },
+	{ 0x01, 0x01 },
+	{ 0x55, 0x01 },
+	{ 0x00, 0x00 },
+	{ 0x55, 0x15 },
+	{ 0x40, 0x00 },
+	{ 0x10, 0x01 },
+	{ 0x05, 0x04 },
+	{ 0x00, 0x00 },
+	{ 0x55, 0x01 },
+	{ 0x01, 0x01 },
+	{ 0x01, 0x01 },
+	{ 0x55, 0x01 },
+	{ 0x00, 0x00 },
+	{ 0x55, 0x15 },
+	{ 0x41, 0x00 },
+	{ 0x41, 0x00 },
+	{ 0x55, 0x00 },
+	{ 0x00, 0x00 },
+	{ 0x15, 0x01 },
+	{ 0x11, 0x01 },
+	{ 0x11, 0x01 },
+	{ 0x55, 0x01 },
+	{ 0x00, 0x00 },
+	{ 0x55, 0x01 },
+	{ 0x00, 0x01 },
+	{ 0x00, 0x01 },
+	{ 0x55, 0x01 },
+	{ 0x00, 0x00 },
+	{ 0x00, 0x00 },
+	{ 0xAA, 0x0A },
+	{ 0x0A, 0x0A },
+	{ 0xA2, 0x08 },
+	{ 0xA2, 0x08 },
+	{ 0x0A, 0x0A },
+	{ 0xAA, 0x0A },
+	{ 0xC0, 0x0C },
+	{ 0xC3, 0x0C },
+	{ 0x0C, 0xF3 },
+	{ 0xF0, 0xFC },
+	{ 0x0C, 0xF0 },
+	{ 0x03, 0x00 },
+	{ 0x00, 0x00 },
+	{ 0x00, 0x00 },
+};
+
+#define ANIM_NUM_COLUMNS	(50)
+
+#endif /* STARTSCRN_ASSETS_H_ */
@@ -9,65 +9,76 @@
 #include <stdint.h>
 #include <string.h>
 #include <avr/pgmspace.h>
+#include "fastfmt.h"
+#include "serialio.h"
+
+// Escape sequences are built with fastfmt and written straight to the serial
+// port, since they are sent for nearly every character drawn.
 
 void move_terminal_cursor(int row, int col)
 {
-    printf_P(PSTR("\x1b[%d;%dH"), row + 1, col + 1);
+	char buffer[FMT_CURSOR_LENGTH];
+	serial_write_text(buffer, fmt_cursor(buffer, row, col));
 }
 
 void normal_display_mode(void)
 {
-	printf_P(PSTR("\x1b[0m"));
+	fmt_put_P(PSTR("\x1b[0m"));
 }
 
 void reverse_video(void)
 {
-	printf_P(PSTR("\x1b[7m"));
+	fmt_put_P(PSTR("\x1b[7m"));
 }
 
 void clear_terminal(void)
 {
-	printf_P(PSTR("\x1b[2J"));
+	fmt_put_P(PSTR("\x1b[2J"));
 }
 
 void clear_to_end_of_line(void)
 {
-	printf_P(PSTR("\x1b[K"));
+	fmt_put_P(PSTR("\x1b[K"));
 }
 
 void set_display_attribute(DisplayParameter parameter)
 {
-	printf_P(PSTR("\x1b[%dm"), parameter);
+	char buffer[FMT_ATTRIBUTE_LENGTH];
+	serial_write_text(buffer, fmt_attribute(buffer, parameter));
 }
 
 void hide_cursor(void)
 {
-	printf_P(PSTR("\x1b[?25l"));
+	fmt_put_P(PSTR("\x1b[?25l"));
 }
 
 void show_cursor(void)
 {
-	printf_P(PSTR("\x1b[?25h"));
+	fmt_put_P(PSTR("\x1b[?25h"));
 }
 
 void enable_scrolling_for_whole_display(void)
 {
-	printf_P(PSTR("\x1b[r"));
+	fmt_put_P(PSTR("\x1b[r"));
 }
 
 void set_scroll_region(int row1, int row2)
 {
-	printf_P(PSTR("\x1b[%d;%dr"), row1 + 1, row2 + 1);
+	// Same as a cursor move, with a different final character.
+	char buffer[FMT_CURSOR_LENGTH];
+	uint8_t length = fmt_cursor(buffer, row1, row2);
+	buffer[length - 1] = 'r';
+	serial_write_text(buffer, length);
 }
 
 void scroll_down(void)
 {
-	printf_P(PSTR("\x1bM")); // ESC-M
+	fmt_put_P(PSTR("\x1bM")); // ESC-M
 }
 
 void scroll_up(void)
 {
-	printf_P(PSTR("\x1b\x44")); // ESC-D
+	fmt_put_P(PSTR("\x1b\x44")); // ESC-D
 }
 
 void draw_horizontal_line(int row, int start_col, int end_col)
@@ -100,7 +111,7 @@ void draw_vertical_line(int col, int start_row, int end_row)
 		// Move down a row and step back to previous column (because
 		// printing the space caused the cursor to be advanced by one
 		// column).
-		printf_P(PSTR("\x1b[B\x1b[D"));
+		fmt_put_P(PSTR("\x1b[B\x1b[D"));
 	}
 	// Print the space for the end row, and do not move the cursor down.
 	putchar(' ');
@@ -2,21 +2,35 @@
  * timer0.c
  *
  * Author: Peter Sutton
+ * Modified by: Sithika Mannakkara
  */
 
 #include "timer0.h"
 #include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include "cpuload.h"
 
 // Our internal clock tick count - incremented every millisecond. Will
 // overflow every ~49 days.
 static volatile uint32_t clock_ticks_ms;
 
+// The timer wheel. Active timers are linked into the slot for the tick they
+// expire on. The number of slots must be a power of 2.
+#define WHEEL_SLOTS	(16)
+#define WHEEL_MASK	(WHEEL_SLOTS - 1)
+static SoftTimer *wheel[WHEEL_SLOTS];
+
 void init_timer0(void)
 {
 	// Reset clock tick count. L indicates a long (32 bit) constant.
 	clock_ticks_ms = 0L;
+	for (uint8_t i = 0; i < WHEEL_SLOTS; i++)
+	{
+		wheel[i] = NULL;
+	}
 
 	// Set up timer 0 to generate an interrupt every 1ms. We will divide
 	// the clock by 64 and count up to 124. We will therefore get an
@@ -59,9 +73,106 @@ uint32_t get_current_time(void)
 	return result;
 }
 
+// Links a timer into the wheel slot for its expiry time. Only called with
+// interrupts disabled.
+static void insert_timer(SoftTimer *timer)
+{
+	SoftTimer **slot = &wheel[timer->expires & WHEEL_MASK];
+	timer->next = *slot;
+	*slot = timer;
+}
+
+// Unlinks a timer from the wheel, if it is in it. Only called with
+// interrupts disabled.
+static void remove_timer(SoftTimer *timer)
+{
+	SoftTimer **link = &wheel[timer->expires & WHEEL_MASK];
+	while (*link != NULL)
+	{
+		if (*link == timer)
+		{
+			*link = timer->next;
+			return;
+		}
+		link = &(*link)->next;
+	}
+}
+
+void soft_timer_start(SoftTimer *timer, uint16_t delay, uint16_t period,
+	SoftTimerCallback callback)
+{
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	if (timer->active)
+	{
+		remove_timer(timer);
+	}
+	timer->callback = callback;
+	timer->period = period;
+	timer->expires = clock_ticks_ms + (delay ? delay : 1);
+	timer->active = true;
+	insert_timer(timer);
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+}
+
+void soft_timer_stop(SoftTimer *timer)
+{
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	if (timer->active)
+	{
+		remove_timer(timer);
+		timer->active = false;
+	}
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+}
+
 // Interrupt handler for clock tick.
 ISR(TIMER0_COMPA_vect)
 {
+	uint16_t start = cpuload_isr_enter();
+
 	// Increment our clock tick count.
-	clock_ticks_ms++;
+	uint32_t now = ++clock_ticks_ms;
+
+	// Run the timers that expire now. Other timers in the slot expire on
+	// a later turn of the wheel. The slot is searched again from the start
+	// after each callback, since the callback may start or stop timers.
+	SoftTimer **slot = &wheel[now & WHEEL_MASK];
+	while (1)
+	{
+		SoftTimer **link = slot;
+		while (*link != NULL && (*link)->expires != now)
+		{
+			link = &(*link)->next;
+		}
+		SoftTimer *timer = *link;
+		if (timer == NULL)
+		{
+			break;
+		}
+
+		// Take the timer off the wheel, and put periodic timers back
+		// on for their next run before the callback (so that the
+		// callback can stop it).
+		*link = timer->next;
+		if (timer->period)
+		{
+			timer->expires = now + timer->period;
+			insert_timer(timer);
+		}
+		else
+		{
+			timer->active = false;
+		}
+		timer->callback();
+	}
+
+	cpuload_isr_exit(start);
 }
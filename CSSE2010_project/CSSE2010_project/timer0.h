@@ -2,26 +2,49 @@
  * timer0.h
  *
  * Author: Peter Sutton
+ * Modified by: Sithika Mannakkara
  *
  * Module for the system clock, and function(s) for getting the current time.
- * Timer 0 is setup to generate an interrupt every millisecond. Tasks that
- * have to occur regularly (every millisecond or few) can be added to the
- * interrupt handler (in timer0.c) or can be added to the main event loop that
- * checks the clock tick value. Any tasks undertaken in the interrupt handler
- * should be kept short so that we don't run the risk of missing an interrupt
- * in future.
+ * Timer 0 is setup to generate an interrupt every millisecond. This is the
+ * only hardware timer used: everything else that has to happen regularly
+ * (counting seconds, refreshing the seven segment display, scheduling LED
+ * matrix frames, debouncing buttons) registers a software timer, which is
+ * run from the interrupt handler at the right tick. All of them therefore
+ * share one timebase and can never drift apart.
+ *
+ * Software timers are kept in a timer wheel: a timer is linked into the slot
+ * for the tick it expires on (modulo the number of slots), so each tick only
+ * looks at the timers in one slot. Timer callbacks are run from the
+ * interrupt handler and should be kept short so that we don't run the risk
+ * of missing an interrupt in future.
  */
 
 #ifndef TIMER0_H_
 #define TIMER0_H_
 
 #include <stdint.h>
+#include <stdbool.h>
+
+// Function called when a software timer expires.
+typedef void (*SoftTimerCallback)(void);
+
+// A software timer. The timer is owned by the caller and must stay in
+// existence while it is active. Its fields are managed by the functions
+// below.
+typedef struct SoftTimer
+{
+	SoftTimerCallback callback;
+	uint32_t expires;
+	uint16_t period;
+	bool active;
+	struct SoftTimer *next;
+} SoftTimer;
 
 /// <summary>
 /// Initialises timer 0 for system clock. An interrupt will be generated
-/// every millisecond to update the time reference. This function must be
-/// called before any of the other timer 0 functions can be used. This
-/// function should only be called once.
+/// every millisecond to update the time reference and run software timers.
+/// This function must be called before any of the other timer 0 functions
+/// can be used. This function should only be called once.
 /// </summary>
 void init_timer0(void);
 
@@ -31,4 +54,23 @@ void init_timer0(void);
 /// <returns>Milliseconds since timer 0 was initialised.</returns>
 uint32_t get_current_time(void);
 
+/// <summary>
+/// Starts (or restarts) a software timer. The callback is run from the timer
+/// 0 interrupt handler, with interrupts disabled.
+/// </summary>
+/// <param name="timer">The timer.</param>
+/// <param name="delay">Milliseconds until the callback is first run (at
+/// least 1).</param>
+/// <param name="period">Milliseconds between subsequent runs, or 0 to run
+/// the callback only once.</param>
+/// <param name="callback">The function to run.</param>
+void soft_timer_start(SoftTimer *timer, uint16_t delay, uint16_t period,
+	SoftTimerCallback callback);
+
+/// <summary>
+/// Stops a software timer. Does nothing if the timer isn't active.
+/// </summary>
+/// <param name="timer">The timer.</param>
+void soft_timer_stop(SoftTimer *timer);
+
 #endif /* TIMER0_H_ */
@@ -1,19 +0,0 @@
-/*
- * timer2.h
- *
- * Author: Peter Sutton
- *
- * Timer 2 skeleton
- */
-
-#ifndef TIMER2_H_
-#define TIMER2_H_
-
-/// <summary>
-/// Skeletal timer 2 initialisation function.
-/// </summary>
-void init_timer2(void);
-
-void increment_digit_SSD(void);
-
-#endif /* TIMER2_H_ */
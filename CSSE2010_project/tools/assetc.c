@@ -0,0 +1,322 @@
+/*
+ * assetc.c
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Asset compiler for the start screen. Reads the title art and LED matrix
+ * animation from a text file (see assets/startscrn.txt) and writes a header
+ * for startscrn.c with
+ *  - the title as a list of spans of coloured cells, with the terminal
+ *    attribute of each span already resolved, and
+ *  - the animation packed 2 bits per pixel against a palette of up to 4
+ *    colours.
+ * A summary of the flash used and the estimated title decode time, before
+ * and after, is printed on stderr.
+ *
+ * Usage: assetc INPUT.txt OUTPUT.h
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+
+#define MAX_TITLE_LINES		(16)
+#define TITLE_WIDTH		(64)
+#define MAX_TITLE_COLOURS	(16)
+#define MAX_PALETTE		(4)
+#define MATRIX_ROWS		(8)
+#define MAX_ANIM_COLUMNS	(255)
+
+// Longest span emitted. The firmware sends each span in one go, so this
+// bounds the number of bytes it needs free in the serial output buffer.
+#define MAX_SPAN_CELLS	(16)
+
+// Rough AVR cycle costs used to estimate how long decoding the title takes,
+// not counting the terminal output (which is the same either way).
+#define CYCLES_CELL_LOAD	(60)	// memcpy_P() of the line's uint64_t
+#define CYCLES_CELL_TEST	(250)	// variable shift and test of a uint64_t
+#define CYCLES_COLOUR_TEST	(12)	// one title_pos comparison
+#define CYCLES_SPAN_LOAD	(20)	// pgm_read_byte() of a packed span
+
+typedef struct
+{
+	int column;
+	char attribute[32];
+} TitleColour;
+
+typedef struct
+{
+	char symbol;
+	char colour[32];
+} PaletteEntry;
+
+static char title[MAX_TITLE_LINES][TITLE_WIDTH + 1];
+static int num_title_lines;
+static TitleColour title_colours[MAX_TITLE_COLOURS];
+static int num_title_colours;
+static PaletteEntry palette[MAX_PALETTE];
+static int num_palette;
+static char animation[MATRIX_ROWS][MAX_ANIM_COLUMNS + 1];
+static int num_anim_rows;
+
+static void fail(const char *path, int line, const char *message)
+{
+	fprintf(stderr, "%s:%d: %s\n", path, line, message);
+	exit(1);
+}
+
+static void read_assets(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	if (file == NULL)
+	{
+		perror(path);
+		exit(1);
+	}
+
+	char buffer[512];
+	char section[32] = "";
+	int line = 0;
+	while (fgets(buffer, sizeof(buffer), file))
+	{
+		line++;
+		buffer[strcspn(buffer, "\r\n")] = '\0';
+		if (buffer[0] == '#' && strcmp(section, "title") != 0)
+		{
+			continue;
+		}
+		if (buffer[0] == '\0')
+		{
+			continue;
+		}
+		if (buffer[0] == '[')
+		{
+			if (sscanf(buffer, "[%31[^]]]", section) != 1)
+			{
+				fail(path, line, "bad section header");
+			}
+			continue;
+		}
+
+		if (strcmp(section, "title") == 0)
+		{
+			if (num_title_lines == MAX_TITLE_LINES ||
+				strlen(buffer) > TITLE_WIDTH)
+			{
+				fail(path, line, "title too large");
+			}
+			snprintf(title[num_title_lines++], TITLE_WIDTH + 1, "%s",
+				buffer);
+		}
+		else if (strcmp(section, "title-colours") == 0)
+		{
+			TitleColour *colour = &title_colours[num_title_colours];
+			if (num_title_colours == MAX_TITLE_COLOURS ||
+				sscanf(buffer, "%d %31s", &colour->column,
+				colour->attribute) != 2)
+			{
+				fail(path, line, "bad title colour");
+			}
+			num_title_colours++;
+		}
+		else if (strcmp(section, "animation-palette") == 0)
+		{
+			PaletteEntry *entry = &palette[num_palette];
+			if (num_palette == MAX_PALETTE ||
+				sscanf(buffer, " %c %31s", &entry->symbol,
+				entry->colour) != 2)
+			{
+				fail(path, line, "bad palette entry (at most 4)");
+			}
+			num_palette++;
+		}
+		else if (strcmp(section, "animation") == 0)
+		{
+			if (num_anim_rows == MATRIX_ROWS ||
+				strlen(buffer) > MAX_ANIM_COLUMNS)
+			{
+				fail(path, line, "animation too large");
+			}
+			snprintf(animation[num_anim_rows++], MAX_ANIM_COLUMNS + 1,
+				"%s", buffer);
+		}
+		else
+		{
+			fail(path, line, "data outside a known section");
+		}
+	}
+	fclose(file);
+
+	if (num_anim_rows != MATRIX_ROWS)
+	{
+		fail(path, line, "animation must have 8 rows");
+	}
+	for (int row = 1; row < MATRIX_ROWS; row++)
+	{
+		if (strlen(animation[row]) != strlen(animation[0]))
+		{
+			fail(path, line, "animation rows differ in length");
+		}
+	}
+	if (strlen(animation[0]) < 16)
+	{
+		fail(path, line, "animation must have at least 16 columns");
+	}
+}
+
+static bool title_cell(int line, int col)
+{
+	return col < (int)strlen(title[line]) && title[line][col] == '#';
+}
+
+// Finds the attribute of a run of cells starting at the given column.
+static const char *run_attribute(int col)
+{
+	const TitleColour *best = NULL;
+	for (int i = 0; i < num_title_colours; i++)
+	{
+		if (col <= title_colours[i].column &&
+			(best == NULL || title_colours[i].column < best->column))
+		{
+			best = &title_colours[i];
+		}
+	}
+	return best ? best->attribute : "TERM_RESET";
+}
+
+static int palette_index(char symbol)
+{
+	for (int i = 0; i < num_palette; i++)
+	{
+		if (palette[i].symbol == symbol)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc != 3)
+	{
+		fprintf(stderr, "usage: assetc INPUT.txt OUTPUT.h\n");
+		return 2;
+	}
+	read_assets(argv[1]);
+
+	FILE *out = fopen(argv[2], "w");
+	if (out == NULL)
+	{
+		perror(argv[2]);
+		return 1;
+	}
+
+	fprintf(out, "/*\n * startscrn_assets.h\n *\n"
+		" * Generated by tools/assetc from tools/assets/startscrn.txt."
+		" Do not edit.\n */\n\n"
+		"#ifndef STARTSCRN_ASSETS_H_\n#define STARTSCRN_ASSETS_H_\n\n"
+		"#include <stdint.h>\n#include <avr/pgmspace.h>\n"
+		"#include \"pixel_colour.h\"\n#include \"terminalio.h\"\n\n");
+
+	// Title spans. Each span is packed into 3 bytes: the line in the top 4
+	// bits and the length - 1 in the bottom 4 bits, then the column and the
+	// attribute.
+	int num_spans = 0;
+	int runs = 0;
+	fprintf(out, "// Spans of coloured title cells: (line << 4 | (length - 1)),"
+		" column,\n// attribute.\n"
+		"static const uint8_t title_spans[][3] PROGMEM =\n{\n");
+	for (int line = 0; line < num_title_lines; line++)
+	{
+		for (int col = 0; col < TITLE_WIDTH; col++)
+		{
+			if (!title_cell(line, col))
+			{
+				continue;
+			}
+			const char *attribute = run_attribute(col);
+			runs++;
+			while (col < TITLE_WIDTH && title_cell(line, col))
+			{
+				int length = 0;
+				while (col + length < TITLE_WIDTH &&
+					length < MAX_SPAN_CELLS &&
+					title_cell(line, col + length))
+				{
+					length++;
+				}
+				fprintf(out, "\t{ 0x%02X, %2d, %s },\n",
+					line << 4 | (length - 1), col, attribute);
+				num_spans++;
+				col += length;
+			}
+		}
+	}
+	fprintf(out, "};\n\n#define TITLE_NUM_SPANS\t(%d)\n"
+		"#define TITLE_SPAN_CELLS\t(%d)\n\n", num_spans, MAX_SPAN_CELLS);
+
+	// Animation, 2 bits per pixel with row 0 (the bottom row) in the
+	// lowest bits of the first byte.
+	int num_columns = strlen(animation[0]);
+	fprintf(out, "// Colours used by the start screen animation.\n"
+		"static const PixelColour anim_palette[4] PROGMEM =\n{\n\t");
+	for (int i = 0; i < MAX_PALETTE; i++)
+	{
+		fprintf(out, "%s%s", i < num_palette ? palette[i].colour :
+			"COLOUR_BLACK", i < MAX_PALETTE - 1 ? ", " : "\n};\n\n");
+	}
+	fprintf(out, "// Start screen animation columns (left to right), as "
+		"2 bit palette indices\n// with row 0 in the low bits of the "
+		"first byte.\n"
+		"static const uint8_t anim_columns[][2] PROGMEM =\n{\n");
+	for (int col = 0; col < num_columns; col++)
+	{
+		uint16_t packed = 0;
+		for (int row = 0; row < MATRIX_ROWS; row++)
+		{
+			// The text has the top row first.
+			char symbol = animation[MATRIX_ROWS - 1 - row][col];
+			int index = palette_index(symbol);
+			if (index < 0)
+			{
+				fprintf(stderr, "%s: '%c' is not in the palette\n",
+					argv[1], symbol);
+				return 1;
+			}
+			packed |= index << (2 * row);
+		}
+		fprintf(out, "\t{ 0x%02X, 0x%02X },\n", packed & 0xFF,
+			packed >> 8);
+	}
+	fprintf(out, "};\n\n#define ANIM_NUM_COLUMNS\t(%d)\n\n"
+		"#endif /* STARTSCRN_ASSETS_H_ */\n", num_columns);
+	fclose(out);
+
+	// Sizes of the old tables: a uint64_t per title line in flash, the
+	// colour positions (uint8_t) and attributes (an int sized enum) as
+	// initialised data (in both flash and RAM), and a byte per animation
+	// pixel in flash.
+	int old_title = num_title_lines * 8 + num_title_colours * 3;
+	int old_anim = num_columns * MATRIX_ROWS;
+	int new_title = num_spans * 3;
+	int new_anim = num_columns * 2 + MAX_PALETTE;
+	fprintf(stderr, "title: %d spans, %d -> %d bytes of flash "
+		"(%d bytes of RAM freed)\n", num_spans, old_title, new_title,
+		num_title_colours * 3);
+	fprintf(stderr, "animation: %d columns, %d -> %d bytes of flash\n",
+		num_columns, old_anim, new_anim);
+	fprintf(stderr, "total flash saved: %d bytes\n",
+		old_title + old_anim - new_title - new_anim);
+
+	long old_cycles = (long)num_title_lines * TITLE_WIDTH *
+		(CYCLES_CELL_LOAD + CYCLES_CELL_TEST) +
+		(long)runs * num_title_colours * CYCLES_COLOUR_TEST;
+	long new_cycles = (long)num_spans * CYCLES_SPAN_LOAD;
+	fprintf(stderr, "title decode (estimated, excluding output): "
+		"%ld -> %ld cycles per draw\n", old_cycles, new_cycles);
+	return 0;
+}
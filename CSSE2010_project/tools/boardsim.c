@@ -0,0 +1,335 @@
+/*
+ * boardsim.c
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Host build of the board for the bot client. Runs the firmware's game.c and
+ * remote.c (the binary remote protocol) on the master side of a pseudo
+ * terminal and prints the path of the slave side, which botclient opens like
+ * the device's serial port. Moves go through the same frame handling and
+ * move_player() as on the device, but nothing is drawn and there is no UART,
+ * so botclient's figures against boardsim are the host's protocol and engine
+ * cost alone.
+ *
+ * Only the remote protocol is served: until the sync byte arrives, input is
+ * ignored. There is no CPU load or SRAM monitor on the host, so those
+ * commands are answered like unknown ones.
+ *
+ * Usage: boardsim [-l LEVEL]
+ *   -l LEVEL   level to play, 1-based (default 1)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <termios.h>
+#include <unistd.h>
+#include "game.h"
+#include "render.h"
+#include "remote.h"
+#include "serialio.h"
+
+// The pseudo terminal master, standing in for the UART.
+static int master_fd;
+static uint8_t rx_buffer[256];
+static size_t rx_head;
+static size_t rx_length;
+
+static uint8_t level;
+static uint16_t num_valid_moves;
+static double level_start;
+static uint16_t elapsed_time;
+
+static double now_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// The serial port functions remote.c uses, on the pseudo terminal.
+void serial_set_binary_mode(bool binary)
+{
+	// Nothing is written through standard I/O, so there is nothing to
+	// suppress.
+	(void)binary;
+}
+
+int serial_read_raw(void)
+{
+	if (rx_head == rx_length)
+	{
+		struct pollfd input = { master_fd, POLLIN, 0 };
+		if (poll(&input, 1, 0) <= 0)
+		{
+			return -1;
+		}
+		ssize_t count = read(master_fd, rx_buffer, sizeof(rx_buffer));
+		if (count <= 0)
+		{
+			return -1;
+		}
+		rx_head = 0;
+		rx_length = count;
+	}
+	return rx_buffer[rx_head++];
+}
+
+void serial_write_raw(const uint8_t *data, uint8_t length)
+{
+	while (length > 0)
+	{
+		ssize_t count = write(master_fd, data, length);
+		if (count < 0)
+		{
+			perror("write");
+			exit(1);
+		}
+		data += count;
+		length -= count;
+	}
+}
+
+static void update_elapsed_time(void)
+{
+	double elapsed = now_seconds() - level_start;
+	elapsed_time = elapsed < UINT16_MAX ? elapsed : UINT16_MAX;
+}
+
+// Seconds since the level started, stopped once it is complete (as the
+// device's game timer is).
+static uint16_t get_elapsed_time(void)
+{
+	if (!is_game_over())
+	{
+		update_elapsed_time();
+	}
+	return elapsed_time;
+}
+
+static void new_game(void)
+{
+	initialise_game(level);
+	num_valid_moves = 0;
+	level_start = now_seconds();
+	elapsed_time = 0;
+}
+
+// Same score as the device (see get_score() in project.c).
+static uint16_t get_score(void)
+{
+	uint16_t time_score = 0;
+	uint16_t move_score = 0;
+	if (elapsed_time < 1200)
+	{
+		time_score = 1200 - elapsed_time;
+	}
+	if (num_valid_moves < 200)
+	{
+		move_score = 200 - num_valid_moves;
+	}
+	return move_score + time_score;
+}
+
+// Makes a move as the device does for the same key. Returns whether the
+// move was valid.
+static bool make_move(char key)
+{
+	bool valid_move = false;
+	switch (toupper(key))
+	{
+		case 'W':
+			valid_move = move_player(1, 0);
+			break;
+		case 'A':
+			valid_move = move_player(0, -1);
+			break;
+		case 'S':
+			valid_move = move_player(-1, 0);
+			break;
+		case 'D':
+			valid_move = move_player(0, 1);
+			break;
+	}
+	if (valid_move)
+	{
+		num_valid_moves++;
+		if (is_game_over())
+		{
+			update_elapsed_time();
+		}
+	}
+	return valid_move;
+}
+
+static void send_state(void)
+{
+	RemoteState state;
+	get_board_state(&state.board);
+	state.moves = num_valid_moves;
+	state.elapsed_time = get_elapsed_time();
+	state.game_over = is_game_over();
+	remote_send(REMOTE_EVT_STATE, &state, sizeof(state));
+}
+
+static void send_game_over(void)
+{
+	RemoteGameOver game_over;
+	game_over.level = level;
+	game_over.score = get_score();
+	game_over.moves = num_valid_moves;
+	game_over.elapsed_time = elapsed_time;
+	remote_send(REMOTE_EVT_GAME_OVER, &game_over, sizeof(game_over));
+}
+
+// Handles a frame as handle_remote_frame() in project.c does.
+static void handle_frame(const RemoteFrame *frame)
+{
+	switch (frame->type)
+	{
+		case REMOTE_CMD_PING:
+		{
+			uint8_t version = REMOTE_VERSION;
+			remote_send(REMOTE_EVT_PONG, &version, sizeof(version));
+			break;
+		}
+		case REMOTE_CMD_MOVE:
+		case REMOTE_CMD_MOVES:
+		{
+			bool was_complete = is_game_over();
+			RemoteMoveResult result;
+			result.applied = 0;
+			result.valid = 0;
+			for (uint8_t i = 0; i < frame->length && !is_game_over();
+				i++)
+			{
+				result.applied++;
+				if (make_move(frame->payload[i]))
+				{
+					result.valid++;
+				}
+			}
+			result.moves = num_valid_moves;
+			result.elapsed_time = get_elapsed_time();
+			result.game_over = is_game_over();
+			remote_send(REMOTE_EVT_MOVED, &result, sizeof(result));
+
+			// The device announces the end of the level from its game
+			// over screen, after the reply to the final moves.
+			if (!was_complete && result.game_over)
+			{
+				send_game_over();
+			}
+			break;
+		}
+		case REMOTE_CMD_QUERY:
+			send_state();
+			break;
+		case REMOTE_CMD_RESTART:
+			new_game();
+			send_state();
+			break;
+		case REMOTE_CMD_EXIT:
+			remote_end();
+			break;
+		default:
+		{
+			uint8_t error = REMOTE_ERR_COMMAND;
+			remote_send(REMOTE_EVT_ERROR, &error, sizeof(error));
+			break;
+		}
+	}
+}
+
+// Opens the pseudo terminal and prints the path of its slave side. The
+// slave is kept open so that the master doesn't see a hang up each time a
+// client closes it.
+static bool open_terminal(void)
+{
+	master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+	if (master_fd < 0 || grantpt(master_fd) < 0 ||
+		unlockpt(master_fd) < 0)
+	{
+		perror("posix_openpt");
+		return false;
+	}
+	const char *path = ptsname(master_fd);
+	int slave_fd = path != NULL ? open(path, O_RDWR | O_NOCTTY) : -1;
+	struct termios tio;
+	if (slave_fd < 0 || tcgetattr(slave_fd, &tio) < 0)
+	{
+		perror("ptsname");
+		return false;
+	}
+	cfmakeraw(&tio);
+	if (tcsetattr(slave_fd, TCSANOW, &tio) < 0)
+	{
+		perror("tcsetattr");
+		return false;
+	}
+	printf("%s\n", path);
+	fflush(stdout);
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	int level_number = 1;
+	int opt;
+	while ((opt = getopt(argc, argv, "l:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'l':
+				level_number = atoi(optarg);
+				break;
+			default:
+				level_number = 0;
+				break;
+		}
+	}
+	if (optind != argc || level_number < 1 ||
+		level_number > get_num_levels())
+	{
+		fprintf(stderr, "usage: boardsim [-l LEVEL]\n");
+		return 2;
+	}
+	if (!open_terminal())
+	{
+		return 1;
+	}
+
+	render_register(&render_null);
+	level = level_number - 1;
+	new_game();
+
+	struct pollfd input = { master_fd, POLLIN, 0 };
+	while (true)
+	{
+		// Wait for input, unless some has already been read.
+		if (rx_head == rx_length && poll(&input, 1, -1) < 0)
+		{
+			perror("poll");
+			return 1;
+		}
+		if (remote_active())
+		{
+			const RemoteFrame *frame = remote_receive();
+			if (frame != NULL)
+			{
+				handle_frame(frame);
+			}
+		}
+		else if (serial_read_raw() == REMOTE_SYNC)
+		{
+			// A host has switched into binary mode.
+			remote_begin();
+		}
+	}
+}
@@ -0,0 +1,413 @@
+/*
+ * botclient.c
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Host bot which drives the game over the binary remote protocol and
+ * measures the sustained move rate of the whole input -> move_player ->
+ * render -> UART pipeline. The bot reads the board from the device, solves
+ * it with the host solver and streams the solution in batched move frames,
+ * keeping a number of frames in flight. The level is restarted and replayed
+ * as many times as requested.
+ *
+ * Usage: botclient [options] DEVICE
+ *        botclient -s LEVEL.xsb
+ *   -b BAUD    baud rate (default 250000)
+ *   -m MOVES   moves per frame, 1 - 32 (default 32)
+ *   -w FRAMES  frames in flight (default 1)
+ *   -n RUNS    number of times to solve the level (default 1)
+ *   -t MS      reply timeout in milliseconds (default 2000)
+ *   -k         keep the device in binary mode when done
+ *   -s FILE    just solve an XSB level file and print the solution
+ *
+ * DEVICE may be a real serial port or a pseudo terminal, such as the one
+ * boardsim (the host build of the board) prints. make bench-bot runs the two
+ * together.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include "sokoban.h"
+#include "solver.h"
+#include "protocol.h"
+
+typedef struct
+{
+	unsigned baud;
+	int batch;
+	int window;
+	int runs;
+	int timeout_ms;
+	bool keep_binary;
+} Options;
+
+static double now_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+// Waits for a frame of the given type, skipping any others (e.g., game over
+// events). Returns false on timeout or if the device reports an error.
+static bool expect_frame(int fd, uint8_t type, Frame *frame,
+	const Options *options, LinkStats *stats)
+{
+	while (frame_receive(fd, frame, options->timeout_ms, stats))
+	{
+		if (frame->type == type)
+		{
+			return true;
+		}
+		if (frame->type == REMOTE_EVT_ERROR)
+		{
+			fprintf(stderr, "device reported error %d\n",
+				frame->length ? frame->payload[0] : -1);
+			return false;
+		}
+	}
+	fprintf(stderr, "timed out waiting for frame 0x%02X\n", type);
+	return false;
+}
+
+// Waits for the board state and decodes it.
+static bool expect_state(int fd, BoardSnapshot *snapshot,
+	const Options *options, LinkStats *stats)
+{
+	Frame frame;
+	if (!expect_frame(fd, REMOTE_EVT_STATE, &frame, options, stats))
+	{
+		return false;
+	}
+	if (!decode_state(&frame, snapshot))
+	{
+		fprintf(stderr, "malformed board state from the device\n");
+		return false;
+	}
+	return true;
+}
+
+static bool query_state(int fd, BoardSnapshot *snapshot,
+	const Options *options, LinkStats *stats)
+{
+	return frame_send(fd, REMOTE_CMD_QUERY, NULL, 0, stats) &&
+		expect_state(fd, snapshot, options, stats);
+}
+
+// Streams the solution, keeping up to options->window frames in flight.
+// Round trip times of each frame are appended to rtts. Returns the number of
+// moves the device accepted, or -1 on error.
+static long stream_solution(int fd, const char *solution,
+	const Options *options, LinkStats *stats, double *rtts,
+	size_t *num_rtts)
+{
+	size_t length = strlen(solution);
+	size_t sent = 0;
+	long valid = 0;
+	double send_times[64];
+	int in_flight = 0;
+	int oldest = 0;
+	bool game_over = false;
+
+	while (!game_over && (sent < length || in_flight > 0))
+	{
+		while (sent < length && in_flight < options->window)
+		{
+			size_t count = length - sent;
+			if (count > (size_t)options->batch)
+			{
+				count = options->batch;
+			}
+			uint8_t type = count == 1 ? REMOTE_CMD_MOVE :
+				REMOTE_CMD_MOVES;
+			send_times[(oldest + in_flight) % 64] = now_seconds();
+			if (!frame_send(fd, type, solution + sent, count, stats))
+			{
+				perror("write");
+				return -1;
+			}
+			sent += count;
+			in_flight++;
+		}
+
+		Frame frame;
+		MoveResult result;
+		if (!expect_frame(fd, REMOTE_EVT_MOVED, &frame, options, stats) ||
+			!decode_move_result(&frame, &result))
+		{
+			return -1;
+		}
+		rtts[(*num_rtts)++] = now_seconds() - send_times[oldest];
+		oldest = (oldest + 1) % 64;
+		in_flight--;
+		valid += result.valid;
+		if (result.valid != result.applied)
+		{
+			fprintf(stderr, "device rejected %d of %d moves\n",
+				result.applied - result.valid, result.applied);
+			return -1;
+		}
+		game_over = result.game_over;
+	}
+
+	// Drain replies to frames sent after the level was completed.
+	while (in_flight-- > 0)
+	{
+		Frame frame;
+		if (!expect_frame(fd, REMOTE_EVT_MOVED, &frame, options, stats))
+		{
+			return -1;
+		}
+	}
+	return game_over ? valid : -1;
+}
+
+static int solve_file(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	if (file == NULL)
+	{
+		perror(path);
+		return 1;
+	}
+	Level level;
+	const char *error;
+	bool ok = level_read_xsb(file, &level, &error);
+	fclose(file);
+	if (!ok || (error = level_validate(&level)) != NULL)
+	{
+		fprintf(stderr, "%s: %s\n", path, error);
+		return 1;
+	}
+
+	char *solution;
+	SolverStats stats;
+	int moves = solve_level(&level, NULL, &solution, &stats);
+	if (moves < 0)
+	{
+		fprintf(stderr, "%s: no solution found\n", path);
+		return 1;
+	}
+	printf("%s\n", solution);
+	fprintf(stderr, "%d moves, %llu nodes expanded in %.3f s\n", moves,
+		(unsigned long long)stats.nodes_expanded, stats.seconds);
+	free(solution);
+	return 0;
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: botclient [-b baud] [-m moves] [-w frames] "
+		"[-n runs] [-t ms] [-k] DEVICE\n"
+		"       botclient -s LEVEL.xsb\n");
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	Options options = { 250000, REMOTE_MAX_PAYLOAD, 1, 1, 2000, false };
+	int opt;
+	while ((opt = getopt(argc, argv, "b:m:w:n:t:ks:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'b':
+				options.baud = strtoul(optarg, NULL, 10);
+				break;
+			case 'm':
+				options.batch = atoi(optarg);
+				break;
+			case 'w':
+				options.window = atoi(optarg);
+				break;
+			case 'n':
+				options.runs = atoi(optarg);
+				break;
+			case 't':
+				options.timeout_ms = atoi(optarg);
+				break;
+			case 'k':
+				options.keep_binary = true;
+				break;
+			case 's':
+				return solve_file(optarg);
+			default:
+				usage();
+		}
+	}
+	if (optind != argc - 1 || options.batch < 1 ||
+		options.batch > REMOTE_MAX_PAYLOAD || options.window < 1 ||
+		options.window > 64 || options.runs < 1)
+	{
+		usage();
+	}
+
+	int fd = serial_open(argv[optind], options.baud);
+	if (fd < 0)
+	{
+		perror(argv[optind]);
+		return 1;
+	}
+
+	// The first sync byte switches the device into binary mode (and
+	// starts the game if it is on the start screen).
+	LinkStats stats = { 0 };
+	Frame frame;
+	if (!frame_send(fd, REMOTE_CMD_PING, NULL, 0, &stats) ||
+		!expect_frame(fd, REMOTE_EVT_PONG, &frame, &options, &stats))
+	{
+		return 1;
+	}
+	printf("connected, protocol version %d\n",
+		frame.length ? frame.payload[0] : 0);
+
+	char *solution = NULL;
+	Level solved_level;
+	double *rtts = NULL;
+	size_t num_rtts = 0;
+	size_t rtt_capacity = 0;
+	long total_moves = 0;
+	double streaming_time = 0;
+	LinkStats stream_stats = { 0 };
+
+	for (int run = 0; run < options.runs; run++)
+	{
+		BoardSnapshot snapshot;
+		if (!query_state(fd, &snapshot, &options, &stats))
+		{
+			return 1;
+		}
+		if (snapshot.game_over || snapshot.moves > 0)
+		{
+			// Start from the beginning of the level.
+			if (!frame_send(fd, REMOTE_CMD_RESTART, NULL, 0, &stats) ||
+				!expect_state(fd, &snapshot, &options, &stats))
+			{
+				return 1;
+			}
+		}
+		if (!snapshot.fits)
+		{
+			fprintf(stderr, "level %d is too large for the host solver "
+				"(%dx%d, at most %dx%d)\n", snapshot.level_number + 1,
+				snapshot.rows, snapshot.cols, SOKO_MAX_ROWS,
+				SOKO_MAX_COLS);
+			return 1;
+		}
+
+		// Solve the level, unless it is the same as last time.
+		if (solution == NULL || memcmp(&solved_level, &snapshot.level,
+			sizeof(solved_level)) != 0)
+		{
+			SolverStats solver_stats;
+			free(solution);
+			int moves = solve_level(&snapshot.level, NULL, &solution,
+				&solver_stats);
+			if (moves < 0)
+			{
+				fprintf(stderr, "level %d: no solution found\n",
+					snapshot.level_number + 1);
+				return 1;
+			}
+			printf("level %d: solved in %d moves (%.3f s, %llu nodes)\n",
+				snapshot.level_number + 1, moves,
+				solver_stats.seconds,
+				(unsigned long long)solver_stats.nodes_expanded);
+			solved_level = snapshot.level;
+		}
+
+		size_t frames = (strlen(solution) + options.batch - 1) /
+			options.batch;
+		if (num_rtts + frames > rtt_capacity)
+		{
+			rtt_capacity = (num_rtts + frames) * 2;
+			rtts = realloc(rtts, rtt_capacity * sizeof(*rtts));
+		}
+
+		LinkStats before = stats;
+		double start = now_seconds();
+		long moves = stream_solution(fd, solution, &options, &stats, rtts,
+			&num_rtts);
+		if (moves < 0)
+		{
+			return 1;
+		}
+		streaming_time += now_seconds() - start;
+		total_moves += moves;
+		stream_stats.bytes_sent += stats.bytes_sent - before.bytes_sent;
+		stream_stats.bytes_received += stats.bytes_received -
+			before.bytes_received;
+	}
+
+	// The device's CPU load over the last second of streaming. The
+	// payload is a percentage each for idle, game, render and ISRs.
+	if (frame_send(fd, REMOTE_CMD_LOAD, NULL, 0, &stats) &&
+		expect_frame(fd, REMOTE_EVT_LOAD, &frame, &options, &stats) &&
+		frame.length >= 4)
+	{
+		printf("device CPU: game %d%%  render %d%%  isr %d%%  "
+			"idle %d%%\n", frame.payload[1], frame.payload[2],
+			frame.payload[3], frame.payload[0]);
+	}
+
+	// The device's SRAM usage: seven little endian byte counts (see
+	// memmon.h).
+	if (frame_send(fd, REMOTE_CMD_MEMORY, NULL, 0, &stats) &&
+		expect_frame(fd, REMOTE_EVT_MEMORY, &frame, &options, &stats) &&
+		frame.length >= 14)
+	{
+		uint16_t memory[7];
+		for (int i = 0; i < 7; i++)
+		{
+			memory[i] = frame.payload[2 * i] |
+				(frame.payload[2 * i + 1] << 8);
+		}
+		printf("device SRAM: %u of %u bytes static, stack peak %u, "
+			"free min %u\n", memory[1], memory[0], memory[4],
+			memory[6]);
+	}
+
+	if (!options.keep_binary)
+	{
+		(void)frame_send(fd, REMOTE_CMD_EXIT, NULL, 0, &stats);
+	}
+
+	qsort(rtts, num_rtts, sizeof(*rtts), compare_doubles);
+	double rtt_total = 0;
+	for (size_t i = 0; i < num_rtts; i++)
+	{
+		rtt_total += rtts[i];
+	}
+	printf("\n%ld moves in %.3f s: %.1f moves/s\n", total_moves,
+		streaming_time, total_moves / streaming_time);
+	printf("frame round trip (ms): min %.2f  mean %.2f  p50 %.2f  "
+		"p99 %.2f  max %.2f\n", rtts[0] * 1e3,
+		rtt_total / num_rtts * 1e3, rtts[num_rtts / 2] * 1e3,
+		rtts[num_rtts * 99 / 100] * 1e3, rtts[num_rtts - 1] * 1e3);
+	printf("per-move latency (ms): %.3f (frames of up to %d moves)\n",
+		rtt_total / total_moves * 1e3, options.batch);
+	printf("wire: %llu bytes sent, %llu received (%.2f bytes/move), "
+		"%llu CRC errors\n",
+		(unsigned long long)stream_stats.bytes_sent,
+		(unsigned long long)stream_stats.bytes_received,
+		(double)(stream_stats.bytes_sent + stream_stats.bytes_received) /
+		total_moves, (unsigned long long)stats.crc_errors);
+
+	free(rtts);
+	free(solution);
+	close(fd);
+	return 0;
+}
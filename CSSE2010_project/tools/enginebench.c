@@ -0,0 +1,114 @@
+/*
+ * enginebench.c
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Host benchmark of the game engine. Builds the firmware's game.c with only
+ * the null render backend (so nothing is drawn) and runs the same sequence
+ * of moves as the benchmark on the device (see enginebench.h in the
+ * firmware), printing the move rate. Comparing the two shows how much of
+ * the time per move on the device is the engine itself, and how much is
+ * drawing.
+ *
+ * With -v the event recorder is used instead, and the board it rebuilds from
+ * the cell events is checked against the game's board before every restore.
+ * -l picks the level to play (1-based, the device always uses level 1).
+ *
+ * Usage: enginebench [-v] [-l LEVEL] [MOVES]
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "game.h"
+#include "render.h"
+#include "enginebench.h"
+#include "recorder.h"
+
+#define DEFAULT_MOVES	(50000000L)
+
+static double now_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+	bool verify = false;
+	int level = 1;
+	int opt;
+	while ((opt = getopt(argc, argv, "vl:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'v':
+				verify = true;
+				break;
+			case 'l':
+				level = atoi(optarg);
+				break;
+			default:
+				level = 0;
+				break;
+		}
+	}
+	long moves = optind < argc ? atol(argv[optind]) : DEFAULT_MOVES;
+	if (argc - optind > 1 || moves < ENGINE_BENCH_RESTART || level < 1 ||
+		level > get_num_levels())
+	{
+		fprintf(stderr, "usage: enginebench [-v] [-l LEVEL] [MOVES]\n");
+		return 2;
+	}
+	moves -= moves % ENGINE_BENCH_RESTART;
+
+	render_register(verify ? &recorder_backend : &render_null);
+	recorder_reset();
+	initialise_game(level - 1);
+	BoardState start;
+	get_board_state(&start);
+
+	uint16_t sequence = ENGINE_BENCH_SEED;
+	long valid = 0;
+	long differences = 0;
+	double start_time = now_seconds();
+	for (long done = 0; done < moves; done += ENGINE_BENCH_RESTART)
+	{
+		for (int i = 0; i < ENGINE_BENCH_RESTART; i++)
+		{
+			const int8_t *move =
+				engine_bench_moves[engine_bench_next(&sequence)];
+			valid += move_player(move[0], move[1]);
+		}
+		if (verify)
+		{
+			BoardState state;
+			get_board_state(&state);
+			differences += recorder_check(&state);
+		}
+		restore_board_state(&start);
+	}
+	double elapsed = now_seconds() - start_time;
+
+	printf("%ld moves (%ld valid) in %.3f s\n", moves, valid, elapsed);
+	printf("%.0f moves/s, %.1f ns per move\n", moves / elapsed,
+		elapsed * 1e9 / moves);
+	if (!verify)
+	{
+		return 0;
+	}
+
+	const RecorderCounts *counts = recorder_counts();
+	printf("%.2f cell events per move, at most %ld per flush\n",
+		(double)counts->cells / moves, counts->most_cells_per_flush);
+	printf("%ld messages, %ld board resets, %ld flushes\n",
+		counts->statuses[RENDER_STATUS_MESSAGE],
+		counts->statuses[RENDER_STATUS_BOARD_RESET], counts->flushes);
+	printf("%ld squares differed from the game's board\n", differences);
+	return differences != 0;
+}
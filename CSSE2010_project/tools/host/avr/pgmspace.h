@@ -0,0 +1,25 @@
+/*
+ * pgmspace.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Stand-in for avr-libc's <avr/pgmspace.h> so that firmware sources can be
+ * built on the host (see enginebench). The host has a single address space,
+ * so program memory is ordinary memory.
+ */
+
+#ifndef HOST_PGMSPACE_H_
+#define HOST_PGMSPACE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s)	(s)
+#define pgm_read_byte(address)	(*(const uint8_t *)(address))
+#define pgm_read_word(address)	(*(const uint16_t *)(address))
+#define pgm_read_ptr(address)	(*(const void * const *)(address))
+#define memcpy_P(destination, source, length)	\
+	memcpy((destination), (source), (length))
+
+#endif /* HOST_PGMSPACE_H_ */
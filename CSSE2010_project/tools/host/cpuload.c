@@ -0,0 +1,17 @@
+/*
+ * cpuload.c
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Host stand-in for the firmware's CPU load accounting, which render.c
+ * charges drawing to. There is no timestamp counter to read on the host, so
+ * nothing is counted.
+ */
+
+#include "cpuload.h"
+
+CpuActivity cpuload_enter(CpuActivity activity)
+{
+	(void)activity;
+	return CPU_IDLE;
+}
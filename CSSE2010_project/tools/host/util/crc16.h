@@ -0,0 +1,26 @@
+/*
+ * crc16.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Stand-in for avr-libc's <util/crc16.h> so that the firmware's remote.c can
+ * be built on the host (see boardsim). Only the CRC remote.c uses is
+ * provided, computed a bit at a time as avr-libc documents it.
+ */
+
+#ifndef HOST_CRC16_H_
+#define HOST_CRC16_H_
+
+#include <stdint.h>
+
+static inline uint16_t _crc_xmodem_update(uint16_t crc, uint8_t data)
+{
+	crc ^= (uint16_t)data << 8;
+	for (int bit = 0; bit < 8; bit++)
+	{
+		crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+	}
+	return crc;
+}
+
+#endif /* HOST_CRC16_H_ */
@@ -0,0 +1,137 @@
+/*
+ * levelc.c
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Level pack compiler. Reads levels from XSB files, checks each one fits the
+ * firmware (board size, number of boxes, boxes and targets balance, a single
+ * player) and writes them as the level pack header included by game.c. Each
+ * level is kept in whichever encoding of level_format.h takes the least
+ * flash, out of those that look up a square within the decode time budget.
+ * The flash each level takes in every encoding, and the estimated cycles to
+ * look up a square, are printed on stderr.
+ *
+ * A level's par comes from a comment before it (e.g., "; par 36"). Levels
+ * without one are solved with the host solver if they fit its model.
+ *
+ * Usage: levelc [options] OUTPUT.h INPUT.xsb...
+ *   -t CYCLES  most cycles to look up a square (default 200)
+ *   -m NODES   solver node limit, 0 to not solve (default 2000000)
+ *   -j THREADS threads for the solver (default 1)
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include "sokoban.h"
+#include "solver.h"
+#include "levelpack.h"
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: levelc [-t cycles] [-m nodes] [-j threads] "
+		"OUTPUT.h INPUT.xsb...\n");
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	int budget = PACK_DEFAULT_BUDGET;
+	size_t max_nodes = 2000000;
+	int threads = 1;
+	int opt;
+	while ((opt = getopt(argc, argv, "t:m:j:")) != -1)
+	{
+		switch (opt)
+		{
+			case 't':
+				budget = atoi(optarg);
+				break;
+			case 'm':
+				max_nodes = strtoul(optarg, NULL, 10);
+				break;
+			case 'j':
+				threads = atoi(optarg);
+				break;
+			default:
+				usage();
+		}
+	}
+	if (argc - optind < 2)
+	{
+		usage();
+	}
+
+	PackEntry entries[MAX_LEVELS];
+	int count = 0;
+	char source[256] = "tools/levelc from";
+	for (int i = optind + 1; i < argc; i++)
+	{
+		FILE *file = fopen(argv[i], "r");
+		if (file == NULL)
+		{
+			perror(argv[i]);
+			return 1;
+		}
+		snprintf(source + strlen(source), sizeof(source) - strlen(source),
+			"%s %s", i == optind + 1 ? "" : (i == argc - 1 ? " and" : ","),
+			argv[i]);
+
+		int number = 0;
+		PackEntry entry;
+		const char *error;
+		while (pack_read_xsb(file, &entry, &error))
+		{
+			number++;
+			const char *problem = pack_validate(&entry);
+			if (problem != NULL)
+			{
+				fprintf(stderr, "%s: level %d: %s\n", argv[i], number,
+					problem);
+				return 1;
+			}
+			if (count == MAX_LEVELS)
+			{
+				fprintf(stderr, "%s: more than %d levels\n", argv[i],
+					MAX_LEVELS);
+				return 1;
+			}
+
+			Level level;
+			if (entry.par == 0 && max_nodes > 0 &&
+				pack_to_level(&entry, &level))
+			{
+				SolverOptions options = { max_nodes, threads };
+				char *solution;
+				int moves = solve_level(&level, &options, &solution, NULL);
+				free(solution);
+				if (moves == SOLVER_UNSOLVABLE)
+				{
+					fprintf(stderr, "%s: level %d can't be solved\n",
+						argv[i], number);
+					return 1;
+				}
+				entry.par = moves > 0 ? moves : 0;
+			}
+			entries[count++] = entry;
+		}
+		if (error != NULL)
+		{
+			fprintf(stderr, "%s: level %d: %s\n", argv[i], number + 1,
+				error);
+			return 1;
+		}
+		fclose(file);
+	}
+	if (count == 0)
+	{
+		fprintf(stderr, "no levels found\n");
+		return 1;
+	}
+
+	return pack_write(argv[optind], source, entries, count, budget,
+		stderr) ? 0 : 1;
+}
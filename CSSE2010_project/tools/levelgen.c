@@ -0,0 +1,630 @@
+/*
+ * levelgen.c
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Level generator. Each candidate level is built backwards from its solved
+ * state: a random room is laid out (wrapping around at the edges like the
+ * game's board), the boxes are put on random targets and then pulled away
+ * from them by a random walk of reverse moves. Every reverse move can be
+ * undone by a push, so the result can always be solved. Each candidate is
+ * then solved with the host solver, which gives its par (the fewest moves
+ * that solve it), and scored by the length of the solution times the average
+ * number of pushes open to the player at each push along it. The best of a
+ * batch of candidates becomes the next level of the pack.
+ *
+ * Candidates are generated and solved on all cores. Each candidate gets its
+ * own random sequence from the seed and its number, so a seed always gives
+ * the same pack however many threads are used.
+ *
+ * The levels are written as the level pack header included by game.c (see
+ * levelpack.h), after any levels read from an XSB file, and optionally as
+ * XSB for looking at, editing or compiling again with levelc.
+ *
+ * Usage: levelgen [options] OUTPUT.h
+ *   -n LEVELS      levels to generate (default 6)
+ *   -c CANDIDATES  candidates tried for each level (default 64)
+ *   -b BOXES       boxes in each level (default 4)
+ *   -r ROWS        rows in each level, up to 8 (default 8)
+ *   -w COLUMNS     columns in each level, up to 16 (default 16)
+ *   -s SEED        random seed (default from the time)
+ *   -j THREADS     worker threads (default one per core)
+ *   -m NODES       solver node limit per candidate (default 2000000)
+ *   -t CYCLES      most cycles to look up a square (default 200)
+ *   -i FILE        put the levels of FILE (XSB) before the new ones
+ *   -x FILE        also write the new levels to FILE in XSB notation
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "sokoban.h"
+#include "solver.h"
+#include "levelpack.h"
+
+// Chance (in percent) of each square of the outer edge being a wall, and of
+// a wall segment starting at each square inside it. Gaps in the edge let the
+// player and boxes wrap around to the other side.
+#define EDGE_WALL_PERCENT	(70)
+#define WALL_SEED_PERCENT	(8)
+#define MAX_SEGMENT     	(3)
+
+// Number of reverse moves (pulls) made from the solved state, and the chance
+// (in percent) of pulling the same box again if it can be, which makes
+// longer pushes in the solution.
+#define NUM_PULLS       	(400)
+#define SAME_BOX_PERCENT	(60)
+
+// Candidates with fewer floor squares than this per box are too cramped to
+// be interesting.
+#define MIN_FLOOR_PER_BOX	(10)
+
+typedef struct
+{
+	int num_levels;
+	int candidates;
+	int boxes;
+	int rows;
+	int cols;
+	uint64_t seed;
+	int threads;
+	size_t max_nodes;
+	int budget;
+	const char *include_file;
+	const char *xsb_file;
+} Options;
+
+// A generated candidate. score is negative if the candidate was rejected.
+typedef struct
+{
+	Level level;
+	double score;
+	int par;
+	int pushes;
+	double branching;
+} Candidate;
+
+typedef struct
+{
+	const Options *options;
+	Candidate *candidates;
+	int num_candidates;
+	int next;	// Next candidate to generate, taken atomically.
+} Work;
+
+// splitmix64, which is good enough for laying out levels and can be started
+// anywhere in its sequence.
+static uint64_t next_random(uint64_t *state)
+{
+	uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+// Returns a random number from 0 to limit - 1.
+static int random_below(uint64_t *state, int limit)
+{
+	return next_random(state) % limit;
+}
+
+// Finds the squares the player can walk to from start, treating walls and
+// boxes as obstacles. Returns the number found.
+static int reachable(const Level *level, int start, CellSet *seen)
+{
+	uint8_t queue[SOKO_MAX_CELLS];
+	int head = 0;
+	int tail = 0;
+	memset(seen, 0, sizeof(*seen));
+	cellset_add(seen, start);
+	queue[tail++] = start;
+	while (head < tail)
+	{
+		int cell = queue[head++];
+		for (int d = 0; d < SOKO_NUM_DIRECTIONS; d++)
+		{
+			int next = level->neighbour[cell][d];
+			if (cellset_has(seen, next) ||
+				cellset_has(&level->walls, next) ||
+				cellset_has(&level->boxes, next))
+			{
+				continue;
+			}
+			cellset_add(seen, next);
+			queue[tail++] = next;
+		}
+	}
+	return tail;
+}
+
+// Picks a random square from a set.
+static int random_cell(uint64_t *random, const CellSet *set)
+{
+	int count = cellset_count(set);
+	int pick = random_below(random, count);
+	for (int cell = 0; ; cell++)
+	{
+		if (cellset_has(set, cell) && pick-- == 0)
+		{
+			return cell;
+		}
+	}
+}
+
+// Lays out the walls of a room, leaving a single connected floor area.
+// Returns false if the floor area is too small for the boxes.
+static bool make_room(Level *level, const Options *options,
+	uint64_t *random)
+{
+	level_init(level, options->rows, options->cols);
+	int num_cells = options->rows * options->cols;
+	for (int row = 0; row < options->rows; row++)
+	{
+		for (int col = 0; col < options->cols; col++)
+		{
+			bool edge = row == 0 || col == 0 ||
+				row == options->rows - 1 || col == options->cols - 1;
+			if (edge && random_below(random, 100) < EDGE_WALL_PERCENT)
+			{
+				cellset_add(&level->walls, row * options->cols + col);
+			}
+			else if (!edge &&
+				random_below(random, 100) < WALL_SEED_PERCENT)
+			{
+				// A short wall running across or down.
+				int direction = random_below(random, SOKO_NUM_DIRECTIONS);
+				int length = 1 + random_below(random, MAX_SEGMENT);
+				int cell = row * options->cols + col;
+				for (int i = 0; i < length; i++)
+				{
+					cellset_add(&level->walls, cell);
+					cell = level->neighbour[cell][direction];
+				}
+			}
+		}
+	}
+
+	// Keep the floor area around a random square and wall up the rest, so
+	// every floor square can be reached.
+	CellSet floor;
+	memset(&floor, 0, sizeof(floor));
+	for (int cell = 0; cell < num_cells; cell++)
+	{
+		if (!cellset_has(&level->walls, cell))
+		{
+			cellset_add(&floor, cell);
+		}
+	}
+	if (cellset_count(&floor) == 0)
+	{
+		return false;
+	}
+	CellSet area;
+	int area_size = reachable(level, random_cell(random, &floor), &area);
+	for (int cell = 0; cell < num_cells; cell++)
+	{
+		if (!cellset_has(&area, cell))
+		{
+			cellset_add(&level->walls, cell);
+		}
+	}
+	return area_size >= options->boxes * MIN_FLOOR_PER_BOX;
+}
+
+// Tests whether the player can pull a box: it has to be able to walk to the
+// square next to the box on the side in the given direction, and step away
+// from the box in that direction.
+static bool can_pull(const Level *level, const CellSet *area, int box,
+	int direction)
+{
+	int stand = level->neighbour[box][direction];
+	int step = level->neighbour[stand][direction];
+	return cellset_has(area, stand) && !cellset_has(&level->walls, step) &&
+		!cellset_has(&level->boxes, step);
+}
+
+// Pulls the boxes away from their targets with a random walk of pulls.
+static void pull_boxes(Level *level, uint64_t *random)
+{
+	int last_box = -1;
+	for (int i = 0; i < NUM_PULLS; i++)
+	{
+		CellSet area;
+		reachable(level, level->player, &area);
+
+		// List the pulls that can be made, noting those of the box
+		// pulled last.
+		uint16_t pulls[SOKO_MAX_CELLS * SOKO_NUM_DIRECTIONS];
+		int num_pulls = 0;
+		uint16_t same[SOKO_NUM_DIRECTIONS];
+		int num_same = 0;
+		for (int box = 0; box < level->rows * level->cols; box++)
+		{
+			if (!cellset_has(&level->boxes, box))
+			{
+				continue;
+			}
+			for (int d = 0; d < SOKO_NUM_DIRECTIONS; d++)
+			{
+				if (!can_pull(level, &area, box, d))
+				{
+					continue;
+				}
+				pulls[num_pulls++] = box * SOKO_NUM_DIRECTIONS + d;
+				if (box == last_box)
+				{
+					same[num_same++] = box * SOKO_NUM_DIRECTIONS + d;
+				}
+			}
+		}
+		if (num_pulls == 0)
+		{
+			break;
+		}
+		int chosen;
+		if (num_same > 0 && random_below(random, 100) < SAME_BOX_PERCENT)
+		{
+			chosen = same[random_below(random, num_same)];
+		}
+		else
+		{
+			chosen = pulls[random_below(random, num_pulls)];
+		}
+		int box = chosen / SOKO_NUM_DIRECTIONS;
+		int direction = chosen % SOKO_NUM_DIRECTIONS;
+		int stand = level->neighbour[box][direction];
+		cellset_remove(&level->boxes, box);
+		cellset_add(&level->boxes, stand);
+		level->player = level->neighbour[stand][direction];
+		last_box = stand;
+	}
+}
+
+// Counts the pushes open to the player: boxes it can walk up to that have
+// room to move on the far side.
+static int count_pushes(const Level *level)
+{
+	CellSet area;
+	reachable(level, level->player, &area);
+	int count = 0;
+	for (int box = 0; box < level->rows * level->cols; box++)
+	{
+		if (!cellset_has(&level->boxes, box))
+		{
+			continue;
+		}
+		for (int d = 0; d < SOKO_NUM_DIRECTIONS; d++)
+		{
+			int pusher = level->neighbour[box][SOKO_OPPOSITE(d)];
+			int dest = level->neighbour[box][d];
+			if (cellset_has(&area, pusher) &&
+				!cellset_has(&level->walls, dest) &&
+				!cellset_has(&level->boxes, dest))
+			{
+				count++;
+			}
+		}
+	}
+	return count;
+}
+
+// Generates, solves and scores a candidate.
+static void generate(Candidate *candidate, const Options *options,
+	int number)
+{
+	uint64_t random = options->seed * 0x9E3779B97F4A7C15ULL + number;
+	random = next_random(&random);
+	Level *level = &candidate->level;
+	candidate->score = -1;
+	if (!make_room(level, options, &random))
+	{
+		return;
+	}
+
+	// The solved state: boxes on their targets and the player somewhere
+	// else on the floor.
+	CellSet floor;
+	memset(&floor, 0, sizeof(floor));
+	for (int cell = 0; cell < level->rows * level->cols; cell++)
+	{
+		if (!cellset_has(&level->walls, cell))
+		{
+			cellset_add(&floor, cell);
+		}
+	}
+	for (int i = 0; i < options->boxes; i++)
+	{
+		int target = random_cell(&random, &floor);
+		cellset_remove(&floor, target);
+		cellset_add(&level->targets, target);
+		cellset_add(&level->boxes, target);
+	}
+	level->player = random_cell(&random, &floor);
+
+	pull_boxes(level, &random);
+	if (level_is_solved(level))
+	{
+		return;
+	}
+
+	// Any square the player can walk to gives the same level, so start it
+	// somewhere random.
+	CellSet area;
+	reachable(level, level->player, &area);
+	level->player = random_cell(&random, &area);
+
+	// Candidates are solved in parallel with each other, so each solve
+	// takes a single thread.
+	SolverOptions solver_options = { options->max_nodes, 1 };
+	char *solution;
+	int moves = solve_level(level, &solver_options, &solution, NULL);
+	if (moves <= 0)
+	{
+		// Out of nodes (it can always be solved).
+		free(solution);
+		return;
+	}
+
+	// Replay the solution, counting the pushes open before each push.
+	Level replay = *level;
+	int pushes = 0;
+	int choices = 0;
+	for (const char *key = solution; *key; key++)
+	{
+		int direction = soko_direction(*key);
+		int next = replay.neighbour[replay.player][direction];
+		if (cellset_has(&replay.boxes, next))
+		{
+			choices += count_pushes(&replay);
+			pushes++;
+		}
+		level_move(&replay, direction);
+	}
+	free(solution);
+
+	candidate->par = moves;
+	candidate->pushes = pushes;
+	candidate->branching = (double)choices / pushes;
+	candidate->score = moves * candidate->branching;
+}
+
+static void *worker(void *arg)
+{
+	Work *work = arg;
+	while (1)
+	{
+		int number = __atomic_fetch_add(&work->next, 1, __ATOMIC_RELAXED);
+		if (number >= work->num_candidates)
+		{
+			return NULL;
+		}
+		generate(&work->candidates[number], work->options, number);
+	}
+}
+
+// Reads the levels to put before the generated ones. Returns the number
+// read, or -1 on failure.
+static int read_levels(const char *path, PackEntry *entries, int limit)
+{
+	FILE *file = fopen(path, "r");
+	if (file == NULL)
+	{
+		perror(path);
+		return -1;
+	}
+	int count = 0;
+	const char *error;
+	while (count < limit && pack_read_xsb(file, &entries[count], &error))
+	{
+		count++;
+	}
+	fclose(file);
+	if (count == limit)
+	{
+		error = "too many levels";
+	}
+	if (error != NULL)
+	{
+		fprintf(stderr, "%s: level %d: %s\n", path, count + 1, error);
+		return -1;
+	}
+	return count;
+}
+
+static bool write_xsb(const char *path, const PackEntry *entries, int count)
+{
+	FILE *out = fopen(path, "w");
+	if (out == NULL)
+	{
+		perror(path);
+		return false;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		pack_write_xsb(out, &entries[i]);
+		fprintf(out, "\n");
+	}
+	fclose(out);
+	return true;
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: levelgen [-n levels] [-c candidates] "
+		"[-b boxes] [-r rows] [-w columns]\n"
+		"                [-s seed] [-j threads] [-m nodes] [-t cycles]\n"
+		"                [-i FILE.xsb] [-x FILE.xsb] OUTPUT.h\n");
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	Options options = { 6, 64, 4, SOKO_MAX_ROWS, SOKO_MAX_COLS,
+		(uint64_t)time(NULL), (int)sysconf(_SC_NPROCESSORS_ONLN), 2000000,
+		PACK_DEFAULT_BUDGET, NULL, NULL };
+	int opt;
+	while ((opt = getopt(argc, argv, "n:c:b:r:w:s:j:m:t:i:x:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'n':
+				options.num_levels = atoi(optarg);
+				break;
+			case 'c':
+				options.candidates = atoi(optarg);
+				break;
+			case 'b':
+				options.boxes = atoi(optarg);
+				break;
+			case 'r':
+				options.rows = atoi(optarg);
+				break;
+			case 'w':
+				options.cols = atoi(optarg);
+				break;
+			case 's':
+				options.seed = strtoull(optarg, NULL, 10);
+				break;
+			case 'j':
+				options.threads = atoi(optarg);
+				break;
+			case 'm':
+				options.max_nodes = strtoul(optarg, NULL, 10);
+				break;
+			case 't':
+				options.budget = atoi(optarg);
+				break;
+			case 'i':
+				options.include_file = optarg;
+				break;
+			case 'x':
+				options.xsb_file = optarg;
+				break;
+			default:
+				usage();
+		}
+	}
+	if (optind != argc - 1 || options.num_levels < 1 ||
+		options.candidates < 1 || options.boxes < 1 ||
+		options.rows < 3 || options.rows > SOKO_MAX_ROWS ||
+		options.cols < 3 || options.cols > SOKO_MAX_COLS)
+	{
+		usage();
+	}
+	if (options.threads < 1)
+	{
+		options.threads = 1;
+	}
+
+	PackEntry entries[MAX_LEVELS];
+	int num_entries = 0;
+	if (options.include_file)
+	{
+		num_entries = read_levels(options.include_file, entries,
+			MAX_LEVELS);
+		if (num_entries < 0)
+		{
+			return 1;
+		}
+	}
+	if (num_entries + options.num_levels > MAX_LEVELS)
+	{
+		fprintf(stderr, "levelgen: the firmware takes at most %d levels\n",
+			MAX_LEVELS);
+		return 1;
+	}
+
+	Work work = { &options, NULL, options.num_levels * options.candidates,
+		0 };
+	work.candidates = calloc(work.num_candidates, sizeof(Candidate));
+	pthread_t *threads = malloc(options.threads * sizeof(pthread_t));
+	if (work.candidates == NULL || threads == NULL)
+	{
+		fprintf(stderr, "levelgen: out of memory\n");
+		return 1;
+	}
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < options.threads; i++)
+	{
+		pthread_create(&threads[i], NULL, worker, &work);
+	}
+	for (int i = 0; i < options.threads; i++)
+	{
+		pthread_join(threads[i], NULL);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	// The best candidate of each batch, the first one if there's a tie.
+	const Candidate **levels = malloc(options.num_levels * sizeof(*levels));
+	int rejected = 0;
+	for (int i = 0; i < options.num_levels; i++)
+	{
+		levels[i] = NULL;
+		for (int j = 0; j < options.candidates; j++)
+		{
+			const Candidate *candidate =
+				&work.candidates[i * options.candidates + j];
+			if (candidate->score < 0)
+			{
+				rejected++;
+			}
+			else if (levels[i] == NULL ||
+				candidate->score > levels[i]->score)
+			{
+				levels[i] = candidate;
+			}
+		}
+		if (levels[i] == NULL)
+		{
+			fprintf(stderr, "levelgen: no candidate for level %d could be "
+				"used, try more candidates or fewer boxes\n", i + 1);
+			return 1;
+		}
+	}
+
+	PackEntry *generated = &entries[num_entries];
+	for (int i = 0; i < options.num_levels; i++)
+	{
+		char title[64];
+		snprintf(title, sizeof(title), "Seed %llu, candidate %d",
+			(unsigned long long)options.seed,
+			(int)(levels[i] - work.candidates));
+		pack_from_level(&generated[i], &levels[i]->level, levels[i]->par,
+			title);
+	}
+	char source[256];
+	snprintf(source, sizeof(source), "tools/levelgen (seed %llu, best of %d "
+		"candidates for each level)%s%s", (unsigned long long)options.seed,
+		options.candidates, options.include_file ? " after the levels of " :
+		"", options.include_file ? options.include_file : "");
+	if ((options.xsb_file && !write_xsb(options.xsb_file, generated,
+		options.num_levels)) || !pack_write(argv[optind], source, entries,
+		num_entries + options.num_levels, options.budget, stderr))
+	{
+		return 1;
+	}
+
+	double seconds = (end.tv_sec - start.tv_sec) +
+		(end.tv_nsec - start.tv_nsec) * 1e-9;
+	for (int i = 0; i < options.num_levels; i++)
+	{
+		fprintf(stderr, "new level %d: par %d moves, %d pushes, %.1f pushes "
+			"open per push\n", i + 1, levels[i]->par, levels[i]->pushes,
+			levels[i]->branching);
+	}
+	fprintf(stderr, "%d candidates (%d rejected) in %.2f s on %d threads, "
+		"seed %llu\n", work.num_candidates, rejected, seconds,
+		options.threads, (unsigned long long)options.seed);
+
+	free(levels);
+	free(threads);
+	free(work.candidates);
+	return 0;
+}
@@ -0,0 +1,613 @@
+/*
+ * levelpack.c
+ *
+ * Author: Sithika Mannakkara
+ */
+
+#include "levelpack.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+
+// Rough AVR cycle costs used to estimate how long looking up a square takes
+// in each encoding (see level_square() in game.c).
+#define CYCLES_LOOKUP    	(30)	// call, square number and encoding switch
+#define CYCLES_NIBBLE    	(12)	// pgm_read_byte() and pick a nibble
+#define CYCLES_CODE      	(26)	// pgm_read_byte(), variable shift, switch
+#define CYCLES_RUN       	(14)	// one run skipped or found
+#define CYCLES_WALL_BIT  	(20)	// pgm_read_byte() and variable bit test
+#define CYCLES_LIST      	(10)	// start of a square list
+#define CYCLES_LIST_ENTRY	(16)	// one square of a list compared
+
+// Bytes per line of data in the header.
+#define BYTES_PER_LINE	(12)
+
+static const char *const encoding_names[LEVEL_NUM_ENCODINGS] =
+{
+	[LEVEL_NIBBLES] = "LEVEL_NIBBLES",
+	[LEVEL_CODES] = "LEVEL_CODES",
+	[LEVEL_RUNS] = "LEVEL_RUNS",
+	[LEVEL_PLANES] = "LEVEL_PLANES"
+};
+
+// Returns whether a line is part of a board. Lines of nothing but spaces
+// are taken as blank.
+static bool board_line(const char *line)
+{
+	bool solid = false;
+	for (const char *c = line; *c != '\0'; c++)
+	{
+		if (strchr("#@+$*.-_ ", *c) == NULL)
+		{
+			return false;
+		}
+		solid |= *c != ' ';
+	}
+	return solid;
+}
+
+// Takes a title and par from a line before a level.
+static void read_comment(const char *line, PackEntry *entry)
+{
+	while (*line == ';' || isspace((unsigned char)*line))
+	{
+		line++;
+	}
+	if (*line != '\0' && entry->title[0] == '\0')
+	{
+		snprintf(entry->title, sizeof(entry->title), "%s", line);
+	}
+	for (const char *c = line; *c != '\0'; c++)
+	{
+		if ((c == line || !isalpha((unsigned char)c[-1])) &&
+			strncasecmp(c, "par", 3) == 0 &&
+			!isalpha((unsigned char)c[3]))
+		{
+			int par = atoi(c + 3 + strspn(c + 3, " :="));
+			if (par > 0)
+			{
+				entry->par = par;
+			}
+		}
+	}
+}
+
+bool pack_read_xsb(FILE *file, PackEntry *entry, const char **error)
+{
+	char lines[MAP_MAX_ROWS][256];
+	char line[256];
+	int rows = 0;
+	int cols = 0;
+
+	memset(entry, 0, sizeof(*entry));
+	*error = NULL;
+	while (1)
+	{
+		// A line that ends the level may start the next one, so it's
+		// read again next time.
+		long start = ftell(file);
+		if (fgets(line, sizeof(line), file) == NULL)
+		{
+			break;
+		}
+		line[strcspn(line, "\r\n")] = '\0';
+		if (!board_line(line))
+		{
+			if (rows > 0)
+			{
+				fseek(file, start, SEEK_SET);
+				break;
+			}
+
+			// Only the comments just above a level are its own.
+			if (line[strspn(line, " \t")] == '\0')
+			{
+				entry->title[0] = '\0';
+				entry->par = 0;
+			}
+			read_comment(line, entry);
+			continue;
+		}
+		if (rows == MAP_MAX_ROWS)
+		{
+			*error = "too many rows";
+			return false;
+		}
+		int length = strlen(line);
+		if (length > MAP_MAX_COLUMNS)
+		{
+			*error = "too many columns";
+			return false;
+		}
+		if (length > cols)
+		{
+			cols = length;
+		}
+		strcpy(lines[rows++], line);
+	}
+	if (rows == 0)
+	{
+		return false;
+	}
+
+	entry->rows = rows;
+	entry->cols = cols;
+	entry->player_row = -1;
+	for (int row = 0; row < rows; row++)
+	{
+		int length = strlen(lines[row]);
+		for (int col = 0; col < length; col++)
+		{
+			uint8_t *square = &entry->squares[row][col];
+			switch (lines[row][col])
+			{
+				case '#':
+					*square = WALL;
+					break;
+				case '$':
+					*square = BOX;
+					break;
+				case '.':
+					*square = TARGET;
+					break;
+				case '*':
+					*square = BOX | TARGET;
+					break;
+				case '+':
+					*square = TARGET;
+					// Fallthrough.
+				case '@':
+					if (entry->player_row >= 0)
+					{
+						*error = "more than one player";
+						return false;
+					}
+					entry->player_row = row;
+					entry->player_col = col;
+					break;
+				default:
+					break;
+			}
+		}
+	}
+	if (entry->player_row < 0)
+	{
+		*error = "no player";
+		return false;
+	}
+	return true;
+}
+
+void pack_write_xsb(FILE *file, const PackEntry *entry)
+{
+	if (entry->title[0] != '\0')
+	{
+		fprintf(file, "; %s\n", entry->title);
+	}
+	if (entry->par > 0)
+	{
+		fprintf(file, "; par %d\n", entry->par);
+	}
+	for (int row = 0; row < entry->rows; row++)
+	{
+		for (int col = 0; col < entry->cols; col++)
+		{
+			uint8_t square = entry->squares[row][col];
+			bool player = row == entry->player_row &&
+				col == entry->player_col;
+			char c = '-';
+			if (square & WALL)
+			{
+				c = '#';
+			}
+			else if (player)
+			{
+				c = square & TARGET ? '+' : '@';
+			}
+			else if (square & BOX)
+			{
+				c = square & TARGET ? '*' : '$';
+			}
+			else if (square & TARGET)
+			{
+				c = '.';
+			}
+			fputc(c, file);
+		}
+		fputc('\n', file);
+	}
+}
+
+const char *pack_validate(const PackEntry *entry)
+{
+	if (entry->rows < 1 || entry->rows > MAP_MAX_ROWS ||
+		entry->cols < 1 || entry->cols > MAP_MAX_COLUMNS)
+	{
+		return "board size out of range";
+	}
+	int boxes = 0;
+	int targets = 0;
+	for (int row = 0; row < entry->rows; row++)
+	{
+		for (int col = 0; col < entry->cols; col++)
+		{
+			boxes += (entry->squares[row][col] & BOX) != 0;
+			targets += (entry->squares[row][col] & TARGET) != 0;
+		}
+	}
+	if (boxes == 0)
+	{
+		return "no boxes";
+	}
+	if (boxes > MAP_MAX_BOXES)
+	{
+		return "too many boxes";
+	}
+	if (boxes != targets)
+	{
+		return "number of boxes and targets differ";
+	}
+	if (entry->squares[entry->player_row][entry->player_col] & (WALL | BOX))
+	{
+		return "player starts in a wall or box";
+	}
+	return NULL;
+}
+
+void pack_from_level(PackEntry *entry, const Level *level, int par,
+	const char *title)
+{
+	memset(entry, 0, sizeof(*entry));
+	entry->rows = level->rows;
+	entry->cols = level->cols;
+	for (int row = 0; row < level->rows; row++)
+	{
+		for (int col = 0; col < level->cols; col++)
+		{
+			int cell = row * level->cols + col;
+			uint8_t *square = &entry->squares[row][col];
+			*square |= cellset_has(&level->walls, cell) ? WALL : 0;
+			*square |= cellset_has(&level->boxes, cell) ? BOX : 0;
+			*square |= cellset_has(&level->targets, cell) ? TARGET : 0;
+		}
+	}
+	entry->player_row = level->player / level->cols;
+	entry->player_col = level->player % level->cols;
+	entry->par = par;
+	snprintf(entry->title, sizeof(entry->title), "%s", title);
+}
+
+bool pack_to_level(const PackEntry *entry, Level *level)
+{
+	if (entry->rows > SOKO_MAX_ROWS || entry->cols > SOKO_MAX_COLS)
+	{
+		return false;
+	}
+	level_init(level, entry->rows, entry->cols);
+	for (int row = 0; row < entry->rows; row++)
+	{
+		for (int col = 0; col < entry->cols; col++)
+		{
+			int cell = row * entry->cols + col;
+			uint8_t square = entry->squares[row][col];
+			if (square & WALL)
+			{
+				cellset_add(&level->walls, cell);
+			}
+			if (square & BOX)
+			{
+				cellset_add(&level->boxes, cell);
+			}
+			if (square & TARGET)
+			{
+				cellset_add(&level->targets, cell);
+			}
+		}
+	}
+	level->player = entry->player_row * entry->cols + entry->player_col;
+	return true;
+}
+
+// Returns the objects on a square, numbering the squares from the bottom
+// left like the firmware.
+static uint8_t square_at(const PackEntry *entry, int square)
+{
+	int row = entry->rows - 1 - square / entry->cols;
+	return entry->squares[row][square % entry->cols];
+}
+
+// Appends the squares holding an object to a LEVEL_PLANES list.
+static int encode_list(const PackEntry *entry, uint8_t object,
+	uint8_t *data)
+{
+	int length = 1;
+	data[0] = 0;
+	for (int square = 0; square < entry->rows * entry->cols; square++)
+	{
+		if (square_at(entry, square) & object)
+		{
+			data[0]++;
+			data[length++] = square / entry->cols;
+			data[length++] = square % entry->cols;
+		}
+	}
+	return length;
+}
+
+// Encodes a level's squares. Returns the number of bytes written to data,
+// or -1 if the level can't be kept in the encoding.
+static int encode(const PackEntry *entry, int encoding, uint8_t *data)
+{
+	int num_squares = entry->rows * entry->cols;
+	int length = 0;
+	switch (encoding)
+	{
+		case LEVEL_NIBBLES:
+			length = (num_squares + 1) / 2;
+			memset(data, 0, length);
+			for (int square = 0; square < num_squares; square++)
+			{
+				data[square / 2] |= square_at(entry, square) <<
+					(square % 2 * 4);
+			}
+			return length;
+		case LEVEL_CODES:
+			length = (num_squares + 3) / 4;
+			memset(data, 0, length);
+			for (int square = 0; square < num_squares; square++)
+			{
+				int code;
+				switch (square_at(entry, square))
+				{
+					case ROOM:
+						code = LEVEL_CODE_ROOM;
+						break;
+					case WALL:
+						code = LEVEL_CODE_WALL;
+						break;
+					case BOX:
+						code = LEVEL_CODE_BOX;
+						break;
+					case TARGET:
+						code = LEVEL_CODE_TARGET;
+						break;
+					default:
+						return -1;
+				}
+				data[square / 4] |= code << (square % 4 * 2);
+			}
+			return length;
+		case LEVEL_RUNS:
+			for (int square = 0; square < num_squares; )
+			{
+				uint8_t object = square_at(entry, square);
+				int run = 1;
+				while (run < LEVEL_MAX_RUN && square + run < num_squares &&
+					square_at(entry, square + run) == object)
+				{
+					run++;
+				}
+				data[length++] = object << 5 | (run - 1);
+				square += run;
+			}
+			return length;
+		case LEVEL_PLANES:
+			length = (num_squares + 7) / 8;
+			memset(data, 0, length);
+			for (int square = 0; square < num_squares; square++)
+			{
+				if (square_at(entry, square) & WALL)
+				{
+					data[square / 8] |= 1 << (square % 8);
+				}
+			}
+			length += encode_list(entry, TARGET, data + length);
+			length += encode_list(entry, BOX, data + length);
+			return length;
+		default:
+			return -1;
+	}
+}
+
+void pack_costs(const PackEntry *entry, PackCost costs[LEVEL_NUM_ENCODINGS])
+{
+	uint8_t data[MAP_MAX_ROWS * MAP_MAX_COLUMNS];
+	int num_squares = entry->rows * entry->cols;
+	for (int encoding = 0; encoding < LEVEL_NUM_ENCODINGS; encoding++)
+	{
+		costs[encoding].bytes = encode(entry, encoding, data);
+		costs[encoding].usable = costs[encoding].bytes >= 0;
+	}
+
+	// Runs are searched from the start, so a square costs one run for each
+	// run up to and including its own. Only squares outside walls search
+	// the target and box lists.
+	int num_runs = encode(entry, LEVEL_RUNS, data);
+	long run_cycles = 0;
+	for (int run = 0; run < num_runs; run++)
+	{
+		int length = (data[run] & 0x1F) + 1;
+		run_cycles += (long)length * (run + 1) * CYCLES_RUN;
+	}
+	int list_entries = 0;
+	int walls = 0;
+	for (int square = 0; square < num_squares; square++)
+	{
+		uint8_t object = square_at(entry, square);
+		list_entries += (object & BOX) != 0;
+		list_entries += (object & TARGET) != 0;
+		walls += (object & WALL) != 0;
+	}
+	long plane_cycles = (long)num_squares * CYCLES_WALL_BIT +
+		(long)(num_squares - walls) * (2 * CYCLES_LIST +
+		list_entries * CYCLES_LIST_ENTRY);
+
+	costs[LEVEL_NIBBLES].cycles = CYCLES_LOOKUP + CYCLES_NIBBLE;
+	costs[LEVEL_CODES].cycles = CYCLES_LOOKUP + CYCLES_CODE;
+	costs[LEVEL_RUNS].cycles = CYCLES_LOOKUP + run_cycles / num_squares;
+	costs[LEVEL_PLANES].cycles = CYCLES_LOOKUP + plane_cycles / num_squares;
+}
+
+// Picks the encoding taking the least flash within the budget, or returns
+// -1 if there isn't one.
+static int choose_encoding(const PackCost costs[LEVEL_NUM_ENCODINGS],
+	int budget)
+{
+	int best = -1;
+	for (int encoding = 0; encoding < LEVEL_NUM_ENCODINGS; encoding++)
+	{
+		if (costs[encoding].usable && costs[encoding].cycles <= budget &&
+			(best < 0 || costs[encoding].bytes < costs[best].bytes))
+		{
+			best = encoding;
+		}
+	}
+	return best;
+}
+
+// Writes a comment, wrapping it at 80 columns.
+static void write_comment(FILE *out, const char *text)
+{
+	fprintf(out, " *");
+	int column = 2;
+	while (*text != '\0')
+	{
+		int length = strcspn(text, " ");
+		if (column + 1 + length > 79)
+		{
+			fprintf(out, "\n *");
+			column = 2;
+		}
+		fprintf(out, " %.*s", length, text);
+		column += 1 + length;
+		text += length + strspn(text + length, " ");
+	}
+	fprintf(out, "\n");
+}
+
+bool pack_write(const char *path, const char *source,
+	const PackEntry *entries, int count, int budget, FILE *report)
+{
+	int encodings[MAX_LEVELS];
+	PackCost costs[MAX_LEVELS][LEVEL_NUM_ENCODINGS];
+	if (count > MAX_LEVELS)
+	{
+		fprintf(stderr, "%s: %d levels, the firmware takes at most %d\n",
+			path, count, MAX_LEVELS);
+		return false;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		const char *problem = pack_validate(&entries[i]);
+		if (problem != NULL)
+		{
+			fprintf(stderr, "%s: level %d: %s\n", path, i + 1, problem);
+			return false;
+		}
+		pack_costs(&entries[i], costs[i]);
+		encodings[i] = choose_encoding(costs[i], budget);
+		if (encodings[i] < 0)
+		{
+			fprintf(stderr, "%s: level %d can't be looked up in %d cycles "
+				"in any encoding\n", path, i + 1, budget);
+			return false;
+		}
+	}
+
+	FILE *out = fopen(path, "w");
+	if (out == NULL)
+	{
+		perror(path);
+		return false;
+	}
+	char generated[256];
+	snprintf(generated, sizeof(generated), "Generated by %s. Do not edit.",
+		source);
+	fprintf(out, "/*\n * level_pack.h\n *\n");
+	write_comment(out, generated);
+	fprintf(out, " */\n\n"
+		"#ifndef LEVEL_PACK_H_\n#define LEVEL_PACK_H_\n\n"
+		"#include <stdint.h>\n#include <avr/pgmspace.h>\n"
+		"#include \"level_format.h\"\n\n"
+		"#define LEVEL_PACK_SIZE\t(%d)\n\n", count);
+
+	for (int i = 0; i < count; i++)
+	{
+		const PackEntry *entry = &entries[i];
+		const PackCost *cost = &costs[i][encodings[i]];
+		uint8_t data[MAP_MAX_ROWS * MAP_MAX_COLUMNS];
+		int length = encode(entry, encodings[i], data);
+		fprintf(out, "// Level %d%s%.64s\n// %s, %d bytes, about %d cycles to "
+			"look up a square.\nstatic const uint8_t level%d_data[] "
+			"PROGMEM =\n{", i + 1, entry->title[0] ? ": " : "",
+			entry->title, encoding_names[encodings[i]], cost->bytes,
+			cost->cycles, i + 1);
+		for (int byte = 0; byte < length; byte++)
+		{
+			fprintf(out, "%s0x%02X%s", byte % BYTES_PER_LINE ? " " : "\n\t",
+				data[byte], byte < length - 1 ? "," : "\n");
+		}
+		fprintf(out, "};\n\n");
+	}
+
+	// Rows of the player are counted from the bottom in the firmware.
+	fprintf(out, "// Rows, columns, encoding, player row and column, par "
+		"and data.\nstatic const PackedLevel levels[LEVEL_PACK_SIZE] "
+		"PROGMEM =\n{\n");
+	for (int i = 0; i < count; i++)
+	{
+		const PackEntry *entry = &entries[i];
+		fprintf(out, "\t{ %d, %d, %s, %d, %d, %d, level%d_data }%s\n",
+			entry->rows, entry->cols, encoding_names[encodings[i]],
+			entry->rows - 1 - entry->player_row, entry->player_col,
+			entry->par, i + 1, i < count - 1 ? "," : "");
+	}
+	fprintf(out, "};\n\n#endif /* LEVEL_PACK_H_ */\n");
+	fclose(out);
+
+	if (report == NULL)
+	{
+		return true;
+	}
+
+	// The levels used to be kept as text, a byte per square.
+	fprintf(report, "level   size   text nibbles  codes   runs planes  "
+		"(bytes, cycles per square)\n");
+	long text_total = 0;
+	long packed_total = 0;
+	for (int i = 0; i < count; i++)
+	{
+		const PackEntry *entry = &entries[i];
+		int text = entry->rows * entry->cols + 1;
+		fprintf(report, "%5d  %2dx%-2d %6d", i + 1, entry->rows, entry->cols,
+			text);
+		for (int encoding = 0; encoding < LEVEL_NUM_ENCODINGS; encoding++)
+		{
+			const PackCost *cost = &costs[i][encoding];
+			if (cost->usable)
+			{
+				fprintf(report, " %6d", cost->bytes);
+			}
+			else
+			{
+				fprintf(report, "      -");
+			}
+		}
+		fprintf(report, "  %s\n%19s", encoding_names[encodings[i]], "");
+		for (int encoding = 0; encoding < LEVEL_NUM_ENCODINGS; encoding++)
+		{
+			const PackCost *cost = &costs[i][encoding];
+			fprintf(report, cost->usable ? " %6d" : "      -",
+				cost->cycles);
+		}
+		fprintf(report, "\n");
+		text_total += text;
+		packed_total += costs[i][encodings[i]].bytes;
+	}
+	fprintf(report, "level data: %ld -> %ld bytes of flash (budget %d cycles "
+		"per square)\n", text_total, packed_total, budget);
+	return true;
+}
@@ -0,0 +1,103 @@
+/*
+ * levelpack.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Host-side level packs: reading levels from XSB files, checking them
+ * against what the firmware can hold, and writing them as the level pack
+ * header included by game.c (see level_format.h in the firmware). Each level
+ * is written in whichever encoding takes the least flash while still looking
+ * up a square within a budget of (estimated) AVR cycles.
+ *
+ * Unlike the Level of sokoban.h, a pack entry can be as large as the
+ * firmware's maps.
+ */
+
+#ifndef LEVELPACK_H_
+#define LEVELPACK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "sokoban.h"
+#include "game.h"
+#include "level_format.h"
+
+// Default decode time budget, in cycles per square looked up.
+#define PACK_DEFAULT_BUDGET	(200)
+
+// A level of a pack. Rows are numbered from the top, as in XSB files.
+typedef struct
+{
+	int rows;
+	int cols;
+	uint8_t squares[MAP_MAX_ROWS][MAP_MAX_COLUMNS];	// WALL, BOX, TARGET
+	int player_row;
+	int player_col;
+	int par;	// 0 if not known.
+	char title[64];
+} PackEntry;
+
+// What it takes to keep a level in an encoding.
+typedef struct
+{
+	bool usable;	// Whether the level can be kept in the encoding.
+	int bytes;  	// Flash taken by the encoded squares.
+	int cycles; 	// Estimated average cycles to look up a square.
+} PackCost;
+
+/// <summary>
+/// Reads the next level of an XSB file. Lines just above the level (with no
+/// blank line in between) are taken as its title (the first one) and
+/// comments; a comment such as "; par 36" gives the level's par. Lines
+/// shorter than the widest line are padded with floor, and the level ends at
+/// the first line that isn't part of a board.
+/// </summary>
+/// <returns>Whether a level was read. At the end of the file, false is
+/// returned with error set to NULL.</returns>
+bool pack_read_xsb(FILE *file, PackEntry *entry, const char **error);
+
+/// <summary>
+/// Writes a level in XSB notation, after comments giving its title and par.
+/// </summary>
+void pack_write_xsb(FILE *file, const PackEntry *entry);
+
+/// <summary>
+/// Checks a level fits the firmware: the size of its map, the number of
+/// boxes, boxes and targets balance and there is at least one box.
+/// </summary>
+/// <returns>NULL if valid, otherwise a description of the problem.</returns>
+const char *pack_validate(const PackEntry *entry);
+
+/// <summary>
+/// Makes a pack entry from a host level.
+/// </summary>
+void pack_from_level(PackEntry *entry, const Level *level, int par,
+	const char *title);
+
+/// <summary>
+/// Makes a host level (e.g., for the solver) from a pack entry.
+/// </summary>
+/// <returns>False if the level is too large for the host model.</returns>
+bool pack_to_level(const PackEntry *entry, Level *level);
+
+/// <summary>
+/// Works out what it takes to keep a level in each encoding.
+/// </summary>
+/// <param name="costs">Filled in for each LEVEL_* encoding.</param>
+void pack_costs(const PackEntry *entry, PackCost costs[LEVEL_NUM_ENCODINGS]);
+
+/// <summary>
+/// Writes a level pack header. A summary of the flash used by each level in
+/// each encoding is written to report (if not NULL).
+/// </summary>
+/// <param name="path">The header to write.</param>
+/// <param name="source">What the levels were made by or from, for the
+/// comment at the top of the header.</param>
+/// <param name="budget">Most cycles allowed to look up a square.</param>
+/// <returns>Whether the header was written. A level that no encoding can
+/// keep within the budget is reported on stderr.</returns>
+bool pack_write(const char *path, const char *source,
+	const PackEntry *entries, int count, int budget, FILE *report);
+
+#endif /* LEVELPACK_H_ */
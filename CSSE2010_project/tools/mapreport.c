@@ -0,0 +1,436 @@
+/*
+ * mapreport.c
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Memory report from a GNU ld map file (the .map Atmel Studio writes next to
+ * the .elf). Lists the SRAM taken by each object file's initialised (.data)
+ * and zeroed (.bss, .noinit) variables, the flash taken by its code and
+ * program memory constants (.text, .progmem), the largest variables, and the
+ * totals. Library members are listed too, so for example fastfmt.o can be
+ * compared with the vfprintf_std.o that printf_P() pulls in. Given a second
+ * map file, it shows the change from the first to the second, so the effect
+ * of a change on the SRAM and flash budgets can be checked.
+ *
+ * Usage: mapreport BEFORE.map [AFTER.map]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdbool.h>
+
+#define MAX_OBJECTS	(128)
+#define MAX_SYMBOLS	(512)
+#define NAME_LENGTH	(64)
+
+// Number of variables listed when reporting a single map.
+#define TOP_SYMBOLS	(15)
+
+typedef struct
+{
+	char name[NAME_LENGTH];
+	long data;
+	long bss;
+	long flash;	// Excluding the initial values of .data.
+} ObjectUsage;
+
+typedef struct
+{
+	char name[NAME_LENGTH];
+	char object[NAME_LENGTH];
+	unsigned long address;
+	long size;
+} Symbol;
+
+typedef struct
+{
+	ObjectUsage objects[MAX_OBJECTS];
+	int num_objects;
+	Symbol symbols[MAX_SYMBOLS];
+	int num_symbols;
+	long text;
+	long data;
+	long bss;
+	long noinit;
+} MapReport;
+
+// Shortens an object path to its file name (keeping the archive member, e.g.
+// "libc.a(rand.o)").
+static void object_name(const char *path, char *name)
+{
+	const char *start = path;
+	for (const char *p = path; *p; p++)
+	{
+		if (*p == '/' || *p == '\\')
+		{
+			start = p + 1;
+		}
+	}
+	snprintf(name, NAME_LENGTH, "%.*s", NAME_LENGTH - 1, start);
+}
+
+// Turns an input section name such as ".bss.board" or
+// ".rodata.lv1_layout.2396" into a variable name.
+static void symbol_name(const char *section, char *name)
+{
+	const char *prefixes[] = { ".data.", ".bss.", ".rodata.", ".noinit." };
+	const char *start = section;
+	for (size_t i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); i++)
+	{
+		size_t length = strlen(prefixes[i]);
+		if (strncmp(section, prefixes[i], length) == 0)
+		{
+			start = section + length;
+			break;
+		}
+	}
+	snprintf(name, NAME_LENGTH, "%.*s", NAME_LENGTH - 1, start);
+
+	// Drop the number the compiler adds to function-local statics.
+	char *dot = strrchr(name, '.');
+	if (dot && dot[1] && strspn(dot + 1, "0123456789") == strlen(dot + 1))
+	{
+		*dot = '\0';
+	}
+}
+
+static const ObjectUsage *lookup_object(const MapReport *report,
+	const char *name)
+{
+	for (int i = 0; i < report->num_objects; i++)
+	{
+		if (strcmp(report->objects[i].name, name) == 0)
+		{
+			return &report->objects[i];
+		}
+	}
+	return NULL;
+}
+
+static ObjectUsage *find_object(MapReport *report, const char *name)
+{
+	const ObjectUsage *existing = lookup_object(report, name);
+	if (existing != NULL)
+	{
+		return (ObjectUsage *)existing;
+	}
+	if (report->num_objects == MAX_OBJECTS)
+	{
+		fprintf(stderr, "too many object files\n");
+		exit(1);
+	}
+	ObjectUsage *object = &report->objects[report->num_objects++];
+	snprintf(object->name, NAME_LENGTH, "%s", name);
+	object->data = 0;
+	object->bss = 0;
+	object->flash = 0;
+	return object;
+}
+
+static void add_symbol(MapReport *report, const char *name,
+	const char *object, unsigned long address, long size)
+{
+	if (report->num_symbols == MAX_SYMBOLS || size <= 0)
+	{
+		return;
+	}
+	Symbol *symbol = &report->symbols[report->num_symbols++];
+	snprintf(symbol->name, NAME_LENGTH, "%s", name);
+	snprintf(symbol->object, NAME_LENGTH, "%s", object);
+	symbol->address = address;
+	symbol->size = size;
+}
+
+// Reads a map file. Only the .text, .data, .bss and .noinit output sections
+// are looked at. Input sections appear in them as
+//
+//     .bss.board     0x008001c1       0x80 game.o
+//
+// (with the address, size and file on the next line if the name is long),
+// and common symbols as a COMMON block per object file followed by a line
+// with the address and name of each symbol in it. Every input section of
+// .text (code, vectors, program memory constants) is counted as flash.
+static void read_map(const char *path, MapReport *report)
+{
+	FILE *file = fopen(path, "r");
+	if (file == NULL)
+	{
+		perror(path);
+		exit(1);
+	}
+	memset(report, 0, sizeof(*report));
+
+	char line[1024];
+	char section[32] = "";
+	char pending[NAME_LENGTH * 2] = "";
+	char common_object[NAME_LENGTH] = "";
+	unsigned long common_end = 0;
+	Symbol *last_common = NULL;
+	while (fgets(line, sizeof(line), file))
+	{
+		line[strcspn(line, "\r\n")] = '\0';
+
+		// Output section header (starts in the first column).
+		if (line[0] == '.')
+		{
+			char name[32];
+			unsigned long address;
+			long size = 0;
+			int fields = sscanf(line, "%31s %lx %lx", name, &address,
+				&size);
+			snprintf(section, sizeof(section), "%s", name);
+			if (fields == 3)
+			{
+				if (strcmp(name, ".text") == 0)
+				{
+					report->text = size;
+				}
+				else if (strcmp(name, ".data") == 0)
+				{
+					report->data = size;
+				}
+				else if (strcmp(name, ".bss") == 0)
+				{
+					report->bss = size;
+				}
+				else if (strcmp(name, ".noinit") == 0)
+				{
+					report->noinit = size;
+				}
+			}
+			pending[0] = '\0';
+			last_common = NULL;
+			continue;
+		}
+		bool in_ram = strcmp(section, ".data") == 0 ||
+			strcmp(section, ".bss") == 0 ||
+			strcmp(section, ".noinit") == 0;
+		bool in_flash = strcmp(section, ".text") == 0;
+		if ((!in_ram && !in_flash) || line[0] != ' ')
+		{
+			continue;
+		}
+
+		// Symbol lines inside a COMMON block: the previous symbol ends
+		// where this one starts.
+		unsigned long address;
+		char name[NAME_LENGTH * 2];
+		if (last_common != NULL || common_object[0])
+		{
+			if (sscanf(line, " 0x%lx %127s", &address, name) == 2 &&
+				strcmp(name, "PROVIDE") != 0)
+			{
+				if (last_common != NULL)
+				{
+					last_common->size = address -
+						last_common->address;
+				}
+				add_symbol(report, name, common_object, address,
+					common_end - address);
+				last_common = report->num_symbols ?
+					&report->symbols[report->num_symbols - 1] : NULL;
+				continue;
+			}
+			common_object[0] = '\0';
+			last_common = NULL;
+		}
+
+		// Input sections, possibly split over two lines.
+		char first[NAME_LENGTH * 2];
+		long size;
+		char object_path[512];
+		int fields;
+		if (line[1] == '.' || strncmp(line, " COMMON", 7) == 0)
+		{
+			fields = sscanf(line, " %127s 0x%lx 0x%lx %511[^\n]", first,
+				&address, &size, object_path);
+			if (fields == 1)
+			{
+				snprintf(pending, sizeof(pending), "%s", first);
+				continue;
+			}
+		}
+		else if (pending[0])
+		{
+			snprintf(first, sizeof(first), "%s", pending);
+			fields = 1 + sscanf(line, " 0x%lx 0x%lx %511[^\n]",
+				&address, &size, object_path);
+		}
+		else
+		{
+			continue;
+		}
+		pending[0] = '\0';
+		if (fields != 4 || size == 0)
+		{
+			continue;
+		}
+
+		char object[NAME_LENGTH];
+		object_name(object_path, object);
+		ObjectUsage *usage = find_object(report, object);
+		if (in_flash)
+		{
+			usage->flash += size;
+			continue;
+		}
+		if (strcmp(section, ".data") == 0)
+		{
+			usage->data += size;
+		}
+		else
+		{
+			usage->bss += size;
+		}
+
+		if (strcmp(first, "COMMON") == 0)
+		{
+			snprintf(common_object, sizeof(common_object), "%s",
+				object);
+			common_end = address + size;
+			last_common = NULL;
+		}
+		else
+		{
+			symbol_name(first, name);
+			add_symbol(report, name, object, address, size);
+		}
+	}
+	fclose(file);
+}
+
+static long object_total(const MapReport *report, const char *name)
+{
+	const ObjectUsage *object = lookup_object(report, name);
+	return object ? object->data + object->bss : 0;
+}
+
+static long object_flash(const MapReport *report, const char *name)
+{
+	const ObjectUsage *object = lookup_object(report, name);
+	return object ? object->flash : 0;
+}
+
+static long symbol_size(const MapReport *report, const Symbol *symbol)
+{
+	for (int i = 0; i < report->num_symbols; i++)
+	{
+		if (strcmp(report->symbols[i].name, symbol->name) == 0 &&
+			strcmp(report->symbols[i].object, symbol->object) == 0)
+		{
+			return report->symbols[i].size;
+		}
+	}
+	return 0;
+}
+
+static int compare_symbols(const void *a, const void *b)
+{
+	const Symbol *x = a;
+	const Symbol *y = b;
+	return (y->size > x->size) - (y->size < x->size);
+}
+
+static void report_single(MapReport *report)
+{
+	printf("%-28s %6s %6s %6s %6s\n", "object", "data", "bss", "total",
+		"flash");
+	for (int i = 0; i < report->num_objects; i++)
+	{
+		const ObjectUsage *object = &report->objects[i];
+		printf("%-28s %6ld %6ld %6ld %6ld\n", object->name, object->data,
+			object->bss, object->data + object->bss, object->flash);
+	}
+
+	qsort(report->symbols, report->num_symbols, sizeof(Symbol),
+		compare_symbols);
+	printf("\nlargest variables:\n");
+	for (int i = 0; i < report->num_symbols && i < TOP_SYMBOLS; i++)
+	{
+		printf("  %-26s %-20s %6ld\n", report->symbols[i].name,
+			report->symbols[i].object, report->symbols[i].size);
+	}
+}
+
+static void report_change(MapReport *before, MapReport *after)
+{
+	printf("%-28s %7s %7s %7s %7s\n", "object", "before", "after",
+		"change", "flash");
+	for (int i = 0; i < before->num_objects; i++)
+	{
+		const char *name = before->objects[i].name;
+		long old_total = object_total(before, name);
+		long new_total = object_total(after, name);
+		printf("%-28s %7ld %7ld %+7ld %+7ld\n", name, old_total, new_total,
+			new_total - old_total,
+			object_flash(after, name) - object_flash(before, name));
+	}
+	for (int i = 0; i < after->num_objects; i++)
+	{
+		const char *name = after->objects[i].name;
+		if (lookup_object(before, name) == NULL)
+		{
+			long new_total = object_total(after, name);
+			printf("%-28s %7d %7ld %+7ld %+7ld\n", name, 0, new_total,
+				new_total, object_flash(after, name));
+		}
+	}
+
+	printf("\nchanged variables:\n");
+	for (int i = 0; i < before->num_symbols; i++)
+	{
+		const Symbol *symbol = &before->symbols[i];
+		long new_size = symbol_size(after, symbol);
+		if (new_size != symbol->size)
+		{
+			printf("  %-26s %-20s %6ld -> %6ld\n", symbol->name,
+				symbol->object, symbol->size, new_size);
+		}
+	}
+	for (int i = 0; i < after->num_symbols; i++)
+	{
+		const Symbol *symbol = &after->symbols[i];
+		if (symbol_size(before, symbol) == 0)
+		{
+			printf("  %-26s %-20s %6d -> %6ld\n", symbol->name,
+				symbol->object, 0, symbol->size);
+		}
+	}
+}
+
+static void report_totals(const char *label, const MapReport *report)
+{
+	long sram = report->data + report->bss + report->noinit;
+	printf("%s SRAM %ld bytes (data %ld, bss %ld, noinit %ld), "
+		"flash %ld bytes\n", label, sram, report->data, report->bss,
+		report->noinit, report->text + report->data);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc != 2 && argc != 3)
+	{
+		fprintf(stderr, "usage: mapreport BEFORE.map [AFTER.map]\n");
+		return 2;
+	}
+
+	static MapReport before;
+	static MapReport after;
+	read_map(argv[1], &before);
+	if (argc == 2)
+	{
+		report_single(&before);
+		printf("\n");
+		report_totals("total:", &before);
+		return 0;
+	}
+
+	read_map(argv[2], &after);
+	report_change(&before, &after);
+	printf("\n");
+	report_totals("before:", &before);
+	report_totals("after: ", &after);
+	return 0;
+}
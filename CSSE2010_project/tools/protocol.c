@@ -0,0 +1,267 @@
+/*
+ * protocol.c
+ *
+ * Author: Sithika Mannakkara
+ */
+
+#include "protocol.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <asm/termbits.h>
+#include "game.h"
+
+int serial_open(const char *device, unsigned baud)
+{
+	int fd = open(device, O_RDWR | O_NOCTTY);
+	if (fd < 0)
+	{
+		return -1;
+	}
+
+	// termios2 allows any baud rate (BOTHER), which is needed for the
+	// rates the ATmega324A can generate exactly (e.g., 76800, 250000).
+	struct termios2 tio;
+	if (ioctl(fd, TCGETS2, &tio) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+	tio.c_iflag = 0;
+	tio.c_oflag = 0;
+	tio.c_lflag = 0;
+	tio.c_cflag &= ~(CBAUD | CSIZE | PARENB | CSTOPB | CRTSCTS);
+	tio.c_cflag |= BOTHER | CS8 | CREAD | CLOCAL;
+	tio.c_ispeed = baud;
+	tio.c_ospeed = baud;
+	tio.c_cc[VMIN] = 0;
+	tio.c_cc[VTIME] = 0;
+	if (ioctl(fd, TCSETS2, &tio) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+uint16_t crc16_xmodem(uint16_t crc, const uint8_t *data, size_t length)
+{
+	for (size_t i = 0; i < length; i++)
+	{
+		crc ^= (uint16_t)data[i] << 8;
+		for (int bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+		}
+	}
+	return crc;
+}
+
+static bool write_all(int fd, const uint8_t *data, size_t length)
+{
+	while (length > 0)
+	{
+		ssize_t written = write(fd, data, length);
+		if (written < 0)
+		{
+			if (errno == EINTR || errno == EAGAIN)
+			{
+				continue;
+			}
+			return false;
+		}
+		data += written;
+		length -= written;
+	}
+	return true;
+}
+
+bool frame_send(int fd, uint8_t type, const void *payload, uint8_t length,
+	LinkStats *stats)
+{
+	uint8_t buffer[3 + 255 + 2];
+	buffer[0] = REMOTE_SYNC;
+	buffer[1] = length;
+	buffer[2] = type;
+	memcpy(buffer + 3, payload, length);
+	uint16_t crc = crc16_xmodem(0, buffer + 1, length + 2);
+	buffer[3 + length] = crc >> 8;
+	buffer[4 + length] = crc & 0xFF;
+
+	if (!write_all(fd, buffer, length + 5))
+	{
+		return false;
+	}
+	if (stats)
+	{
+		stats->bytes_sent += length + 5;
+		stats->frames_sent++;
+	}
+	return true;
+}
+
+// Reads one byte, waiting up to timeout_ms. Returns -1 on timeout or error.
+static int read_byte(int fd, int timeout_ms, LinkStats *stats)
+{
+	struct pollfd pfd = { .fd = fd, .events = POLLIN };
+	if (poll(&pfd, 1, timeout_ms) <= 0)
+	{
+		return -1;
+	}
+	uint8_t byte;
+	if (read(fd, &byte, 1) != 1)
+	{
+		return -1;
+	}
+	if (stats)
+	{
+		stats->bytes_received++;
+	}
+	return byte;
+}
+
+bool frame_receive(int fd, Frame *frame, int timeout_ms, LinkStats *stats)
+{
+	while (1)
+	{
+		// Skip anything up to the next sync byte (e.g., terminal output
+		// sent before the board switched to binary mode).
+		int byte;
+		do
+		{
+			byte = read_byte(fd, timeout_ms, stats);
+			if (byte < 0)
+			{
+				return false;
+			}
+		} while (byte != REMOTE_SYNC);
+
+		uint8_t header[2];
+		for (int i = 0; i < 2; i++)
+		{
+			if ((byte = read_byte(fd, timeout_ms, stats)) < 0)
+			{
+				return false;
+			}
+			header[i] = byte;
+		}
+		frame->length = header[0];
+		frame->type = header[1];
+		for (int i = 0; i < frame->length + 2; i++)
+		{
+			if ((byte = read_byte(fd, timeout_ms, stats)) < 0)
+			{
+				return false;
+			}
+			if (i < frame->length)
+			{
+				frame->payload[i] = byte;
+			}
+			else
+			{
+				header[i - frame->length] = byte;
+			}
+		}
+
+		uint16_t crc = crc16_xmodem(0, (const uint8_t[]){ frame->length,
+			frame->type }, 2);
+		crc = crc16_xmodem(crc, frame->payload, frame->length);
+		if (crc == ((header[0] << 8) | header[1]))
+		{
+			if (stats)
+			{
+				stats->frames_received++;
+			}
+			return true;
+		}
+		if (stats)
+		{
+			stats->crc_errors++;
+		}
+	}
+}
+
+static uint16_t get_u16(const uint8_t *bytes)
+{
+	return bytes[0] | (bytes[1] << 8);
+}
+
+bool decode_move_result(const Frame *frame, MoveResult *result)
+{
+	if (frame->type != REMOTE_EVT_MOVED || frame->length < 7)
+	{
+		return false;
+	}
+	result->applied = frame->payload[0];
+	result->valid = frame->payload[1];
+	result->moves = get_u16(frame->payload + 2);
+	result->elapsed_time = get_u16(frame->payload + 4);
+	result->game_over = frame->payload[6];
+	return true;
+}
+
+bool decode_state(const Frame *frame, BoardSnapshot *snapshot)
+{
+	if (frame->type != REMOTE_EVT_STATE ||
+		frame->length < BOARD_STATE_SIZE + 5)
+	{
+		return false;
+	}
+	const uint8_t *box_rows = frame->payload;
+	const uint8_t *box_cols = box_rows + BOARD_MAX_BOXES;
+	const uint8_t *rest = box_cols + BOARD_MAX_BOXES;
+	uint8_t num_boxes = rest[0];
+	uint8_t level_number = rest[3];
+	uint8_t rows;
+	uint8_t cols;
+	get_level_size(level_number, &rows, &cols);
+	if (num_boxes > BOARD_MAX_BOXES)
+	{
+		return false;
+	}
+	snapshot->rows = rows;
+	snapshot->cols = cols;
+	snapshot->level_number = level_number;
+	snapshot->moves = get_u16(rest + 4);
+	snapshot->elapsed_time = get_u16(rest + 6);
+	snapshot->game_over = rest[8];
+	snapshot->fits = rows <= SOKO_MAX_ROWS && cols <= SOKO_MAX_COLS;
+	if (!snapshot->fits)
+	{
+		return true;
+	}
+
+	// The firmware's row 0 is the bottom row.
+	Level *level = &snapshot->level;
+	level_init(level, rows, cols);
+	for (int row = 0; row < rows; row++)
+	{
+		int top_row = rows - 1 - row;
+		for (int col = 0; col < cols; col++)
+		{
+			int cell = top_row * cols + col;
+			uint8_t object = get_level_object(level_number, row, col);
+			if (object & WALL)
+			{
+				cellset_add(&level->walls, cell);
+			}
+			if (object & TARGET)
+			{
+				cellset_add(&level->targets, cell);
+			}
+		}
+	}
+	for (int i = 0; i < num_boxes; i++)
+	{
+		cellset_add(&level->boxes,
+			(rows - 1 - box_rows[i]) * cols + box_cols[i]);
+	}
+	level->player = (rows - 1 - rest[1]) * cols + rest[2];
+	return true;
+}
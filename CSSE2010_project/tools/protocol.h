@@ -0,0 +1,123 @@
+/*
+ * protocol.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Host side of the binary remote protocol (see remote.h in the firmware for
+ * the frame format and message definitions), plus opening the serial port.
+ */
+
+#ifndef PROTOCOL_H_
+#define PROTOCOL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sokoban.h"
+
+// These must match remote.h.
+#define REMOTE_SYNC 	(0xA5)
+#define REMOTE_MAX_PAYLOAD	(32)
+
+#define REMOTE_CMD_PING   	(0x01)
+#define REMOTE_CMD_MOVE   	(0x02)
+#define REMOTE_CMD_MOVES  	(0x03)
+#define REMOTE_CMD_QUERY  	(0x04)
+#define REMOTE_CMD_RESTART	(0x05)
+#define REMOTE_CMD_EXIT   	(0x06)
+#define REMOTE_CMD_LOAD   	(0x07)
+#define REMOTE_CMD_MEMORY 	(0x08)
+
+#define REMOTE_EVT_PONG     	(0x81)
+#define REMOTE_EVT_MOVED    	(0x82)
+#define REMOTE_EVT_STATE    	(0x83)
+#define REMOTE_EVT_GAME_OVER	(0x84)
+#define REMOTE_EVT_LOAD     	(0x85)
+#define REMOTE_EVT_MEMORY   	(0x86)
+#define REMOTE_EVT_ERROR    	(0x8F)
+
+// Size of the firmware's BoardState structure (see game.h). It only holds the
+// boxes and the player, the walls and targets are looked up in the level
+// table of the firmware's game.c, which is built in.
+#define BOARD_MAX_BOXES 	(16)
+#define BOARD_STATE_SIZE	(2 * BOARD_MAX_BOXES + 4)
+
+typedef struct
+{
+	uint8_t type;
+	uint8_t length;
+	uint8_t payload[255];
+} Frame;
+
+// Decoded REMOTE_EVT_MOVED payload.
+typedef struct
+{
+	uint8_t applied;
+	uint8_t valid;
+	uint16_t moves;
+	uint16_t elapsed_time;
+	bool game_over;
+} MoveResult;
+
+// Decoded REMOTE_EVT_STATE payload. Levels larger than sokoban.h allows
+// (see fits) have their size but no squares.
+typedef struct
+{
+	Level level;
+	bool fits;
+	uint8_t rows;
+	uint8_t cols;
+	uint8_t level_number;
+	uint16_t moves;
+	uint16_t elapsed_time;
+	bool game_over;
+} BoardSnapshot;
+
+// Byte counters for everything sent and received.
+typedef struct
+{
+	uint64_t bytes_sent;
+	uint64_t bytes_received;
+	uint64_t frames_sent;
+	uint64_t frames_received;
+	uint64_t crc_errors;
+} LinkStats;
+
+/// <summary>
+/// Opens a serial device (or pseudo terminal) in raw mode at any baud rate.
+/// </summary>
+/// <returns>The file descriptor, or -1 on error (errno is set).</returns>
+int serial_open(const char *device, unsigned baud);
+
+/// <summary>
+/// Calculates the CRC-16/XMODEM of a buffer, continuing from crc.
+/// </summary>
+uint16_t crc16_xmodem(uint16_t crc, const uint8_t *data, size_t length);
+
+/// <summary>
+/// Sends a frame.
+/// </summary>
+/// <returns>Whether the frame was written.</returns>
+bool frame_send(int fd, uint8_t type, const void *payload, uint8_t length,
+	LinkStats *stats);
+
+/// <summary>
+/// Receives the next frame with a good CRC, waiting up to timeout_ms.
+/// </summary>
+/// <returns>Whether a frame was received.</returns>
+bool frame_receive(int fd, Frame *frame, int timeout_ms, LinkStats *stats);
+
+/// <summary>
+/// Decodes a REMOTE_EVT_MOVED frame.
+/// </summary>
+bool decode_move_result(const Frame *frame, MoveResult *result);
+
+/// <summary>
+/// Decodes a REMOTE_EVT_STATE frame into a level (in sokoban.h
+/// orientation, i.e. with the firmware's top row as row 0). A level larger
+/// than sokoban.h allows is decoded without its squares, with fits false.
+/// </summary>
+/// <returns>Whether the frame was a valid REMOTE_EVT_STATE.</returns>
+bool decode_state(const Frame *frame, BoardSnapshot *snapshot);
+
+#endif /* PROTOCOL_H_ */
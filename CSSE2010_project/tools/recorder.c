@@ -0,0 +1,93 @@
+/*
+ * recorder.c
+ *
+ * Author: Sithika Mannakkara
+ */
+
+#include "recorder.h"
+#include <stdint.h>
+#include <string.h>
+
+static RecorderCounts counts;
+static long cells_since_flush;
+
+// The board as drawn from the cell events, and the game's map.
+static uint8_t board[MAP_MAX_ROWS][MAP_MAX_COLUMNS];
+static const RenderMap *map;
+static int player_row = -1;
+static int player_col = -1;
+
+static void recorder_cell_changed(uint8_t row, uint8_t col, uint8_t cell)
+{
+	counts.cells++;
+	cells_since_flush++;
+	board[row][col] = cell & RENDER_OBJECT_MASK;
+	if (cell & RENDER_PLAYER)
+	{
+		player_row = row;
+		player_col = col;
+	}
+}
+
+static void recorder_status_changed(RenderStatus status, const void *data)
+{
+	if (status == RENDER_STATUS_BOARD_RESET)
+	{
+		map = data;
+	}
+	if (status < RECORDER_NUM_STATUSES)
+	{
+		counts.statuses[status]++;
+	}
+}
+
+static void recorder_flush(void)
+{
+	counts.flushes++;
+	if (cells_since_flush > counts.most_cells_per_flush)
+	{
+		counts.most_cells_per_flush = cells_since_flush;
+	}
+	cells_since_flush = 0;
+}
+
+const RenderBackend recorder_backend =
+{
+	.cell_changed = recorder_cell_changed,
+	.status_changed = recorder_status_changed,
+	.flush = recorder_flush
+};
+
+void recorder_reset(void)
+{
+	memset(&counts, 0, sizeof(counts));
+	memset(board, 0, sizeof(board));
+	map = NULL;
+	cells_since_flush = 0;
+	player_row = -1;
+	player_col = -1;
+}
+
+const RecorderCounts *recorder_counts(void)
+{
+	return &counts;
+}
+
+int recorder_check(const BoardState *state)
+{
+	if (map == NULL)
+	{
+		return 1;
+	}
+	int differences = 0;
+	for (int row = 0; row < map->rows; row++)
+	{
+		for (int col = 0; col < map->columns; col++)
+		{
+			differences += board[row][col] != map->get_cell(row, col);
+		}
+	}
+	differences += player_row != state->player_row ||
+		player_col != state->player_col;
+	return differences;
+}
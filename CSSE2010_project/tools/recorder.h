@@ -0,0 +1,51 @@
+/*
+ * recorder.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Render backend for host tests (see render.h in the firmware). It counts
+ * the events it is sent and rebuilds the board from the cell events alone,
+ * so the board a backend would draw can be checked against the game's own
+ * board.
+ */
+
+#ifndef RECORDER_H_
+#define RECORDER_H_
+
+#include "game.h"
+#include "render.h"
+
+#define RECORDER_NUM_STATUSES	(RENDER_STATUS_LEVEL_COMPLETE + 1)
+
+typedef struct
+{
+	long cells;
+	long statuses[RECORDER_NUM_STATUSES];
+	long flushes;
+	long most_cells_per_flush;
+} RecorderCounts;
+
+extern const RenderBackend recorder_backend;
+
+/// <summary>
+/// Clears the counts and the rebuilt board.
+/// </summary>
+void recorder_reset(void);
+
+/// <summary>
+/// Gets the event counts since the last reset.
+/// </summary>
+/// <returns>The counts.</returns>
+const RecorderCounts *recorder_counts(void);
+
+/// <summary>
+/// Compares the board rebuilt from the cell events with the game's board
+/// (read through the map given with the last board reset), and the player
+/// location with the one in a BoardState.
+/// </summary>
+/// <param name="state">The game's boxes and player location.</param>
+/// <returns>The number of squares that differ, counting a misplaced player
+/// as one.</returns>
+int recorder_check(const BoardState *state);
+
+#endif /* RECORDER_H_ */
@@ -0,0 +1,256 @@
+/*
+ * sokoban.c
+ *
+ * Author: Sithika Mannakkara
+ */
+
+#include "sokoban.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+static const char direction_keys[SOKO_NUM_DIRECTIONS] = { 'w', 'a', 's', 'd' };
+static const int8_t delta_row[SOKO_NUM_DIRECTIONS] = { -1, 0, 1, 0 };
+static const int8_t delta_col[SOKO_NUM_DIRECTIONS] = { 0, -1, 0, 1 };
+
+void level_init(Level *level, int rows, int cols)
+{
+	memset(level, 0, sizeof(*level));
+	level->rows = rows;
+	level->cols = cols;
+	for (int row = 0; row < rows; row++)
+	{
+		for (int col = 0; col < cols; col++)
+		{
+			for (int d = 0; d < SOKO_NUM_DIRECTIONS; d++)
+			{
+				int r = (row + delta_row[d] + rows) % rows;
+				int c = (col + delta_col[d] + cols) % cols;
+				level->neighbour[row * cols + col][d] = r * cols + c;
+			}
+		}
+	}
+}
+
+bool level_read_xsb(FILE *file, Level *level, const char **error)
+{
+	char lines[SOKO_MAX_ROWS][256];
+	int rows = 0;
+	int cols = 0;
+	char line[256];
+
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		line[strcspn(line, "\r\n")] = '\0';
+
+		// Skip comments and titles (any line that isn't board
+		// characters), and blank lines before the level.
+		bool board_line = line[0] != '\0';
+		for (char *c = line; *c != '\0'; c++)
+		{
+			if (strchr("#@+$*.-_ ", *c) == NULL)
+			{
+				board_line = false;
+				break;
+			}
+		}
+		if (!board_line)
+		{
+			if (rows > 0)
+			{
+				break;
+			}
+			continue;
+		}
+
+		if (rows == SOKO_MAX_ROWS)
+		{
+			*error = "too many rows";
+			return false;
+		}
+		int length = strlen(line);
+		if (length > SOKO_MAX_COLS)
+		{
+			*error = "too many columns";
+			return false;
+		}
+		if (length > cols)
+		{
+			cols = length;
+		}
+		strcpy(lines[rows++], line);
+	}
+	if (rows == 0)
+	{
+		*error = "no level found";
+		return false;
+	}
+
+	level_init(level, rows, cols);
+	bool have_player = false;
+	for (int row = 0; row < rows; row++)
+	{
+		int length = strlen(lines[row]);
+		for (int col = 0; col < length; col++)
+		{
+			int cell = row * cols + col;
+			switch (lines[row][col])
+			{
+				case '#':
+					cellset_add(&level->walls, cell);
+					break;
+				case '$':
+					cellset_add(&level->boxes, cell);
+					break;
+				case '.':
+					cellset_add(&level->targets, cell);
+					break;
+				case '*':
+					cellset_add(&level->boxes, cell);
+					cellset_add(&level->targets, cell);
+					break;
+				case '+':
+					cellset_add(&level->targets, cell);
+					// Fallthrough.
+				case '@':
+					if (have_player)
+					{
+						*error = "more than one player";
+						return false;
+					}
+					level->player = cell;
+					have_player = true;
+					break;
+				default:
+					break;
+			}
+		}
+	}
+	if (!have_player)
+	{
+		*error = "no player";
+		return false;
+	}
+	return true;
+}
+
+void level_write_xsb(FILE *file, const Level *level)
+{
+	for (int row = 0; row < level->rows; row++)
+	{
+		for (int col = 0; col < level->cols; col++)
+		{
+			int cell = row * level->cols + col;
+			bool box = cellset_has(&level->boxes, cell);
+			bool target = cellset_has(&level->targets, cell);
+			char c = '-';
+			if (cellset_has(&level->walls, cell))
+			{
+				c = '#';
+			}
+			else if (cell == level->player)
+			{
+				c = target ? '+' : '@';
+			}
+			else if (box)
+			{
+				c = target ? '*' : '$';
+			}
+			else if (target)
+			{
+				c = '.';
+			}
+			fputc(c, file);
+		}
+		fputc('\n', file);
+	}
+}
+
+const char *level_validate(const Level *level)
+{
+	if (level->rows == 0 || level->rows > SOKO_MAX_ROWS ||
+		level->cols == 0 || level->cols > SOKO_MAX_COLS)
+	{
+		return "board size out of range";
+	}
+	if (level->player >= level->rows * level->cols)
+	{
+		return "player is off the board";
+	}
+	if (cellset_has(&level->walls, level->player) ||
+		cellset_has(&level->boxes, level->player))
+	{
+		return "player starts in a wall or box";
+	}
+	int boxes = cellset_count(&level->boxes);
+	if (boxes == 0)
+	{
+		return "no boxes";
+	}
+	if (boxes != cellset_count(&level->targets))
+	{
+		return "number of boxes and targets differ";
+	}
+	for (int cell = 0; cell < level->rows * level->cols; cell++)
+	{
+		if (cellset_has(&level->walls, cell) &&
+			(cellset_has(&level->boxes, cell) ||
+			cellset_has(&level->targets, cell)))
+		{
+			return "box or target inside a wall";
+		}
+	}
+	return NULL;
+}
+
+int soko_direction(char key)
+{
+	for (int d = 0; d < SOKO_NUM_DIRECTIONS; d++)
+	{
+		if (key == direction_keys[d] || key == direction_keys[d] - 32)
+		{
+			return d;
+		}
+	}
+	return -1;
+}
+
+char soko_key(int direction)
+{
+	return direction_keys[direction];
+}
+
+bool level_move(Level *level, int direction)
+{
+	int next = level->neighbour[level->player][direction];
+	if (cellset_has(&level->walls, next))
+	{
+		return false;
+	}
+	if (cellset_has(&level->boxes, next))
+	{
+		int beyond = level->neighbour[next][direction];
+		if (cellset_has(&level->walls, beyond) ||
+			cellset_has(&level->boxes, beyond))
+		{
+			return false;
+		}
+		cellset_remove(&level->boxes, next);
+		cellset_add(&level->boxes, beyond);
+	}
+	level->player = next;
+	return true;
+}
+
+bool level_is_solved(const Level *level)
+{
+	for (int i = 0; i < SOKO_MAX_CELLS / 64; i++)
+	{
+		if (level->targets.bits[i] & ~level->boxes.bits[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
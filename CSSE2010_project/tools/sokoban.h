@@ -0,0 +1,127 @@
+/*
+ * sokoban.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Host-side model of a level, following the same rules as game.c: the board
+ * wraps around at every edge, the player can push a single box at a time and
+ * the level is complete once every target holds a box. Cells are numbered
+ * row by row from the top left (the same orientation as the level layouts
+ * in game.c, i.e. row 0 is the top row).
+ */
+
+#ifndef SOKOBAN_H_
+#define SOKOBAN_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Size limits, matching the LED matrix.
+#define SOKO_MAX_ROWS 	(8)
+#define SOKO_MAX_COLS 	(16)
+#define SOKO_MAX_CELLS	(SOKO_MAX_ROWS * SOKO_MAX_COLS)
+
+// Directions, in the order of the WASD keys.
+#define SOKO_UP   	(0)
+#define SOKO_LEFT 	(1)
+#define SOKO_DOWN 	(2)
+#define SOKO_RIGHT	(3)
+#define SOKO_NUM_DIRECTIONS	(4)
+
+// Returns the opposite of a direction.
+#define SOKO_OPPOSITE(d)	((d) ^ 2)
+
+// A set of cells, one bit per cell.
+typedef struct
+{
+	uint64_t bits[SOKO_MAX_CELLS / 64];
+} CellSet;
+
+typedef struct
+{
+	uint8_t rows;
+	uint8_t cols;
+	CellSet walls;
+	CellSet targets;
+	CellSet boxes;
+	uint8_t player;
+	// Neighbour of each cell in each direction (with wrap around).
+	uint8_t neighbour[SOKO_MAX_CELLS][SOKO_NUM_DIRECTIONS];
+} Level;
+
+static inline bool cellset_has(const CellSet *set, unsigned cell)
+{
+	return (set->bits[cell >> 6] >> (cell & 63)) & 1;
+}
+
+static inline void cellset_add(CellSet *set, unsigned cell)
+{
+	set->bits[cell >> 6] |= (uint64_t)1 << (cell & 63);
+}
+
+static inline void cellset_remove(CellSet *set, unsigned cell)
+{
+	set->bits[cell >> 6] &= ~((uint64_t)1 << (cell & 63));
+}
+
+static inline bool cellset_equal(const CellSet *a, const CellSet *b)
+{
+	return a->bits[0] == b->bits[0] && a->bits[1] == b->bits[1];
+}
+
+static inline int cellset_count(const CellSet *set)
+{
+	return __builtin_popcountll(set->bits[0]) +
+		__builtin_popcountll(set->bits[1]);
+}
+
+/// <summary>
+/// Sets up an empty level of the given size.
+/// </summary>
+void level_init(Level *level, int rows, int cols);
+
+/// <summary>
+/// Parses a level in XSB notation ('#' wall, '$' box, '.' target, '*' box
+/// on target, '@' player, '+' player on target, ' ', '-' or '_' floor).
+/// Lines shorter than the widest line are padded with floor. Reading stops
+/// at the first blank line after the level, or at end of file.
+/// </summary>
+/// <returns>Whether a level was read. On failure, error is set.</returns>
+bool level_read_xsb(FILE *file, Level *level, const char **error);
+
+/// <summary>
+/// Writes a level in XSB notation.
+/// </summary>
+void level_write_xsb(FILE *file, const Level *level);
+
+/// <summary>
+/// Checks a level is playable: the player is on the board and not in a
+/// wall, boxes and targets balance and there is at least one box.
+/// </summary>
+/// <returns>NULL if valid, otherwise a description of the problem.</returns>
+const char *level_validate(const Level *level);
+
+/// <summary>
+/// Converts a WASD character into a direction.
+/// </summary>
+/// <returns>The direction, or -1 if not a WASD character.</returns>
+int soko_direction(char key);
+
+/// <summary>
+/// Converts a direction into its WASD character.
+/// </summary>
+char soko_key(int direction);
+
+/// <summary>
+/// Moves the player, pushing a box if there is one in the way.
+/// </summary>
+/// <returns>Whether the move was valid.</returns>
+bool level_move(Level *level, int direction);
+
+/// <summary>
+/// Tests whether every target holds a box.
+/// </summary>
+bool level_is_solved(const Level *level);
+
+#endif /* SOKOBAN_H_ */
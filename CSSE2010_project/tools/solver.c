@@ -0,0 +1,1101 @@
+/*
+ * solver.c
+ *
+ * Author: Sithika Mannakkara
+ */
+
+#include "solver.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#define INFINITE_DISTANCE	(0xFFFF)
+#define NO_PARENT       	(UINT32_MAX)
+
+typedef struct
+{
+	CellSet boxes;
+	uint32_t parent;
+	uint16_t g;
+	uint16_t h;
+	uint8_t player;
+	bool closed;
+} Node;
+
+// A list of node indices, used for the open list buckets.
+typedef struct
+{
+	uint32_t *items;
+	size_t count;
+	size_t capacity;
+} NodeList;
+
+typedef struct
+{
+	const Level *level;
+	int num_cells;
+	size_t max_nodes;
+
+	// Push distance from each cell to the nearest target, ignoring other
+	// boxes. INFINITE_DISTANCE for cells a box can never leave.
+	uint16_t target_distance[SOKO_MAX_CELLS];
+
+	// All states seen, and an open addressing hash table of indices into
+	// nodes (plus one, so zero marks an empty slot).
+	Node *nodes;
+	size_t num_nodes;
+	size_t nodes_capacity;
+	uint32_t *table;
+	size_t table_size;
+
+	// Open list, one bucket per f value.
+	NodeList *buckets;
+	size_t num_buckets;
+
+	SolverStats stats;
+} Search;
+
+static void *xrealloc(void *ptr, size_t size)
+{
+	void *result = realloc(ptr, size);
+	if (result == NULL)
+	{
+		fprintf(stderr, "solver: out of memory\n");
+		exit(1);
+	}
+	return result;
+}
+
+static void list_push(NodeList *list, uint32_t item)
+{
+	if (list->count == list->capacity)
+	{
+		list->capacity = list->capacity ? list->capacity * 2 : 64;
+		list->items = xrealloc(list->items,
+			list->capacity * sizeof(*list->items));
+	}
+	list->items[list->count++] = item;
+}
+
+static uint64_t mix64(uint64_t x)
+{
+	x ^= x >> 30;
+	x *= 0xBF58476D1CE4E5B9ULL;
+	x ^= x >> 27;
+	x *= 0x94D049BB133111EBULL;
+	x ^= x >> 31;
+	return x;
+}
+
+static uint64_t state_hash(const CellSet *boxes, uint8_t player)
+{
+	return mix64(boxes->bits[0] ^ mix64(boxes->bits[1] ^ player));
+}
+
+// Calculates the push distance from every cell to its nearest target, by
+// pulling boxes backwards from all targets at once.
+static void compute_target_distances(Search *search)
+{
+	const Level *level = search->level;
+	uint8_t queue[SOKO_MAX_CELLS];
+	int head = 0;
+	int tail = 0;
+
+	for (int cell = 0; cell < search->num_cells; cell++)
+	{
+		search->target_distance[cell] = INFINITE_DISTANCE;
+		if (cellset_has(&level->targets, cell))
+		{
+			search->target_distance[cell] = 0;
+			queue[tail++] = cell;
+		}
+	}
+	while (head < tail)
+	{
+		int cell = queue[head++];
+		for (int d = 0; d < SOKO_NUM_DIRECTIONS; d++)
+		{
+			// A box at cell can be pulled to next if the player has
+			// room to stand beyond it.
+			int next = level->neighbour[cell][d];
+			int player = level->neighbour[next][d];
+			if (cellset_has(&level->walls, next) ||
+				cellset_has(&level->walls, player) ||
+				search->target_distance[next] != INFINITE_DISTANCE)
+			{
+				continue;
+			}
+			search->target_distance[next] =
+				search->target_distance[cell] + 1;
+			queue[tail++] = next;
+		}
+	}
+}
+
+// Returns the heuristic for a set of boxes, or INFINITE_DISTANCE if a box is
+// stuck.
+static uint16_t heuristic(const Search *search, const CellSet *boxes)
+{
+	uint32_t total = 0;
+	for (int word = 0; word < SOKO_MAX_CELLS / 64; word++)
+	{
+		uint64_t bits = boxes->bits[word];
+		while (bits)
+		{
+			int cell = word * 64 + __builtin_ctzll(bits);
+			bits &= bits - 1;
+			if (search->target_distance[cell] == INFINITE_DISTANCE)
+			{
+				return INFINITE_DISTANCE;
+			}
+			total += search->target_distance[cell];
+		}
+	}
+	return total < INFINITE_DISTANCE ? total : INFINITE_DISTANCE;
+}
+
+// Adds a node to the bucket for f of an open list, adding buckets as needed.
+static void buckets_push(NodeList **buckets, size_t *num_buckets, size_t f,
+	uint32_t index)
+{
+	if (f >= *num_buckets)
+	{
+		size_t count = *num_buckets ? *num_buckets : 64;
+		while (count <= f)
+		{
+			count *= 2;
+		}
+		*buckets = xrealloc(*buckets, count * sizeof(**buckets));
+		memset(*buckets + *num_buckets, 0,
+			(count - *num_buckets) * sizeof(**buckets));
+		*num_buckets = count;
+	}
+	list_push(&(*buckets)[f], index);
+}
+
+static void open_push(Search *search, uint32_t index)
+{
+	buckets_push(&search->buckets, &search->num_buckets,
+		search->nodes[index].g + search->nodes[index].h, index);
+}
+
+static void table_grow(Search *search)
+{
+	size_t size = search->table_size ? search->table_size * 2 : 1 << 16;
+	uint32_t *table = calloc(size, sizeof(*table));
+	if (table == NULL)
+	{
+		fprintf(stderr, "solver: out of memory\n");
+		exit(1);
+	}
+	for (size_t i = 0; i < search->num_nodes; i++)
+	{
+		const Node *node = &search->nodes[i];
+		size_t slot = state_hash(&node->boxes, node->player) & (size - 1);
+		while (table[slot])
+		{
+			slot = (slot + 1) & (size - 1);
+		}
+		table[slot] = i + 1;
+	}
+	free(search->table);
+	search->table = table;
+	search->table_size = size;
+}
+
+// Records a state reached with cost g from parent. New states, and known
+// states reached more cheaply than before, are added to the open list.
+// Returns false if the node limit has been reached.
+static bool add_state(Search *search, const CellSet *boxes, uint8_t player,
+	uint16_t g, uint32_t parent)
+{
+	search->stats.tt_lookups++;
+	if (search->num_nodes * 2 >= search->table_size)
+	{
+		table_grow(search);
+	}
+
+	size_t slot = state_hash(boxes, player) & (search->table_size - 1);
+	while (search->table[slot])
+	{
+		uint32_t index = search->table[slot] - 1;
+		Node *node = &search->nodes[index];
+		if (node->player == player && cellset_equal(&node->boxes, boxes))
+		{
+			search->stats.tt_hits++;
+			if (!node->closed && g < node->g)
+			{
+				node->g = g;
+				node->parent = parent;
+				open_push(search, index);
+			}
+			return true;
+		}
+		slot = (slot + 1) & (search->table_size - 1);
+	}
+
+	uint16_t h = heuristic(search, boxes);
+	if (h == INFINITE_DISTANCE)
+	{
+		return true;
+	}
+	if (search->max_nodes && search->num_nodes >= search->max_nodes)
+	{
+		return false;
+	}
+	if (search->num_nodes == search->nodes_capacity)
+	{
+		search->nodes_capacity = search->nodes_capacity ?
+			search->nodes_capacity * 2 : 1 << 16;
+		search->nodes = xrealloc(search->nodes,
+			search->nodes_capacity * sizeof(*search->nodes));
+	}
+	uint32_t index = search->num_nodes++;
+	Node *node = &search->nodes[index];
+	node->boxes = *boxes;
+	node->player = player;
+	node->g = g;
+	node->h = h;
+	node->parent = parent;
+	node->closed = false;
+	search->table[slot] = index + 1;
+	open_push(search, index);
+	return true;
+}
+
+// Finds the walking distance from start to every cell, treating walls and
+// boxes as obstacles. Unreachable cells are set to INFINITE_DISTANCE. If
+// from_direction is not NULL, it is set to the direction taken to reach
+// each cell.
+static void walk_distances(const Level *level, int num_cells,
+	const CellSet *boxes, int start, uint16_t *distance,
+	int8_t *from_direction)
+{
+	uint8_t queue[SOKO_MAX_CELLS];
+	int head = 0;
+	int tail = 0;
+
+	for (int cell = 0; cell < num_cells; cell++)
+	{
+		distance[cell] = INFINITE_DISTANCE;
+	}
+	distance[start] = 0;
+	queue[tail++] = start;
+	while (head < tail)
+	{
+		int cell = queue[head++];
+		for (int d = 0; d < SOKO_NUM_DIRECTIONS; d++)
+		{
+			int next = level->neighbour[cell][d];
+			if (distance[next] != INFINITE_DISTANCE ||
+				cellset_has(&level->walls, next) ||
+				cellset_has(boxes, next))
+			{
+				continue;
+			}
+			distance[next] = distance[cell] + 1;
+			if (from_direction)
+			{
+				from_direction[next] = d;
+			}
+			queue[tail++] = next;
+		}
+	}
+}
+
+// Records a successor state (see add_state()). Returns false if the node
+// limit has been reached.
+typedef bool (*AddStateFunction)(void *context, const CellSet *boxes,
+	uint8_t player, uint16_t g, uint32_t parent);
+
+static bool add_successor(void *context, const CellSet *boxes,
+	uint8_t player, uint16_t g, uint32_t parent)
+{
+	return add_state(context, boxes, player, g, parent);
+}
+
+// Generates the successors of the node at index, passing each to add.
+// Returns false if the node limit has been reached.
+static inline bool expand_node(const Search *search, const Node *node,
+	uint32_t index, SolverStats *stats, AddStateFunction add, void *context)
+{
+	const Level *level = search->level;
+	uint16_t distance[SOKO_MAX_CELLS];
+	walk_distances(level, search->num_cells, &node->boxes, node->player,
+		distance, NULL);
+
+	for (int word = 0; word < SOKO_MAX_CELLS / 64; word++)
+	{
+		uint64_t bits = node->boxes.bits[word];
+		while (bits)
+		{
+			int box = word * 64 + __builtin_ctzll(bits);
+			bits &= bits - 1;
+			for (int d = 0; d < SOKO_NUM_DIRECTIONS; d++)
+			{
+				int pusher = level->neighbour[box][SOKO_OPPOSITE(d)];
+				int dest = level->neighbour[box][d];
+				if (distance[pusher] == INFINITE_DISTANCE ||
+					cellset_has(&level->walls, dest) ||
+					cellset_has(&node->boxes, dest) ||
+					search->target_distance[dest] ==
+					INFINITE_DISTANCE)
+				{
+					continue;
+				}
+				CellSet boxes = node->boxes;
+				cellset_remove(&boxes, box);
+				cellset_add(&boxes, dest);
+				stats->nodes_generated++;
+				if (!add(context, &boxes, box,
+					node->g + distance[pusher] + 1, index))
+				{
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// Generates the successors of a node of the single threaded search.
+static bool expand(Search *search, uint32_t index)
+{
+	// A copy, as adding states may move the nodes.
+	Node node = search->nodes[index];
+	return expand_node(search, &node, index, &search->stats, add_successor,
+		search);
+}
+
+// Appends the moves from the parent state to the child state to solution.
+static char *append_step(const Search *search, const Node *parent,
+	const Node *child, char *solution)
+{
+	const Level *level = search->level;
+	int box = -1;
+	int dest = -1;
+	for (int cell = 0; cell < search->num_cells; cell++)
+	{
+		bool before = cellset_has(&parent->boxes, cell);
+		bool after = cellset_has(&child->boxes, cell);
+		if (before && !after)
+		{
+			box = cell;
+		}
+		else if (!before && after)
+		{
+			dest = cell;
+		}
+	}
+
+	uint16_t distance[SOKO_MAX_CELLS];
+	int8_t from_direction[SOKO_MAX_CELLS];
+	walk_distances(level, search->num_cells, &parent->boxes, parent->player,
+		distance, from_direction);
+
+	for (int d = 0; d < SOKO_NUM_DIRECTIONS; d++)
+	{
+		int pusher = level->neighbour[box][SOKO_OPPOSITE(d)];
+		if (level->neighbour[box][d] != dest ||
+			distance[pusher] == INFINITE_DISTANCE)
+		{
+			continue;
+		}
+
+		// Walk backwards from the pusher to the player to find the
+		// path, then write it out forwards.
+		int length = distance[pusher];
+		int cell = pusher;
+		for (int i = length - 1; i >= 0; i--)
+		{
+			int step = from_direction[cell];
+			solution[i] = soko_key(step);
+			cell = level->neighbour[cell][SOKO_OPPOSITE(step)];
+		}
+		solution[length] = soko_key(d);
+		return solution + length + 1;
+	}
+	return solution;
+}
+
+// Writes out the moves of a path of states from the start to a goal.
+static char *path_solution(const Search *search, const Node *const *path,
+	uint32_t count)
+{
+	char *solution = malloc(path[count - 1]->g + 1);
+	char *end = solution;
+	for (uint32_t n = 1; n < count; n++)
+	{
+		end = append_step(search, path[n - 1], path[n], end);
+	}
+	*end = '\0';
+	return solution;
+}
+
+static char *build_solution(const Search *search, uint32_t goal)
+{
+	uint32_t count = 0;
+	for (uint32_t i = goal; i != NO_PARENT; i = search->nodes[i].parent)
+	{
+		count++;
+	}
+	const Node **path = malloc(count * sizeof(*path));
+	for (uint32_t i = goal, n = count; i != NO_PARENT;
+		i = search->nodes[i].parent)
+	{
+		path[--n] = &search->nodes[i];
+	}
+	char *solution = path_solution(search, path, count);
+	free(path);
+	return solution;
+}
+
+static double now_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// The parallel search.
+//
+// States are expanded a layer of f at a time. A push never lowers f (the
+// heuristic drops by at most one while g rises by at least one), so the
+// states of a layer can be expanded in any order and by any number of
+// threads: each state's g is still optimal when it is expanded, and the
+// first layer holding a solved state gives the fewest moves, as in the
+// single threaded search.
+//
+// Each worker keeps the states it has queued for the current layer in a
+// deque, and those for later layers in buckets of its own. A worker takes
+// from the back of its own deque and, once it runs dry, steals from the
+// front of another worker's. States are kept in a transposition table split
+// into stripes by their hashes, each stripe with its own lock, and nodes
+// are allocated from chunks that never move.
+
+#define NODE_CHUNK_BITS	(16)
+#define NODE_CHUNK_SIZE	(1 << NODE_CHUNK_BITS)
+#define MAX_NODE_CHUNKS	(1 << 15)
+#define STRIPE_BITS    	(8)
+#define NUM_STRIPES    	(1 << STRIPE_BITS)
+#define STEAL_BATCH    	(16)
+
+// A part of the transposition table: an open addressing hash table of node
+// indices plus one, for the states whose hashes' top bits select it.
+typedef struct
+{
+	pthread_mutex_t lock;
+	uint32_t *table;
+	size_t size;
+	size_t count;
+} Stripe;
+
+// A worker's states for the current layer. The worker pushes and pops at
+// the tail, and other workers steal from the head.
+typedef struct
+{
+	pthread_mutex_t lock;
+	uint32_t *items;
+	size_t head;
+	size_t tail;
+	size_t capacity;
+} Deque;
+
+struct Parallel;
+
+typedef struct
+{
+	struct Parallel *parallel;
+	int id;
+	pthread_t thread;
+	Deque deque;
+	NodeList *buckets;
+	size_t num_buckets;
+	uint64_t random;	// For choosing workers to steal from.
+	SolverStats stats;
+} Worker;
+
+typedef struct Parallel
+{
+	// The level, target distances and node limit. Its nodes, table and
+	// open list aren't used.
+	Search search;
+
+	Node *chunks[MAX_NODE_CHUNKS];
+	pthread_mutex_t chunks_lock;
+	uint64_t num_nodes;	// Nodes allocated, taken atomically.
+	Stripe stripes[NUM_STRIPES];
+
+	Worker *workers;
+	int num_workers;
+	pthread_barrier_t barrier;
+
+	// The current layer, which the first worker moves on between layers
+	// while the others wait, and the states queued for it but not yet
+	// expanded.
+	size_t f;
+	bool done;
+	uint64_t pending;
+
+	// Set (atomically) to end the search early.
+	bool stop;
+	bool node_limit;
+	uint32_t goal;
+} Parallel;
+
+static Node *node_at(Parallel *parallel, uint32_t index)
+{
+	Node *chunk = __atomic_load_n(&parallel->chunks[index >> NODE_CHUNK_BITS],
+		__ATOMIC_ACQUIRE);
+	return &chunk[index & (NODE_CHUNK_SIZE - 1)];
+}
+
+// Allocates a node. Returns NO_PARENT if the node limit has been reached.
+static uint32_t node_allocate(Parallel *parallel)
+{
+	uint64_t index = __atomic_fetch_add(&parallel->num_nodes, 1,
+		__ATOMIC_RELAXED);
+	if (index >= (uint64_t)MAX_NODE_CHUNKS * NODE_CHUNK_SIZE ||
+		(parallel->search.max_nodes &&
+		index >= parallel->search.max_nodes))
+	{
+		return NO_PARENT;
+	}
+	Node **chunk = &parallel->chunks[index >> NODE_CHUNK_BITS];
+	if (__atomic_load_n(chunk, __ATOMIC_ACQUIRE) == NULL)
+	{
+		pthread_mutex_lock(&parallel->chunks_lock);
+		if (*chunk == NULL)
+		{
+			__atomic_store_n(chunk,
+				xrealloc(NULL, NODE_CHUNK_SIZE * sizeof(Node)),
+				__ATOMIC_RELEASE);
+		}
+		pthread_mutex_unlock(&parallel->chunks_lock);
+	}
+	return index;
+}
+
+static Stripe *stripe_of(Parallel *parallel, uint64_t hash)
+{
+	return &parallel->stripes[hash >> (64 - STRIPE_BITS)];
+}
+
+// Doubles the size of a stripe's table. The stripe must be locked.
+static void stripe_grow(Parallel *parallel, Stripe *stripe)
+{
+	size_t size = stripe->size ? stripe->size * 2 : 1 << 10;
+	uint32_t *table = calloc(size, sizeof(*table));
+	if (table == NULL)
+	{
+		fprintf(stderr, "solver: out of memory\n");
+		exit(1);
+	}
+	for (size_t i = 0; i < stripe->size; i++)
+	{
+		if (stripe->table[i] == 0)
+		{
+			continue;
+		}
+		const Node *node = node_at(parallel, stripe->table[i] - 1);
+		size_t slot = state_hash(&node->boxes, node->player) & (size - 1);
+		while (table[slot])
+		{
+			slot = (slot + 1) & (size - 1);
+		}
+		table[slot] = stripe->table[i];
+	}
+	free(stripe->table);
+	stripe->table = table;
+	stripe->size = size;
+}
+
+static void deque_push(Deque *deque, uint32_t item)
+{
+	pthread_mutex_lock(&deque->lock);
+	if (deque->tail == deque->capacity)
+	{
+		if (deque->head > 0)
+		{
+			memmove(deque->items, deque->items + deque->head,
+				(deque->tail - deque->head) * sizeof(*deque->items));
+			deque->tail -= deque->head;
+			deque->head = 0;
+		}
+		else
+		{
+			deque->capacity = deque->capacity ? deque->capacity * 2 : 64;
+			deque->items = xrealloc(deque->items,
+				deque->capacity * sizeof(*deque->items));
+		}
+	}
+	deque->items[deque->tail++] = item;
+	pthread_mutex_unlock(&deque->lock);
+}
+
+static bool deque_pop(Deque *deque, uint32_t *item)
+{
+	pthread_mutex_lock(&deque->lock);
+	bool found = deque->head < deque->tail;
+	if (found)
+	{
+		*item = deque->items[--deque->tail];
+	}
+	pthread_mutex_unlock(&deque->lock);
+	return found;
+}
+
+// Takes up to half of the items of a deque (at most max), from the head.
+// Returns the number taken.
+static int deque_steal(Deque *deque, uint32_t *items, int max)
+{
+	pthread_mutex_lock(&deque->lock);
+	size_t count = (deque->tail - deque->head + 1) / 2;
+	if (count > (size_t)max)
+	{
+		count = max;
+	}
+	memcpy(items, deque->items + deque->head, count * sizeof(*items));
+	deque->head += count;
+	pthread_mutex_unlock(&deque->lock);
+	return count;
+}
+
+// Queues a node with the given f: in the worker's deque if it is in the
+// current layer, otherwise in its buckets for later layers.
+static void worker_push(Worker *worker, uint32_t index, size_t f)
+{
+	Parallel *parallel = worker->parallel;
+	if (f == parallel->f)
+	{
+		__atomic_fetch_add(&parallel->pending, 1, __ATOMIC_RELAXED);
+		deque_push(&worker->deque, index);
+	}
+	else
+	{
+		buckets_push(&worker->buckets, &worker->num_buckets, f, index);
+	}
+}
+
+// The parallel counterpart of add_state().
+static bool parallel_add_state(void *context, const CellSet *boxes,
+	uint8_t player, uint16_t g, uint32_t parent)
+{
+	Worker *worker = context;
+	Parallel *parallel = worker->parallel;
+	uint64_t hash = state_hash(boxes, player);
+	Stripe *stripe = stripe_of(parallel, hash);
+	worker->stats.tt_lookups++;
+
+	pthread_mutex_lock(&stripe->lock);
+	if (stripe->count * 2 >= stripe->size)
+	{
+		stripe_grow(parallel, stripe);
+	}
+	size_t slot = hash & (stripe->size - 1);
+	while (stripe->table[slot])
+	{
+		uint32_t index = stripe->table[slot] - 1;
+		Node *node = node_at(parallel, index);
+		if (node->player == player && cellset_equal(&node->boxes, boxes))
+		{
+			worker->stats.tt_hits++;
+			bool reopened = !node->closed && g < node->g;
+			if (reopened)
+			{
+				node->g = g;
+				node->parent = parent;
+			}
+			uint16_t h = node->h;
+			pthread_mutex_unlock(&stripe->lock);
+			if (reopened)
+			{
+				worker_push(worker, index, g + h);
+			}
+			return true;
+		}
+		slot = (slot + 1) & (stripe->size - 1);
+	}
+
+	uint16_t h = heuristic(&parallel->search, boxes);
+	if (h == INFINITE_DISTANCE)
+	{
+		pthread_mutex_unlock(&stripe->lock);
+		return true;
+	}
+	uint32_t index = node_allocate(parallel);
+	if (index == NO_PARENT)
+	{
+		pthread_mutex_unlock(&stripe->lock);
+		return false;
+	}
+	Node *node = node_at(parallel, index);
+	node->boxes = *boxes;
+	node->player = player;
+	node->g = g;
+	node->h = h;
+	node->parent = parent;
+	node->closed = false;
+	stripe->table[slot] = index + 1;
+	stripe->count++;
+	pthread_mutex_unlock(&stripe->lock);
+	worker_push(worker, index, g + h);
+	return true;
+}
+
+// Ends the search early.
+static void parallel_stop(Parallel *parallel)
+{
+	__atomic_store_n(&parallel->stop, true, __ATOMIC_RELAXED);
+}
+
+// Expands a node taken from a deque, unless it has already been expanded
+// or has since been queued with a lower g.
+static void worker_expand(Worker *worker, uint32_t index)
+{
+	Parallel *parallel = worker->parallel;
+	Node *node = node_at(parallel, index);
+	Stripe *stripe = stripe_of(parallel,
+		state_hash(&node->boxes, node->player));
+
+	pthread_mutex_lock(&stripe->lock);
+	bool open = !node->closed && (size_t)node->g + node->h == parallel->f;
+	if (open)
+	{
+		node->closed = true;
+	}
+	Node copy = *node;
+	pthread_mutex_unlock(&stripe->lock);
+	if (!open)
+	{
+		return;
+	}
+	worker->stats.nodes_expanded++;
+
+	if (copy.h == 0)
+	{
+		// All boxes are on targets. Any solved state in this layer
+		// takes the fewest moves.
+		uint32_t none = NO_PARENT;
+		__atomic_compare_exchange_n(&parallel->goal, &none, index, false,
+			__ATOMIC_RELAXED, __ATOMIC_RELAXED);
+		parallel_stop(parallel);
+	}
+	else if (!expand_node(&parallel->search, &copy, index, &worker->stats,
+		parallel_add_state, worker))
+	{
+		__atomic_store_n(&parallel->node_limit, true, __ATOMIC_RELAXED);
+		parallel_stop(parallel);
+	}
+}
+
+// Takes a node from another worker's deque (along with some more, which
+// go in this worker's deque). Returns false if there was nothing to take.
+static bool worker_steal(Worker *worker, uint32_t *index)
+{
+	Parallel *parallel = worker->parallel;
+	uint32_t items[STEAL_BATCH];
+	worker->random = mix64(worker->random + 1);
+	int first = worker->random % parallel->num_workers;
+	for (int i = 0; i < parallel->num_workers; i++)
+	{
+		Worker *victim =
+			&parallel->workers[(first + i) % parallel->num_workers];
+		if (victim == worker)
+		{
+			continue;
+		}
+		int count = deque_steal(&victim->deque, items, STEAL_BATCH);
+		if (count > 0)
+		{
+			for (int j = 1; j < count; j++)
+			{
+				deque_push(&worker->deque, items[j]);
+			}
+			*index = items[0];
+			return true;
+		}
+	}
+	return false;
+}
+
+// Moves on to the next layer: the lowest f any worker has states queued
+// for. Called by the first worker while the others wait.
+static void next_layer(Parallel *parallel)
+{
+	size_t next = SIZE_MAX;
+	for (int i = 0; i < parallel->num_workers; i++)
+	{
+		const Worker *worker = &parallel->workers[i];
+		for (size_t f = parallel->f; f < worker->num_buckets && f < next;
+			f++)
+		{
+			if (worker->buckets[f].count > 0)
+			{
+				next = f;
+			}
+		}
+	}
+	parallel->done = next == SIZE_MAX ||
+		__atomic_load_n(&parallel->stop, __ATOMIC_RELAXED);
+	if (parallel->done)
+	{
+		return;
+	}
+	parallel->f = next;
+	parallel->pending = 0;
+	for (int i = 0; i < parallel->num_workers; i++)
+	{
+		const Worker *worker = &parallel->workers[i];
+		if (next < worker->num_buckets)
+		{
+			parallel->pending += worker->buckets[next].count;
+		}
+	}
+}
+
+static void *worker_run(void *arg)
+{
+	Worker *worker = arg;
+	Parallel *parallel = worker->parallel;
+	for (;;)
+	{
+		pthread_barrier_wait(&parallel->barrier);
+		if (worker->id == 0)
+		{
+			next_layer(parallel);
+		}
+		pthread_barrier_wait(&parallel->barrier);
+		if (parallel->done)
+		{
+			break;
+		}
+
+		// Move this worker's states for the layer to its deque (they
+		// are already counted in pending).
+		if (parallel->f < worker->num_buckets)
+		{
+			NodeList *bucket = &worker->buckets[parallel->f];
+			for (size_t i = 0; i < bucket->count; i++)
+			{
+				deque_push(&worker->deque, bucket->items[i]);
+			}
+			bucket->count = 0;
+		}
+
+		while (__atomic_load_n(&parallel->pending, __ATOMIC_ACQUIRE) > 0 &&
+			!__atomic_load_n(&parallel->stop, __ATOMIC_RELAXED))
+		{
+			uint32_t index;
+			if (!deque_pop(&worker->deque, &index) &&
+				!worker_steal(worker, &index))
+			{
+				// Other workers are still expanding states, which
+				// may add more to this layer.
+				sched_yield();
+				continue;
+			}
+			worker_expand(worker, index);
+			__atomic_fetch_sub(&parallel->pending, 1, __ATOMIC_RELEASE);
+		}
+	}
+	return NULL;
+}
+
+static int solve_parallel(const Level *level, const SolverOptions *options,
+	char **solution, SolverStats *stats)
+{
+	Parallel *parallel = calloc(1, sizeof(*parallel));
+	if (parallel == NULL)
+	{
+		fprintf(stderr, "solver: out of memory\n");
+		exit(1);
+	}
+	Search *search = &parallel->search;
+	search->level = level;
+	search->num_cells = level->rows * level->cols;
+	search->max_nodes = options->max_nodes;
+	*solution = NULL;
+
+	double start = now_seconds();
+	compute_target_distances(search);
+
+	int num_workers = options->threads < SOLVER_MAX_THREADS ?
+		options->threads : SOLVER_MAX_THREADS;
+	parallel->workers = calloc(num_workers, sizeof(Worker));
+	parallel->num_workers = num_workers;
+	parallel->goal = NO_PARENT;
+	pthread_mutex_init(&parallel->chunks_lock, NULL);
+	pthread_barrier_init(&parallel->barrier, NULL, num_workers);
+	for (int i = 0; i < NUM_STRIPES; i++)
+	{
+		pthread_mutex_init(&parallel->stripes[i].lock, NULL);
+	}
+	for (int i = 0; i < num_workers; i++)
+	{
+		Worker *worker = &parallel->workers[i];
+		worker->parallel = parallel;
+		worker->id = i;
+		worker->random = i;
+		pthread_mutex_init(&worker->deque.lock, NULL);
+	}
+
+	// The start goes in the first worker's buckets, with f never equal
+	// to the current layer until the workers have started.
+	parallel->f = SIZE_MAX;
+	(void)parallel_add_state(&parallel->workers[0], &level->boxes,
+		level->player, 0, NO_PARENT);
+	parallel->f = 0;
+
+	for (int i = 1; i < num_workers; i++)
+	{
+		pthread_create(&parallel->workers[i].thread, NULL, worker_run,
+			&parallel->workers[i]);
+	}
+	worker_run(&parallel->workers[0]);
+	for (int i = 1; i < num_workers; i++)
+	{
+		pthread_join(parallel->workers[i].thread, NULL);
+	}
+
+	int result = SOLVER_UNSOLVABLE;
+	if (parallel->goal != NO_PARENT)
+	{
+		uint32_t count = 0;
+		for (uint32_t i = parallel->goal; i != NO_PARENT;
+			i = node_at(parallel, i)->parent)
+		{
+			count++;
+		}
+		const Node **path = malloc(count * sizeof(*path));
+		for (uint32_t i = parallel->goal, n = count; i != NO_PARENT;
+			i = node_at(parallel, i)->parent)
+		{
+			path[--n] = node_at(parallel, i);
+		}
+		*solution = path_solution(search, path, count);
+		result = path[count - 1]->g;
+		free(path);
+	}
+	else if (parallel->node_limit)
+	{
+		result = SOLVER_NODE_LIMIT;
+	}
+
+	SolverStats total;
+	memset(&total, 0, sizeof(total));
+	for (int i = 0; i < num_workers; i++)
+	{
+		Worker *worker = &parallel->workers[i];
+		total.nodes_expanded += worker->stats.nodes_expanded;
+		total.nodes_generated += worker->stats.nodes_generated;
+		total.tt_lookups += worker->stats.tt_lookups;
+		total.tt_hits += worker->stats.tt_hits;
+		for (size_t f = 0; f < worker->num_buckets; f++)
+		{
+			free(worker->buckets[f].items);
+		}
+		free(worker->buckets);
+		free(worker->deque.items);
+		pthread_mutex_destroy(&worker->deque.lock);
+	}
+	for (int i = 0; i < NUM_STRIPES; i++)
+	{
+		total.nodes_stored += parallel->stripes[i].count;
+		free(parallel->stripes[i].table);
+		pthread_mutex_destroy(&parallel->stripes[i].lock);
+	}
+	for (int i = 0; i < MAX_NODE_CHUNKS; i++)
+	{
+		free(parallel->chunks[i]);
+	}
+	total.seconds = now_seconds() - start;
+	if (stats)
+	{
+		*stats = total;
+	}
+
+	pthread_barrier_destroy(&parallel->barrier);
+	pthread_mutex_destroy(&parallel->chunks_lock);
+	free(parallel->workers);
+	free(parallel);
+	return result;
+}
+
+int solve_level(const Level *level, const SolverOptions *options,
+	char **solution, SolverStats *stats)
+{
+	if (options && options->threads > 1)
+	{
+		return solve_parallel(level, options, solution, stats);
+	}
+
+	Search search;
+	memset(&search, 0, sizeof(search));
+	search.level = level;
+	search.num_cells = level->rows * level->cols;
+	search.max_nodes = options ? options->max_nodes : 0;
+	*solution = NULL;
+
+	double start = now_seconds();
+	compute_target_distances(&search);
+
+	int result = SOLVER_UNSOLVABLE;
+	(void)add_state(&search, &level->boxes, level->player, 0, NO_PARENT);
+
+	// Expand states in order of f = g + h. With a consistent heuristic a
+	// state's g is optimal when it is first taken off the open list, so
+	// states already closed (or queued again with a lower g) are skipped.
+	for (size_t f = 0; f < search.num_buckets && result ==
+		SOLVER_UNSOLVABLE; f++)
+	{
+		NodeList *bucket = &search.buckets[f];
+		while (bucket->count > 0)
+		{
+			uint32_t index = bucket->items[--bucket->count];
+			Node *node = &search.nodes[index];
+			if (node->closed || (size_t)node->g + node->h != f)
+			{
+				continue;
+			}
+			node->closed = true;
+			search.stats.nodes_expanded++;
+
+			if (node->h == 0)
+			{
+				// All boxes are on targets.
+				*solution = build_solution(&search, index);
+				result = node->g;
+				break;
+			}
+			if (!expand(&search, index))
+			{
+				result = SOLVER_NODE_LIMIT;
+				break;
+			}
+			// The bucket may have moved if the open list grew.
+			bucket = &search.buckets[f];
+		}
+	}
+
+	search.stats.nodes_stored = search.num_nodes;
+	search.stats.seconds = now_seconds() - start;
+	if (stats)
+	{
+		*stats = search.stats;
+	}
+
+	for (size_t f = 0; f < search.num_buckets; f++)
+	{
+		free(search.buckets[f].items);
+	}
+	free(search.buckets);
+	free(search.nodes);
+	free(search.table);
+	return result;
+}
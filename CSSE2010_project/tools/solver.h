@@ -0,0 +1,68 @@
+/*
+ * solver.h
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Host-side solver which finds a solution with the fewest moves (not
+ * pushes) for a level. The search is A* over push states: each state is the
+ * set of box positions plus the player position after the last push, and
+ * each step walks the player to a box and pushes it once, costing the length
+ * of the walk plus one. The heuristic is the sum of each box's push distance
+ * to its nearest target, which never overestimates and changes by at most
+ * one per push, so the first solution found is optimal. Boxes are never
+ * pushed onto squares from which no target can be reached.
+ *
+ * With more than one thread, the states with the same f = g + h are
+ * expanded in parallel, a value of f at a time, which finds a solution with
+ * the same (fewest) number of moves, though not always the same moves.
+ */
+
+#ifndef SOLVER_H_
+#define SOLVER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sokoban.h"
+
+// Results of solve_level().
+#define SOLVER_UNSOLVABLE	(-1)
+#define SOLVER_NODE_LIMIT	(-2)
+
+// Most threads solve_level() will search with.
+#define SOLVER_MAX_THREADS	(64)
+
+typedef struct
+{
+	// Stop (with SOLVER_NODE_LIMIT) after this many states have been
+	// stored, or 0 for no limit.
+	size_t max_nodes;
+
+	// Threads to search with, or 0 or 1 for a single threaded search.
+	int threads;
+} SolverOptions;
+
+typedef struct
+{
+	uint64_t nodes_expanded;	// States taken off the open list.
+	uint64_t nodes_generated;	// Successor states generated.
+	uint64_t tt_lookups;    	// Transposition table lookups.
+	uint64_t tt_hits;       	// Lookups that found a known state.
+	uint64_t nodes_stored;  	// Distinct states stored.
+	double seconds;         	// Wall clock time taken.
+} SolverStats;
+
+/// <summary>
+/// Solves a level.
+/// </summary>
+/// <param name="level">The level to solve.</param>
+/// <param name="options">Search options, or NULL for the defaults.</param>
+/// <param name="solution">Set to a newly allocated string of WASD moves
+/// (which the caller must free), or NULL if there is no solution.</param>
+/// <param name="stats">Filled in with search statistics (may be NULL).
+/// </param>
+/// <returns>The number of moves in the solution, SOLVER_UNSOLVABLE or
+/// SOLVER_NODE_LIMIT.</returns>
+int solve_level(const Level *level, const SolverOptions *options,
+	char **solution, SolverStats *stats);
+
+#endif /* SOLVER_H_ */
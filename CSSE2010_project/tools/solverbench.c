@@ -0,0 +1,517 @@
+/*
+ * solverbench.c
+ *
+ * Author: Sithika Mannakkara
+ *
+ * Benchmark for the host solver. Solves every level of a fixed corpus (see
+ * levels/corpus.xsb) and writes a CSV line per level with the solution
+ * length, the time taken, the nodes expanded, generated and stored, the
+ * nodes expanded per second, the transposition table hit rate and the peak
+ * resident memory. Each solve runs in a child process of its own, so the
+ * peak memory is that level's alone and one level can't warm up the heap
+ * for the next. With -r, each level is solved several times and the median
+ * time is kept.
+ *
+ * Given a baseline CSV from an earlier run (-c), the results are compared
+ * with it level by level. A level whose solution length has changed is an
+ * error, since the solver must stay optimal; the exit status is then 1.
+ *
+ * With -s, the corpus is solved with 1, 2, 4, ... and finally the given
+ * number of solver threads, and the speedup over a single thread is
+ * reported for each. The CSV (and any comparison) is of the last of these.
+ * Here too, a solution length that differs from the single threaded one is
+ * an error.
+ *
+ * Usage: solverbench [options] [CORPUS.xsb...]
+ *   -r RUNS      solves of each level (default 1)
+ *   -m NODES     solver node limit, 0 for none (default 0)
+ *   -j THREADS   solver threads (default 1)
+ *   -s THREADS   report the speedup from 1 up to THREADS solver threads
+ *   -o FILE      write the CSV to FILE instead of standard output
+ *   -c FILE      compare with the baseline CSV in FILE
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "sokoban.h"
+#include "solver.h"
+#include "levelpack.h"
+
+#define DEFAULT_CORPUS	"levels/corpus.xsb"
+#define MAX_RUNS      	(31)
+#define MAX_RESULTS   	(256)
+#define MAX_THREAD_COUNTS	(16)
+
+// A level of the corpus.
+typedef struct
+{
+	char title[64];
+	Level level;
+} CorpusLevel;
+
+typedef struct
+{
+	char title[64];
+	int moves;
+	double seconds;
+	SolverStats stats;
+	long peak_rss_kb;
+} Result;
+
+// CSV columns, in the order written.
+static const char *const columns[] =
+{
+	"level", "title", "moves", "seconds", "nodes_expanded",
+	"nodes_generated", "nodes_stored", "nodes_per_second", "tt_lookups",
+	"tt_hits", "tt_hit_rate", "peak_rss_kb"
+};
+#define NUM_COLUMNS	(sizeof(columns) / sizeof(columns[0]))
+
+static int compare_doubles(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+// Solves a level in a child process. Returns false if the child failed.
+static bool solve_in_child(const Level *level,
+	const SolverOptions *options, Result *result)
+{
+	int fds[2];
+	if (pipe(fds) != 0)
+	{
+		perror("pipe");
+		return false;
+	}
+	pid_t pid = fork();
+	if (pid < 0)
+	{
+		perror("fork");
+		return false;
+	}
+	if (pid == 0)
+	{
+		close(fds[0]);
+		char *solution;
+		result->moves = solve_level(level, options, &solution,
+			&result->stats);
+		free(solution);
+		ssize_t written = write(fds[1], result, sizeof(*result));
+		_exit(written == sizeof(*result) ? 0 : 1);
+	}
+
+	close(fds[1]);
+	ssize_t length = read(fds[0], result, sizeof(*result));
+	close(fds[0]);
+	int status;
+	struct rusage usage;
+	if (wait4(pid, &status, 0, &usage) < 0 || !WIFEXITED(status) ||
+		WEXITSTATUS(status) != 0 || length != sizeof(*result))
+	{
+		fprintf(stderr, "solverbench: solver process failed\n");
+		return false;
+	}
+	result->seconds = result->stats.seconds;
+	result->peak_rss_kb = usage.ru_maxrss;
+	return true;
+}
+
+// Solves a level runs times, keeping the median time and the highest peak
+// memory. Everything else is the same every time.
+static bool benchmark(const Level *level, int runs,
+	const SolverOptions *options, Result *result)
+{
+	double seconds[MAX_RUNS];
+	long peak_rss_kb = 0;
+	for (int run = 0; run < runs; run++)
+	{
+		if (!solve_in_child(level, options, result))
+		{
+			return false;
+		}
+		seconds[run] = result->seconds;
+		if (result->peak_rss_kb > peak_rss_kb)
+		{
+			peak_rss_kb = result->peak_rss_kb;
+		}
+	}
+	qsort(seconds, runs, sizeof(seconds[0]), compare_doubles);
+	result->seconds = seconds[runs / 2];
+	result->peak_rss_kb = peak_rss_kb;
+	return true;
+}
+
+static double nodes_per_second(const Result *result)
+{
+	return result->seconds > 0 ?
+		result->stats.nodes_expanded / result->seconds : 0;
+}
+
+static double hit_rate(const Result *result)
+{
+	return result->stats.tt_lookups ?
+		(double)result->stats.tt_hits / result->stats.tt_lookups : 0;
+}
+
+static void write_csv(FILE *out, const Result *results, int count)
+{
+	for (size_t i = 0; i < NUM_COLUMNS; i++)
+	{
+		fprintf(out, "%s%s", columns[i], i < NUM_COLUMNS - 1 ? "," : "\n");
+	}
+	for (int i = 0; i < count; i++)
+	{
+		const Result *result = &results[i];
+		const SolverStats *stats = &result->stats;
+		fprintf(out, "%d,\"%s\",%d,%.6f,%llu,%llu,%llu,%.0f,%llu,%llu,"
+			"%.4f,%ld\n", i + 1, result->title, result->moves,
+			result->seconds, (unsigned long long)stats->nodes_expanded,
+			(unsigned long long)stats->nodes_generated,
+			(unsigned long long)stats->nodes_stored,
+			nodes_per_second(result),
+			(unsigned long long)stats->tt_lookups,
+			(unsigned long long)stats->tt_hits, hit_rate(result),
+			result->peak_rss_kb);
+	}
+}
+
+// Splits a CSV line into fields, in place. Fields may be quoted (without
+// quotes inside them). Returns the number of fields.
+static int split_csv(char *line, char **fields, int max_fields)
+{
+	int count = 0;
+	char *c = line;
+	line[strcspn(line, "\r\n")] = '\0';
+	while (count < max_fields)
+	{
+		if (*c == '"')
+		{
+			fields[count++] = ++c;
+			c += strcspn(c, "\"");
+			if (*c == '"')
+			{
+				*c++ = '\0';
+			}
+		}
+		else
+		{
+			fields[count++] = c;
+			c += strcspn(c, ",");
+		}
+		if (*c != ',')
+		{
+			break;
+		}
+		*c++ = '\0';
+	}
+	return count;
+}
+
+// Reads a CSV written by write_csv() (by column name, so columns may be
+// added). Returns the number of results, or -1 on failure.
+static int read_csv(const char *path, Result *results, int max_results)
+{
+	FILE *file = fopen(path, "r");
+	if (file == NULL)
+	{
+		perror(path);
+		return -1;
+	}
+	char line[512];
+	char *fields[32];
+	int index[NUM_COLUMNS];
+	if (fgets(line, sizeof(line), file) == NULL)
+	{
+		fprintf(stderr, "%s: empty\n", path);
+		fclose(file);
+		return -1;
+	}
+	int num_fields = split_csv(line, fields, 32);
+	for (size_t i = 0; i < NUM_COLUMNS; i++)
+	{
+		index[i] = -1;
+		for (int j = 0; j < num_fields; j++)
+		{
+			if (strcmp(fields[j], columns[i]) == 0)
+			{
+				index[i] = j;
+			}
+		}
+		if (index[i] < 0)
+		{
+			fprintf(stderr, "%s: no %s column\n", path, columns[i]);
+			fclose(file);
+			return -1;
+		}
+	}
+
+	int count = 0;
+	while (count < max_results && fgets(line, sizeof(line), file) != NULL)
+	{
+		if (split_csv(line, fields, 32) < num_fields)
+		{
+			continue;
+		}
+		Result *result = &results[count++];
+		memset(result, 0, sizeof(*result));
+		snprintf(result->title, sizeof(result->title), "%s",
+			fields[index[1]]);
+		result->moves = atoi(fields[index[2]]);
+		result->seconds = atof(fields[index[3]]);
+		result->stats.nodes_expanded = strtoull(fields[index[4]], NULL, 10);
+		result->stats.nodes_generated = strtoull(fields[index[5]], NULL,
+			10);
+		result->stats.nodes_stored = strtoull(fields[index[6]], NULL, 10);
+		result->stats.tt_lookups = strtoull(fields[index[8]], NULL, 10);
+		result->stats.tt_hits = strtoull(fields[index[9]], NULL, 10);
+		result->peak_rss_kb = atol(fields[index[11]]);
+	}
+	fclose(file);
+	return count;
+}
+
+// Compares results with a baseline on stderr. Returns false if a solution
+// length has changed.
+static bool compare(const Result *baseline, int baseline_count,
+	const Result *results, int count)
+{
+	bool same_moves = true;
+	double log_speedup = 0;
+	double baseline_seconds = 0;
+	double seconds = 0;
+	int compared = 0;
+	fprintf(stderr, "level  moves  seconds            speedup  "
+		"nodes expanded        peak RSS (KB)\n");
+	for (int i = 0; i < count && i < baseline_count; i++)
+	{
+		const Result *before = &baseline[i];
+		const Result *after = &results[i];
+		if (strcmp(before->title, after->title) != 0)
+		{
+			fprintf(stderr, "%5d  not the baseline's level (\"%s\")\n",
+				i + 1, before->title);
+			continue;
+		}
+		double speedup = after->seconds > 0 ?
+			before->seconds / after->seconds : 1;
+		fprintf(stderr, "%5d  %5d  %7.3f -> %7.3f  %6.2fx  "
+			"%9llu -> %9llu  %6ld -> %6ld%s\n", i + 1, after->moves,
+			before->seconds, after->seconds, speedup,
+			(unsigned long long)before->stats.nodes_expanded,
+			(unsigned long long)after->stats.nodes_expanded,
+			before->peak_rss_kb, after->peak_rss_kb,
+			before->moves != after->moves ? "  SOLUTION LENGTH CHANGED" :
+			"");
+		same_moves &= before->moves == after->moves;
+		log_speedup += log(speedup);
+		baseline_seconds += before->seconds;
+		seconds += after->seconds;
+		compared++;
+	}
+	if (compared > 0)
+	{
+		fprintf(stderr, "total %.3f -> %.3f s, geometric mean speedup "
+			"%.2fx over %d levels\n", baseline_seconds, seconds,
+			exp(log_speedup / compared), compared);
+	}
+	return same_moves;
+}
+
+// Reports the speedup of each number of threads over the first (a single
+// thread) on stderr. Returns false if a solution length differs from the
+// single threaded one.
+static bool report_scaling(const int *thread_counts, int num_counts,
+	Result (*results)[MAX_RESULTS], int count)
+{
+	bool same_moves = true;
+	fprintf(stderr, "threads  seconds  speedup  geometric mean speedup\n");
+	for (int t = 0; t < num_counts; t++)
+	{
+		double seconds = 0;
+		double baseline_seconds = 0;
+		double log_speedup = 0;
+		for (int i = 0; i < count; i++)
+		{
+			const Result *before = &results[0][i];
+			const Result *after = &results[t][i];
+			if (before->moves != after->moves)
+			{
+				fprintf(stderr, "level %d: %d moves with %d threads, %d "
+					"with one\n", i + 1, after->moves, thread_counts[t],
+					before->moves);
+				same_moves = false;
+			}
+			seconds += after->seconds;
+			baseline_seconds += before->seconds;
+			log_speedup += log(after->seconds > 0 ?
+				before->seconds / after->seconds : 1);
+		}
+		fprintf(stderr, "%7d  %7.3f  %6.2fx  %6.2fx\n", thread_counts[t],
+			seconds, seconds > 0 ? baseline_seconds / seconds : 1,
+			count > 0 ? exp(log_speedup / count) : 1);
+	}
+	return same_moves;
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: solverbench [-r runs] [-m nodes] [-j threads] "
+		"[-s threads]\n                   [-o FILE.csv] "
+		"[-c BASELINE.csv] [CORPUS.xsb...]\n");
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	int runs = 1;
+	SolverOptions options = { 0, 1 };
+	int max_threads = 0;
+	const char *output = NULL;
+	const char *baseline_file = NULL;
+	int opt;
+	while ((opt = getopt(argc, argv, "r:m:j:s:o:c:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'r':
+				runs = atoi(optarg);
+				break;
+			case 'm':
+				options.max_nodes = strtoul(optarg, NULL, 10);
+				break;
+			case 'j':
+				options.threads = atoi(optarg);
+				break;
+			case 's':
+				max_threads = atoi(optarg);
+				break;
+			case 'o':
+				output = optarg;
+				break;
+			case 'c':
+				baseline_file = optarg;
+				break;
+			default:
+				usage();
+		}
+	}
+	if (runs < 1 || runs > MAX_RUNS || options.threads < 1 ||
+		max_threads < 0 || max_threads > SOLVER_MAX_THREADS)
+	{
+		usage();
+	}
+
+	static CorpusLevel corpus_levels[MAX_RESULTS];
+	int count = 0;
+	char *default_corpus[] = { DEFAULT_CORPUS };
+	char **corpus = optind < argc ? argv + optind : default_corpus;
+	int num_files = optind < argc ? argc - optind : 1;
+	for (int i = 0; i < num_files; i++)
+	{
+		FILE *file = fopen(corpus[i], "r");
+		if (file == NULL)
+		{
+			perror(corpus[i]);
+			return 1;
+		}
+		PackEntry entry;
+		const char *error;
+		while (count < MAX_RESULTS && pack_read_xsb(file, &entry, &error))
+		{
+			CorpusLevel *corpus_level = &corpus_levels[count++];
+			if (!pack_to_level(&entry, &corpus_level->level))
+			{
+				fprintf(stderr, "%s: \"%s\" is too large for the solver\n",
+					corpus[i], entry.title);
+				return 1;
+			}
+			snprintf(corpus_level->title, sizeof(corpus_level->title),
+				"%s", entry.title);
+		}
+		fclose(file);
+		if (error != NULL)
+		{
+			fprintf(stderr, "%s: %s\n", corpus[i], error);
+			return 1;
+		}
+	}
+
+	// The numbers of threads to solve with: just -j's, or 1, 2, 4, ... up
+	// to -s's.
+	int thread_counts[MAX_THREAD_COUNTS];
+	int num_counts = 0;
+	if (max_threads == 0)
+	{
+		thread_counts[num_counts++] = options.threads;
+	}
+	else
+	{
+		for (int threads = 1; threads < max_threads; threads *= 2)
+		{
+			thread_counts[num_counts++] = threads;
+		}
+		thread_counts[num_counts++] = max_threads;
+	}
+
+	static Result results[MAX_THREAD_COUNTS][MAX_RESULTS];
+	for (int t = 0; t < num_counts; t++)
+	{
+		options.threads = thread_counts[t];
+		for (int i = 0; i < count; i++)
+		{
+			Result *result = &results[t][i];
+			if (!benchmark(&corpus_levels[i].level, runs, &options, result))
+			{
+				return 1;
+			}
+			snprintf(result->title, sizeof(result->title), "%s",
+				corpus_levels[i].title);
+			fprintf(stderr, "%d: %d moves in %.3f s", i + 1, result->moves,
+				result->seconds);
+			if (max_threads > 0)
+			{
+				fprintf(stderr, " with %d threads", options.threads);
+			}
+			fprintf(stderr, "\n");
+		}
+	}
+	const Result *last = results[num_counts - 1];
+
+	FILE *out = output ? fopen(output, "w") : stdout;
+	if (out == NULL)
+	{
+		perror(output);
+		return 1;
+	}
+	write_csv(out, last, count);
+	if (output)
+	{
+		fclose(out);
+	}
+
+	bool ok = true;
+	if (num_counts > 1)
+	{
+		ok &= report_scaling(thread_counts, num_counts, results, count);
+	}
+	if (baseline_file)
+	{
+		static Result baseline[MAX_RESULTS];
+		int baseline_count = read_csv(baseline_file, baseline,
+			MAX_RESULTS);
+		if (baseline_count < 0)
+		{
+			return 1;
+		}
+		ok &= compare(baseline, baseline_count, last, count);
+	}
+	return ok ? 0 : 1;
+}